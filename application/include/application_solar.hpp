@@ -5,16 +5,51 @@
 #include "model.hpp"
 #include "structs.hpp"
 #include "Timer.hpp"
+#include "SceneUpdater.hpp"
+#include "RenderQueue.hpp"
+#include "UniformBuffer.hpp"
+#include "GeometryArena.hpp"
+#include "StreamBuffer.hpp"
 #include <map>
 #include <string>
+#include <vector>
 using std::map;
 using std::string;
+using std::vector;
+
+// per draw data of the multi draw shaders, read as instance attributes, the layout is set up in initializeGeometry
+struct DrawInstance {
+	glm::fmat4 modelMatrix;
+	glm::fmat3 normalMatrix; // inverse transpose of the model matrix
+	float textureLayer;
+	float ambientStrength;
+};
+
+// per frame data read by all shaders, std140 layout of the FrameData block in resources/shaders
+struct FrameData {
+	glm::fmat4 viewMatrix;
+	glm::fmat4 projectionMatrix;
+	glm::fvec4 cameraPosition; // vec3 in the block, std140 aligns it to 16 bytes
+	glm::fvec4 lightPosition;
+	glm::fvec4 lightColor;
+	glm::fvec4 ambientColor;
+};
+
+// procedurally generated scene which replaces the solar system, e.g. for benchmarks
+struct GeneratedScene {
+	unsigned systems = 1; // suns with their planets, laid out on a square grid
+	unsigned planets = 8; // per system
+	unsigned moons = 1; // per body on every level below the planets
+	unsigned depth = 2; // levels of bodies around a sun: 1 planets only, 2 with moons, 3 with moons of moons ...
+	unsigned stars = 3000; // background star points
+	unsigned seed = 1; // of sizes, distances and start angles
+};
 
 // gpu representation of model
 class ApplicationSolar : public Application {
 	public:
-		// allocate and initialize objects
-		ApplicationSolar(std::string const& resource_path);
+		// allocate and initialize objects, the solar system or a generated scene
+		ApplicationSolar(std::string const& resource_path, GeneratedScene const* generatedScene = nullptr);
 		// free allocated objects
 		~ApplicationSolar();
 		// react to key input
@@ -23,19 +58,49 @@ class ApplicationSolar : public Application {
 		void mouseCallback(double pos_x, double pos_y);
 		//handle resizing
 		void resizeCallback(unsigned width, unsigned height);
+		// animate scene and collect draw data, runs on the scene updater's threads
+		void update();
 		// draw all objects
 		void render() const;
+		// GL draw calls of the last render(), an instanced batch counts once
+		unsigned getDrawCalls() const;
+		// triangles drawn by the last render(), fewer with levels of detail
+		size_t getDrawnTriangles() const;
+		// levels of detail of the planets, on by default
+		void setLodEnabled(bool isLodEnabled);
+		// culling of the last update()
+		SceneUpdater::CullStatistics getCullStatistics() const;
+		// distance of the farthest body from the origin
+		float getSceneRadius() const;
 
 	private:
 		// initialize scenegraph's hierarchy object
 		void initializeSceneGraph();
+		// systems of suns, planets and moons, replaces initializeSceneGraph
+		void initializeGeneratedScene(GeneratedScene const& parameters);
 		// setup camera node
 		void initializeCamera(glm::fmat4 camInitialTransform, glm::fmat4 camInitialProjection);
+		// setup planet rotation, called for every node by the scene updater
+		void initializeAnimation();
 		void initializeFrameBuffer(unsigned width, unsigned height);
+		// add asteroids on random orbits between mars and jupiter, to test drawing many planets
+		void addAsteroidBelt(unsigned count);
+		// upload per draw data of a batch and draw it with one multi draw indirect call, returns the GL draw calls
+		unsigned drawMultiIndirect(vector<DrawRef> const& batch) const;
 		void offScreenRender() const;
 		void renderScreenTextureToQuadObject() const;
 		// timer class
 		mutable Timer _timer;
+		// per frame scene update, splits the scenegraph over worker threads
+		SceneUpdater _sceneUpdater;
+		float _rotationAngle; // rotation of the planet holders in the current frame
+		// draw calls of the current frame sorted by GL state
+		mutable RenderQueue _renderQueue;
+		// camera and light data of all programs, one update per change
+		mutable UniformBuffer _frameDataBuffer;
+		// per frame instance records, indirect commands and frame data, written into persistently mapped memory
+		mutable StreamBuffer _streamBuffer;
+		bool _enableStreaming;
 		// key=shader name, value=file name
 		map<string, string> _shaderList;
 		bool _isRotating;
@@ -44,14 +109,30 @@ class ApplicationSolar : public Application {
 		bool _enableVericallMirror;
 		bool _enableBlur;
 		bool _enableGrayscale;
+		bool _enableMultiDraw; // draw batches of programs with a multi draw variant with one call
 		unsigned int _fbo; // frame buffer object
 		unsigned int _rbo; // render buffer object
 		unsigned int _screenTexture; // texture
+		// all static meshes in one vertex and index buffer, so every draw shares one vertex array
+		mutable GeometryArena _geometryArena;
+		map<string, string> _multiDrawShaders; // key=shader name, value=its variant reading per draw data from DrawInstance
+		mutable vector<DrawInstance> _drawInstances;
+		mutable vector<DrawElementsIndirectCommand> _drawCommands;
+		mutable vector<glm::fmat4> _instanceModelMatrices;
+		mutable vector<glm::fmat4> _instanceNormalMatrices;
+		map<string, texture_object> _planetTextures; // layers of the planet array texture by planet name
+		unsigned _asteroidCount;
+		unsigned _starCount; // points of the star geometry
+		float _sceneRadius;
+		mutable unsigned _drawCalls;
+		mutable size_t _drawnTriangles;
+		GeometryNode* _pickedNode; // planet in the screen center, updated when the view changes
 
 	protected:
 		void initializeShaderPrograms();
 		void initializeGeometry();
-		texture_object initializeTexture(const string& textureFile);
+		// load textures into layers of one array texture, so planets can share it in one instanced draw
+		texture_object initializeTextureArray(vector<string> const& textureFiles);
 		texture_object initializeCubemapTexture();
 		// update uniform values
 		void uploadUniforms();
@@ -59,9 +140,11 @@ class ApplicationSolar : public Application {
 		void uploadProjection();
 		// upload view matrix
 		void uploadView();
+		// update the frame data buffer from camera and light, skipped when they did not change
+		void uploadFrameData() const;
 
 		// cpu representation of model
-		model_object _planetObject;
+		vector<model_object> _planetLods; // levels of detail of the planet sphere, the full mesh first
 		model_object _starObject;
 		model_object _orbitObject;
 		model_object _skyboxObject;
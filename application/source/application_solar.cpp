@@ -3,6 +3,7 @@
 #include "utils.hpp"
 #include "shader_loader.hpp"
 #include "model_loader.hpp"
+#include "vertex_packing.hpp"
 #include "texture_loader.hpp"
 #include <glbinding/gl/gl.h>
 using namespace gl; // use gl definitions from glbinding 
@@ -14,16 +15,24 @@ using namespace gl; // use gl definitions from glbinding
 #include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <cstddef>
+#include <cmath>
 #include <memory>
 #include <array>
 #include <map>
 #include <vector>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <set>
 #include "SceneGraph.hpp"
 #include "Node.hpp"
 #include "PointLightNode.hpp"
 #include "GeometryNode.hpp"
 #include "Timer.hpp"
 #include "CameraNode.hpp"
+#include "simd_math.hpp"
+#include "Profiler.hpp"
 using glm::fvec3;
 using glm::radians;
 using glm::fmat4;
@@ -33,19 +42,37 @@ using glm::translate;
 using std::map;
 using std::array;
 using std::vector;
-using std::shared_ptr;
-using std::make_shared;
-using std::dynamic_pointer_cast;
 
 auto const COLOR_COMPONENTS = 3;
 auto const POSITION_COMPONENTS = 3;
 auto const STAR_POSITION_RANGE = 2.0f;
 auto const COLOR_MAX_VALUE = 255;
 auto const TWO_PI = 2.0f * 3.14159265358979323846f;
-
-ApplicationSolar::ApplicationSolar(std::string const& resource_path)
+auto const PICK_DISTANCE = 1000.0f;
+
+// uniform buffer binding point of the FrameData block, the same in every program
+static const GLuint FRAME_DATA_BINDING = 0;
+// bytes of per frame data in one region of the stream buffer at start, it grows when a frame needs more
+static const size_t STREAM_REGION_SIZE = 1 << 20;
+// triangle budgets of the planets' levels of detail, the sphere itself has about 4000
+static const vector<size_t> PLANET_LOD_TRIANGLES = { 1024, 256, 64 };
+
+// uniform handles, the locations of every program are found by reflection when it is linked
+static const UniformHandle NORMAL_MATRIX = ShaderUniforms::getHandle("NormalMatrix");
+static const UniformHandle MODEL_MATRIX = ShaderUniforms::getHandle("ModelMatrix");
+static const UniformHandle AMBIENT_STRENGTH = ShaderUniforms::getHandle("AmbientStrength");
+static const UniformHandle ENABLE_TOON_SHADING = ShaderUniforms::getHandle("EnableToonShading");
+static const UniformHandle TEXTURE = ShaderUniforms::getHandle("Texture");
+static const UniformHandle TEXTURE_LAYER = ShaderUniforms::getHandle("TextureLayer");
+static const UniformHandle SCREEN_TEXTURE = ShaderUniforms::getHandle("ScreenTexture");
+static const UniformHandle ENABLE_HORIZONTAL_MIRROR = ShaderUniforms::getHandle("EnableHorizontalMirror");
+static const UniformHandle ENABLE_VERTICAL_MIRROR = ShaderUniforms::getHandle("EnableVerticalMirror");
+static const UniformHandle ENABLE_BLUR = ShaderUniforms::getHandle("EnableBlur");
+static const UniformHandle ENABLE_GRAYSCALE = ShaderUniforms::getHandle("EnableGrayscale");
+
+ApplicationSolar::ApplicationSolar(std::string const& resource_path, GeneratedScene const* generatedScene)
     : Application{resource_path}
-    , _planetObject{}
+    , _planetLods{}
     , _starObject{}
     , _orbitObject{}
     , _skyboxObject{}
@@ -53,27 +80,51 @@ ApplicationSolar::ApplicationSolar(std::string const& resource_path)
     , m_view_transform{glm::translate(glm::fmat4{}, glm::fvec3{0.0f, 0.0f, 20.0f})}
     , m_view_projection{utils::calculate_projection_matrix(initial_aspect_ratio)}
     , _timer{}
-    , _shaderList{ {"planetShader", "simple"}, {"starShader", "vao"}, {"orbitShader", "orbit"}, {"skyboxShader", "skybox"}, {"quadShader", "quad"} }
+    , _sceneUpdater{}
+    , _rotationAngle{0.0f}
+    , _frameDataBuffer{FRAME_DATA_BINDING, sizeof(FrameData)}
+    , _streamBuffer{STREAM_REGION_SIZE}
+    , _enableStreaming{true}
+    , _shaderList{ {"planetShader", "simple"}, {"planetInstancedShader", "simple_instanced"}, {"starShader", "star"}, {"orbitShader", "orbit"}, {"orbitInstancedShader", "orbit_instanced"}, {"skyboxShader", "skybox"}, {"quadShader", "quad"} }
     , _isRotating{true}
     , _enableToonShading{false}
     , _enableHorizontalMirror{ false }
     , _enableVericallMirror{ false }
     , _enableBlur{ false }
     , _enableGrayscale{ false }
+    , _enableMultiDraw{ true }
+    , _geometryArena{}
+    , _multiDrawShaders{ {"planetShader", "planetInstancedShader"}, {"orbitShader", "orbitInstancedShader"} }
+    , _asteroidCount{ 0 }
+    , _starCount{ generatedScene ? generatedScene->stars : 3000u }
+    , _sceneRadius{ 0.0f }
+    , _drawCalls{ 0 }
+    , _drawnTriangles{ 0 }
+    , _pickedNode{ nullptr }
 {
     // Initialization order is matter
+    ShaderUniforms::setBlockBinding("FrameData", FRAME_DATA_BINDING); // applied whenever shaders are (re)linked
+    _frameDataBuffer.setStreamBuffer(&_streamBuffer);
+    _geometryArena.setStreamBuffer(&_streamBuffer);
     initializeGeometry();
     initializeShaderPrograms();
-    initializeSceneGraph();
+    if (generatedScene) {
+        initializeGeneratedScene(*generatedScene);
+    }
+    else {
+        initializeSceneGraph();
+    }
     initializeCamera(m_view_transform, m_view_projection);
+    initializeAnimation();
+    SceneGraph::getInstance().updateWorldTransforms(); // world transforms must be valid before first uniform upload
     initializeFrameBuffer(initial_resolution.x, initial_resolution.y);
-    SceneGraph::getInstance().printGraph(); // When all initialization are done, print SceneGraph to console
+    _sceneUpdater.setViewportHeight(initial_resolution.y);
+    if (!generatedScene) {
+        SceneGraph::getInstance().printGraph(); // When all initialization are done, print SceneGraph to console
+    }
 }
 
 ApplicationSolar::~ApplicationSolar() {
-  glDeleteBuffers(1, &_planetObject.vertex_BO);
-  glDeleteBuffers(1, &_planetObject.element_BO);
-  glDeleteVertexArrays(1, &_planetObject.vertex_AO);
   glDeleteFramebuffers(1, &_fbo);
   glDeleteRenderbuffers(1, &_rbo);
   glDeleteTextures(1, &_screenTexture);
@@ -82,71 +133,41 @@ ApplicationSolar::~ApplicationSolar() {
 ///////////////////////////// intialisation functions /////////////////////////
 // load models
 void ApplicationSolar::initializeGeometry() {
-    // Generic method to setup data for rendering each geometry
-    auto initGeometry = [this](model_object& geoObject,
-        const model* modelData,
-        vector<float>& vertexData,
-        GLenum drawMode,
-        GLint numAttribute,
-        GLint* attributeSizes,
-        GLenum* attributeTypes,
-        GLsizei* attributeStrides,
-        void** attributeOffsets,
-        GLsizei numElement,
-        bool useIndices = false) {
-            // Generate and bind vertex array object
-            glGenVertexArrays(1, &geoObject.vertex_AO);
-            glBindVertexArray(geoObject.vertex_AO);
-
-            // Generate and bind vertex buffer object
-            glGenBuffers(1, &geoObject.vertex_BO);
-            glBindBuffer(GL_ARRAY_BUFFER, geoObject.vertex_BO);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertexData.size(), vertexData.data(), GL_STATIC_DRAW);
-
-            // Set up vertex attributes on gpu
-            for (GLint i = 0; i < numAttribute; ++i) {
-                glEnableVertexAttribArray(i);
-                glVertexAttribPointer(i, attributeSizes[i], attributeTypes[i], GL_FALSE, attributeStrides[i], attributeOffsets[i]);
-            }
-
-            // If indices are used, set up IBO aswell
-            if (useIndices) {
-                glGenBuffers(1, &geoObject.element_BO);
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geoObject.element_BO);
-                glBufferData(GL_ELEMENT_ARRAY_BUFFER, model::INDEX.size * modelData->indices.size(), modelData->indices.data(), GL_STATIC_DRAW);
-            }
-
-            // Store draw mode and number of elements in geometry object
-            geoObject.draw_mode = drawMode;
-            geoObject.num_elements = numElement;
-    };
+    // 1. Initialize planet geometry from loaded model, all meshes are suballocated from the arena's buffers
+    // the model is parsed and simplified once, later starts map its binary caches and upload them without a copy.
+    // Planets far away draw one of the coarser levels, see GeometryNode::selectLod
+    auto planetLods = model_loader::cached_lod_chain(m_resource_path + "models/sphere.obj", model::NORMAL | model::TEXCOORD, PLANET_LOD_TRIANGLES, true);
+    for (auto const& planetModel : planetLods) {
+        _planetLods.push_back(_geometryArena.add(planetModel, GL_TRIANGLES));
+    }
 
-    // 1. Initialize planet geometry from loaded model
-    model planetModel = model_loader::obj(m_resource_path + "models/sphere.obj", model::NORMAL | model::TEXCOORD);
-    GLint attributeSizes[] = { model::POSITION.components, model::NORMAL.components, model::TEXCOORD.components };
-    GLenum attributeTypes[] = { model::POSITION.type, model::NORMAL.type, model::TEXCOORD.type };
-    GLsizei attributeStrides[] = { planetModel.vertex_bytes, planetModel.vertex_bytes, planetModel.vertex_bytes };
-    void* attributeOffsets[] = { planetModel.offsets[model::POSITION], planetModel.offsets[model::NORMAL], planetModel.offsets[model::TEXCOORD] };
-    GLsizei numElement = GLsizei(planetModel.data.size());
-    initGeometry(_planetObject, &planetModel, planetModel.data, GL_TRIANGLES, 3, attributeSizes, attributeTypes, attributeStrides, attributeOffsets, numElement, true);
+    // 1.1 Per draw data of the multi draw shaders, the record of each draw is selected by the baseInstance of its command
+    vector<GeometryArena::InstanceAttribute> instanceAttributes;
+    for (GLuint column = 0; column < 4; ++column) { // a mat4 attribute takes 4 locations, one per column
+        instanceAttributes.push_back({ 3 + column, 4, offsetof(DrawInstance, modelMatrix) + column * sizeof(glm::fvec4) });
+    }
+    for (GLuint column = 0; column < 3; ++column) {
+        instanceAttributes.push_back({ 7 + column, 3, offsetof(DrawInstance, normalMatrix) + column * sizeof(glm::fvec3) });
+    }
+    instanceAttributes.push_back({ 10, 2, offsetof(DrawInstance, textureLayer) }); // texture layer and ambient strength
+    _geometryArena.setInstanceLayout(instanceAttributes, sizeof(DrawInstance));
 
     // 2. Initialize star primitive
-    auto numberOfStars = 3000;
-    vector<float> starData;
-    for (int i = 0; i < numberOfStars; ++i) { // Each Star data layout consists of 3 number for xyz coordinate and 3 number for rgb color
+    vector<ArenaPackedVertex> starVertices(_starCount);
+    for (auto& star : starVertices) { // the color of a star is stored in the normal and texture attributes, which the star shader reads as color
         for (int p = 0; p < POSITION_COMPONENTS; ++p) { // each model space's coordinate will be a random float between - 1 and 1
-            starData.emplace_back(STAR_POSITION_RANGE * (utils::random_float() - 0.5f));
+            star.position[p] = STAR_POSITION_RANGE * (utils::random_float() - 0.5f);
         }
+        float color[COLOR_COMPONENTS];
         for (int c = 0; c < COLOR_COMPONENTS; ++c) { // each color component will be random 0-254(int) and normalized to 0-1(float)
-            starData.emplace_back(float(std::rand() % COLOR_MAX_VALUE) / COLOR_MAX_VALUE);
+            color[c] = float(std::rand() % COLOR_MAX_VALUE) / COLOR_MAX_VALUE;
         }
+        // red and green as snorm16 in place of the normal, blue as half float in s, see star.vert
+        star.normal = glm::i16vec2{ vertex_packing::snorm16(color[0]), vertex_packing::snorm16(color[1]) };
+        star.texcoord = glm::u16vec2{ vertex_packing::half_float(color[2]), 0 };
     }
-    GLint starAttributeSizes[] = { POSITION_COMPONENTS, COLOR_COMPONENTS };
-    GLenum starAttributeTypes[] = { GL_FLOAT, GL_FLOAT };
-    GLsizei starAttributeStrides[] = { sizeof(float) * (POSITION_COMPONENTS + COLOR_COMPONENTS), sizeof(float) * (POSITION_COMPONENTS + COLOR_COMPONENTS) };
-    void* starAttributeOffsets[] = { 0, (void*)(sizeof(float) * POSITION_COMPONENTS) };
-    GLsizei starNumElement = GLsizei(starData.size());
-    initGeometry(_starObject, nullptr, starData, GL_POINTS, 2, starAttributeSizes, starAttributeTypes, starAttributeStrides, starAttributeOffsets, starNumElement);
+    _starObject = _geometryArena.add(starVertices, {}, GL_POINTS);
+    // stars and skybox surround the camera, they keep the default unbounded volume and are never culled
 
     // 3. Initialize orbit primitive
     auto numberOfPointInTheLine = 128;
@@ -157,12 +178,16 @@ void ApplicationSolar::initializeGeometry() {
         orbitData.emplace_back(0); // y-coordinate = orbits lie in the xz-plane
         orbitData.emplace_back(cos(theta)); //  z-coordinate depth position of the point on the circle
     }
-    GLint orbitAttributeSizes[] = { POSITION_COMPONENTS };
-    GLenum orbitAttributeTypes[] = { GL_FLOAT };
-    GLsizei orbitAttributeStrides[] = { sizeof(float) * POSITION_COMPONENTS };
-    void* orbitAttributeOffsets[] = { 0 };
-    GLsizei orbitNumElement = GLsizei(orbitData.size() / POSITION_COMPONENTS);
-    initGeometry(_orbitObject, nullptr, orbitData, GL_LINE_LOOP, 1, orbitAttributeSizes, orbitAttributeTypes, orbitAttributeStrides, orbitAttributeOffsets, orbitNumElement);
+    // geometry given as positions only
+    auto positionVertices = [](vector<float> const& positions) {
+        vector<ArenaVertex> vertices(positions.size() / POSITION_COMPONENTS, ArenaVertex{ fvec3{ 0.0f }, fvec3{ 0.0f }, glm::fvec2{ 0.0f } });
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            vertices[i].position = fvec3{ positions[i * POSITION_COMPONENTS], positions[i * POSITION_COMPONENTS + 1], positions[i * POSITION_COMPONENTS + 2] };
+        }
+        return vertices;
+    };
+    _orbitObject = _geometryArena.add(positionVertices(orbitData), {}, GL_LINE_LOOP);
+    _orbitObject.bounds = model_loader::bounds(orbitData, POSITION_COMPONENTS);
 
     // 4. Initialize skybox primitive
     vector<float> cubeData = {
@@ -210,12 +235,7 @@ void ApplicationSolar::initializeGeometry() {
         -1.0f, -1.0f,  1.0f,
          1.0f, -1.0f,  1.0f
     };
-    GLint cubeAttributeSizes[] = { POSITION_COMPONENTS };
-    GLenum cubeAttributeTypes[] = { GL_FLOAT };
-    GLsizei cubeAttributeStrides[] = { sizeof(float) * POSITION_COMPONENTS };
-    void* cubeAttributeOffsets[] = { 0 };
-    GLsizei cubeNumElement = GLsizei(cubeData.size());
-    initGeometry(_skyboxObject, nullptr, cubeData, GL_TRIANGLES, 1, cubeAttributeSizes, cubeAttributeTypes, cubeAttributeStrides, cubeAttributeOffsets, cubeNumElement);
+    _skyboxObject = _geometryArena.add(positionVertices(cubeData), {}, GL_TRIANGLES);
 
     // 5. Initialize quad for offscreen rendering
     vector<float> screenQuadData = {
@@ -227,13 +247,11 @@ void ApplicationSolar::initializeGeometry() {
         1.0f, -1.0f,   1.0f, 0.0f, // v2
         1.0f,  1.0f,   1.0f, 1.0f  // v3
     };
-
-    GLint screenQuadAttributeSizes[] = { 2, 2 }; // position components, texture components
-    GLenum screenQuadAttributeTypes[] = { GL_FLOAT, GL_FLOAT };
-    GLsizei screenQuadAttributeStrides[] = { sizeof(float) * 4, sizeof(float) * 4 }; // total stride for a full set of attributes (position + texture coordinates)
-    void* screenQuadAttributeOffsets[] = { 0, (void*)(sizeof(float) * 2) }; // texture coordinates follow position, hence offset = sizeof(float) * 2
-    GLsizei screenQuadNumElement = GLsizei(screenQuadData.size() / 4); // divide by the number of components (position + texture coordinates)
-    initGeometry(_screenQuadObject, nullptr, screenQuadData, GL_TRIANGLE_STRIP, 2, screenQuadAttributeSizes, screenQuadAttributeTypes, screenQuadAttributeStrides, screenQuadAttributeOffsets, screenQuadNumElement);
+    vector<ArenaVertex> screenQuadVertices;
+    for (size_t i = 0; i < screenQuadData.size(); i += 4) { // position in the xy plane, texture coordinates follow it
+        screenQuadVertices.push_back(ArenaVertex{ fvec3{ screenQuadData[i], screenQuadData[i + 1], 0.0f }, fvec3{ 0.0f }, glm::fvec2{ screenQuadData[i + 2], screenQuadData[i + 3] } });
+    }
+    _screenQuadObject = _geometryArena.add(screenQuadVertices, {}, GL_TRIANGLES);
 }
 
 // load shader sources
@@ -243,46 +261,37 @@ void ApplicationSolar::initializeShaderPrograms() {
         auto& filePath = m_resource_path + "shaders/" + each.second;
         
         m_shaders.emplace(each.first, shader_program{ {{GL_VERTEX_SHADER,filePath + ".vert"}, {GL_FRAGMENT_SHADER,filePath + ".frag"}} });
-        
-        m_shaders.at(each.first).u_locs["NormalMatrix"] = -1;
-        m_shaders.at(each.first).u_locs["ModelMatrix"] = -1;
-        m_shaders.at(each.first).u_locs["ViewMatrix"] = -1;
-        m_shaders.at(each.first).u_locs["ProjectionMatrix"] = -1;
-        m_shaders.at(each.first).u_locs["GeometryColor"] = -1;
-        m_shaders.at(each.first).u_locs["AmbientColor"] = -1;
-        m_shaders.at(each.first).u_locs["AmbientStrength"] = -1;
-        m_shaders.at(each.first).u_locs["LightPosition"] = -1;
-        m_shaders.at(each.first).u_locs["LightColor"] = -1;
-        m_shaders.at(each.first).u_locs["CameraPosition"] = -1;
-        m_shaders.at(each.first).u_locs["EnableToonShading"] = -1;
-        m_shaders.at(each.first).u_locs["Texture"] = -1;
-        m_shaders.at(each.first).u_locs["ScreenTexture"] = -1;
-        m_shaders.at(each.first).u_locs["EnableHorizontalMirror"] = -1;
-        m_shaders.at(each.first).u_locs["EnableVerticalMirror"] = -1;
-        m_shaders.at(each.first).u_locs["EnableBlur"] = -1;
-        m_shaders.at(each.first).u_locs["EnableGrayscale"] = -1;
     }
 }
 
-texture_object ApplicationSolar::initializeTexture(const string& textureFile) {
-    // Initialize 2D texture
+texture_object ApplicationSolar::initializeTextureArray(vector<string> const& textureFiles) {
+    // Initialize 2D array texture, one layer per file
     texture_object textureObject;
-    textureObject.target = GL_TEXTURE_2D;
+    textureObject.target = GL_TEXTURE_2D_ARRAY;
     glGenTextures(1, &(textureObject.handle));
-    glBindTexture(GL_TEXTURE_2D, textureObject.handle);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureObject.handle);
     
     // Configure wrapping mode and texture filtering mode
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // specify wrapping mode for x-axis
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // specify wrapping mode for y-axis
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // specify filtering method for texture magnification
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // specify filtering method for texture minification
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // specify wrapping mode for x-axis
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // specify wrapping mode for y-axis
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // specify filtering method for texture magnification
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // specify filtering method for texture minification
     
-    // Uploads the pixel data to the GPU
-    pixel_data pixelData = texture_loader::file(m_resource_path + "textures/" + textureFile);
-    glTexImage2D(GL_TEXTURE_2D, 0, pixelData.channels, pixelData.width, pixelData.height, 0, pixelData.channels, pixelData.channel_type, pixelData.ptr());
+    // All layers have the size of the first texture, others are resampled (e.g. Earth and Moon are 1000x500, Saturn 1800x900)
+    vector<pixel_data> layers;
+    for (auto const& textureFile : textureFiles) {
+        layers.push_back(texture_loader::file(m_resource_path + "textures/" + textureFile));
+    }
+    GLsizei width = GLsizei(layers.front().width);
+    GLsizei height = GLsizei(layers.front().height);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, GLsizei(layers.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    for (size_t i = 0; i < layers.size(); ++i) {
+        pixel_data layer = texture_loader::resize_rgba(layers[i], size_t(width), size_t(height));
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, GLint(i), width, height, 1, layer.channels, layer.channel_type, layer.ptr());
+    }
 
     // Generates a set of smaller textures from the current texture, used in texture filtering
-    glGenerateMipmap(GL_TEXTURE_2D);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
     
     return textureObject;
 }
@@ -314,23 +323,34 @@ texture_object ApplicationSolar::initializeCubemapTexture() {
 
 // Initialize scenegraph's hierarchy object (todo-moch: need to refactor)
 void ApplicationSolar::initializeSceneGraph() {
-    // Initialize sceneGraph obj & Attach root node to it
-    auto root = make_shared<Node>("Root");
-    SceneGraph::getInstance().setRoot(root);
+    // Initialize sceneGraph obj & Attach root node to it, all nodes are owned by the scenegraph's node pools
+    auto& scene = SceneGraph::getInstance();
+    auto root = scene.createNode<Node>("Root");
+    scene.setRoot(root);
     auto distanceBetweenPlanetInX = 5.0f; // distance between each planet in X axis
 
+    // All planets share one array texture, so they can be drawn together
+    vector<string> planetNames = { "Sun", "Earth", "Moon", "Mercury", "Venus", "Mars", "Jupiter", "Saturn", "Uranus", "Neptune" };
+    vector<string> planetTextureFiles;
+    for (auto const& name : planetNames) { planetTextureFiles.push_back(name + ".png"); }
+    texture_object planetTextureArray = initializeTextureArray(planetTextureFiles);
+    for (unsigned layer = 0; layer < planetNames.size(); ++layer) {
+        _planetTextures[planetNames[layer]] = planetTextureArray;
+        _planetTextures[planetNames[layer]].layer = layer;
+    }
+
     // Add sun node as a child of root node
-    auto sun = make_shared<PointLightNode>("PointLight", fvec3{ 1.0f, 1.0f, 1.0f }, 1.0f);
-    auto sunGeo = make_shared<GeometryNode>("Sun Geometry", "planetShader", _planetObject, fvec3{ 1.0f, 1.0f, 1.0f }, initializeTexture("Sun.png"));
+    auto sun = scene.createNode<PointLightNode>("PointLight", fvec3{ 1.0f, 1.0f, 1.0f }, 1.0f);
+    auto sunGeo = scene.createNode<GeometryNode>("Sun Geometry", "planetShader", _planetLods, fvec3{ 1.0f, 1.0f, 1.0f }, _planetTextures.at("Sun"));
     root->addChild(sun);
     sun->addChild(sunGeo);
     sunGeo->setLocalTransform(scale(sunGeo->getLocalTransform(), { 3.0f, 3.0f, 3.0f })); // make sun bigger size
-    SceneGraph::getInstance().setDirectionalLight(sun);
+    scene.setDirectionalLight(sun);
 
     // Add earth node
-    auto earth = make_shared<Node>("Earth Holder");
-    auto earthGeo = make_shared<GeometryNode>("Earth Geometry", "planetShader", _planetObject, fvec3{ 0.2f, 0.5f, 0.8f }, initializeTexture("Earth.png"));
-    auto earthOrbit = make_shared<GeometryNode>("Earth Orbit", "orbitShader", _orbitObject, fvec3{ 0.2f, 0.5f, 0.8f });
+    auto earth = scene.createNode<Node>("Earth Holder");
+    auto earthGeo = scene.createNode<GeometryNode>("Earth Geometry", "planetShader", _planetLods, fvec3{ 0.2f, 0.5f, 0.8f }, _planetTextures.at("Earth"));
+    auto earthOrbit = scene.createNode<GeometryNode>("Earth Orbit", "orbitShader", _orbitObject, fvec3{ 0.2f, 0.5f, 0.8f });
     root->addChild(earthOrbit);
     root->addChild(earth);
     earth->addChild(earthGeo);
@@ -339,9 +359,9 @@ void ApplicationSolar::initializeSceneGraph() {
     
     // Add moon as child of earth geometry
     auto moonSize = 0.5f;
-    auto moon = make_shared<Node>("Moon Holder");
-    auto moonGeo = make_shared<GeometryNode>("Moon Geometry", "planetShader", _planetObject, fvec3{ 0.75f, 0.75f, 0.75f }, initializeTexture("Moon.png"));
-    auto moonOrbit = make_shared<GeometryNode>("Moon Orbit", "orbitShader", _orbitObject, fvec3{ 0.75f, 0.75f, 0.75f });
+    auto moon = scene.createNode<Node>("Moon Holder");
+    auto moonGeo = scene.createNode<GeometryNode>("Moon Geometry", "planetShader", _planetLods, fvec3{ 0.75f, 0.75f, 0.75f }, _planetTextures.at("Moon"));
+    auto moonOrbit = scene.createNode<GeometryNode>("Moon Orbit", "orbitShader", _orbitObject, fvec3{ 0.75f, 0.75f, 0.75f });
     earthGeo->addChild(moonOrbit);
     earthGeo->addChild(moon);
     moon->addChild(moonGeo);
@@ -360,9 +380,9 @@ void ApplicationSolar::initializeSceneGraph() {
         {"Neptune", fvec3{0.1f, 0.2f, 0.9f}}
     };
     for (const auto& each : planets) {
-        auto planet = make_shared<Node>(each.first + " Holder");
-        auto planetGeo = make_shared<GeometryNode>(each.first + " Geometry", "planetShader", _planetObject, each.second, initializeTexture(each.first + ".png"));
-        auto planetOrbit = make_shared<GeometryNode>(each.first + " Orbit", "orbitShader", _orbitObject, each.second);
+        auto planet = scene.createNode<Node>(each.first + " Holder");
+        auto planetGeo = scene.createNode<GeometryNode>(each.first + " Geometry", "planetShader", _planetLods, each.second, _planetTextures.at(each.first));
+        auto planetOrbit = scene.createNode<GeometryNode>(each.first + " Orbit", "orbitShader", _orbitObject, each.second);
         root->addChild(planetOrbit);
         root->addChild(planet);
         planet->addChild(planetGeo);
@@ -376,26 +396,152 @@ void ApplicationSolar::initializeSceneGraph() {
     }
 
     // Add star geometry node and scale its size as big as possible
-    auto starGeo = make_shared<GeometryNode>("Star", "starShader", _starObject, fvec3{1.0f, 1.0f, 1.0f});
+    auto starGeo = scene.createNode<GeometryNode>("Star", "starShader", _starObject, fvec3{1.0f, 1.0f, 1.0f});
     starGeo->setLocalTransform(scale(starGeo->getLocalTransform(), { 50.0f, 50.0f, 50.0f }));
     root->addChild(starGeo);
 
     // Add sky box node and encompass the entire scene
-    auto skyboxGeo = make_shared<GeometryNode>("Skybox", "skyboxShader", _skyboxObject, fvec3{ 1.0f, 1.0f, 1.0f }, initializeCubemapTexture());
+    auto skyboxGeo = scene.createNode<GeometryNode>("Skybox", "skyboxShader", _skyboxObject, fvec3{ 1.0f, 1.0f, 1.0f }, initializeCubemapTexture());
     skyboxGeo->setLocalTransform(scale(skyboxGeo->getLocalTransform(), { 40.0f, 40.0f, 40.0f }));
     //skyboxGeo->setLocalTransform(rotate(skyboxGeo->getLocalTransform(), glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
     root->addChild(skyboxGeo);
+    _sceneRadius = distanceBetweenPlanetInX;
+}
+
+// Same node layout as the solar system: every system is a holder with its sun geometry, every body a rotating holder
+// with the body's geometry as child and an orbit next to it. Moons hang below the geometry of their parent body
+void ApplicationSolar::initializeGeneratedScene(GeneratedScene const& parameters) {
+    auto& scene = SceneGraph::getInstance();
+    auto root = scene.createNode<Node>("Root");
+    scene.setRoot(root);
+    std::mt19937 generator(parameters.seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    vector<string> planetNames = { "Mercury", "Venus", "Earth", "Mars", "Jupiter", "Saturn", "Uranus", "Neptune" };
+    vector<string> textureNames = planetNames;
+    textureNames.insert(textureNames.end(), { "Sun", "Moon" });
+    vector<string> textureFiles;
+    for (auto const& name : textureNames) { textureFiles.push_back(name + ".png"); }
+    texture_object textureArray = initializeTextureArray(textureFiles);
+    for (unsigned layer = 0; layer < textureNames.size(); ++layer) {
+        _planetTextures[textureNames[layer]] = textureArray;
+        _planetTextures[textureNames[layer]].layer = layer;
+    }
+
+    // nodes per system: holder + sun, then holder, geometry and orbit per body
+    size_t bodies = 0;
+    for (unsigned level = 1, perLevel = parameters.planets; level <= parameters.depth; ++level, perLevel *= parameters.moons) { bodies += perLevel; }
+    size_t systemNodes = 2 + 3 * bodies;
+    scene.reserveNodes<Node>(parameters.systems * (bodies + 1));
+    scene.reserveNodes<GeometryNode>(parameters.systems * (2 * bodies + 1) + 2);
+
+    // satellites of one body on one level, moons orbit in the space of their parent's geometry
+    float const planetSpacing = 5.0f;
+    float const moonSpacing = 2.5f;
+    std::function<void(Node*, unsigned, unsigned, string const&)> addBodies = [&](Node* parent, unsigned count, unsigned level, string const& path) {
+        for (unsigned i = 0; i < count; ++i) {
+            bool isPlanet = level == 1;
+            string name = path + (isPlanet ? " Planet " : " Moon ") + std::to_string(i);
+            string textureName = isPlanet ? planetNames[(i + unsigned(generator())) % planetNames.size()] : "Moon";
+            fvec3 color{ 0.4f + 0.6f * unit(generator), 0.4f + 0.6f * unit(generator), 0.4f + 0.6f * unit(generator) };
+            float distance = isPlanet ? planetSpacing * float(i + 2) : moonSpacing * float(i + 1);
+            float size = isPlanet ? 0.5f + 0.7f * unit(generator) : 0.2f + 0.2f * unit(generator);
+            auto holder = scene.createNode<Node>(name + " Holder");
+            auto geometry = scene.createNode<GeometryNode>(name + " Geometry", "planetShader", _planetLods, color, _planetTextures.at(textureName));
+            auto orbit = scene.createNode<GeometryNode>(name + " Orbit", "orbitShader", _orbitObject, color);
+            parent->addChild(orbit);
+            parent->addChild(holder);
+            holder->addChild(geometry);
+            holder->setLocalTransform(rotate(fmat4{}, TWO_PI * unit(generator), fvec3{ 0.0f, 1.0f, 0.0f }));
+            geometry->setLocalTransform(scale(translate(fmat4{}, fvec3{ distance, 0.0f, 0.0f }), fvec3{ size }));
+            orbit->setLocalTransform(scale(fmat4{}, fvec3{ distance }));
+            if (level < parameters.depth) {
+                addBodies(geometry, parameters.moons, level + 1, name);
+            }
+        }
+    };
+
+    // systems on a grid around the origin, the first sun lights the scene
+    float systemRadius = planetSpacing * float(parameters.planets + 1);
+    unsigned gridSize = unsigned(std::ceil(std::sqrt(float(parameters.systems))));
+    float systemSpacing = 2.5f * systemRadius;
+    PointLightNode* sun = nullptr;
+    for (unsigned s = 0; s < parameters.systems; ++s) {
+        string name = "System " + std::to_string(s);
+        Node* system = nullptr;
+        if (s == 0) {
+            sun = scene.createNode<PointLightNode>(name, fvec3{ 1.0f, 1.0f, 1.0f }, 1.0f);
+            system = sun;
+        }
+        else {
+            system = scene.createNode<Node>(name);
+        }
+        auto sunGeo = scene.createNode<GeometryNode>("Sun Geometry", "planetShader", _planetLods, fvec3{ 1.0f, 1.0f, 1.0f }, _planetTextures.at("Sun"));
+        root->addChild(system);
+        system->addChild(sunGeo);
+        sunGeo->setLocalTransform(scale(fmat4{}, fvec3{ 3.0f }));
+        fvec3 position{ (float(s % gridSize) - 0.5f * float(gridSize - 1)) * systemSpacing, 0.0f, (float(s / gridSize) - 0.5f * float(gridSize - 1)) * systemSpacing };
+        system->setLocalTransform(translate(fmat4{}, position));
+        _sceneRadius = std::max(_sceneRadius, glm::length(position) + systemRadius);
+        addBodies(system, parameters.planets, 1, name);
+    }
+    scene.setDirectionalLight(sun);
+
+    // stars and skybox around everything, like in the solar system
+    auto starGeo = scene.createNode<GeometryNode>("Star", "starShader", _starObject, fvec3{ 1.0f, 1.0f, 1.0f });
+    starGeo->setLocalTransform(scale(fmat4{}, fvec3{ std::max(50.0f, 2.0f * _sceneRadius) }));
+    root->addChild(starGeo);
+    auto skyboxGeo = scene.createNode<GeometryNode>("Skybox", "skyboxShader", _skyboxObject, fvec3{ 1.0f, 1.0f, 1.0f }, initializeCubemapTexture());
+    skyboxGeo->setLocalTransform(scale(fmat4{}, fvec3{ 40.0f }));
+    root->addChild(skyboxGeo);
+    std::cout << "Generated " << parameters.systems << " systems of " << systemNodes << " nodes" << std::endl;
+}
+
+// Asteroids are small moon textured spheres below one rotating holder, each on its own orbit between mars and jupiter
+void ApplicationSolar::addAsteroidBelt(unsigned count) {
+    auto& scene = SceneGraph::getInstance();
+    scene.reserveNodes<GeometryNode>(count);
+    Node* belt = scene.createNode<Node>("Asteroid Belt " + std::to_string(_asteroidCount));
+    scene.getRoot()->addChild(belt);
+    for (unsigned i = 0; i < count; ++i) {
+        auto asteroidGeo = scene.createNode<GeometryNode>("Asteroid " + std::to_string(_asteroidCount + i), "planetShader", _planetLods, fvec3{ 0.6f, 0.6f, 0.6f }, _planetTextures.at("Moon"));
+        float angle = TWO_PI * utils::random_float();
+        float distance = 22.0f + 4.0f * utils::random_float();
+        float size = 0.05f + 0.1f * utils::random_float();
+        fmat4 transform = translate(fmat4{}, fvec3{ distance * std::cos(angle), 0.5f * (utils::random_float() - 0.5f), distance * std::sin(angle) });
+        asteroidGeo->setLocalTransform(scale(transform, fvec3{ size, size, size }));
+        belt->addChild(asteroidGeo);
+    }
+    _asteroidCount += count;
 }
 
 // Setup camera node
 void ApplicationSolar::initializeCamera(fmat4 camInitialTransform, fmat4 camInitialProjection) {
-    auto camera = make_shared<CameraNode>("Camera");
+    auto& scene = SceneGraph::getInstance();
+    auto camera = scene.createNode<CameraNode>("Camera");
     camera->setEnabled(true);
     camera->setLocalTransform(camInitialTransform);
     camera->setProjectionMatrix(camInitialProjection);
     
-    SceneGraph::getInstance().setCamera(camera); // make camera node accessible through SceneGraph object
-    SceneGraph::getInstance().getRoot()->addChild(camera); // add camera node to root node
+    scene.setCamera(camera); // make camera node accessible through SceneGraph object
+    scene.getRoot()->addChild(camera); // add camera node to root node
+}
+
+// Setup per node animation of the scene updater, it runs concurrently on disjoint subtrees
+void ApplicationSolar::initializeAnimation() {
+    _sceneUpdater.setAnimation([this](Node& node) {
+        if (!_isRotating) { return; }
+        // Rotate holder nodes of planet geometry, because rightnow all holder node is in the same position as sun
+        // Then the rotation of holder will affect position of childe geometry node aswell
+        for (Node* child = node.getFirstChild(); child; child = child->getNextSibling()) {
+            if (child->getType() != NodeType::Geometry) { continue; }
+            auto geoNode = static_cast<GeometryNode*>(child);
+            if (geoNode->getShader() == "planetShader" && geoNode->getName() != "Sun Geometry") {
+                node.setLocalTransform(rotate(node.getLocalTransform(), _rotationAngle, fvec3{ 0.0f, 1.0f, 0.0f }));
+                return; // only the visited node may be changed, other subtrees are animated at the same time
+            }
+        }
+    });
 }
 
 void ApplicationSolar::initializeFrameBuffer(unsigned width, unsigned height) {
@@ -425,78 +571,187 @@ void ApplicationSolar::initializeFrameBuffer(unsigned width, unsigned height) {
 ///////////////////////////// intialisation functions /////////////////////////
 
 ///////////////////////////// render functions /////////////////////////
+void ApplicationSolar::update() {
+    // same elapsed time for every planet in this frame, the animation reads it from all threads
+    _rotationAngle = _isRotating ? static_cast<float>(_timer.getElapsedTime() * 10.0f) : 0.0f;
+    // Animate planets, recompute dirty world transforms and collect draw data of geometry nodes
+    _sceneUpdater.update();
+}
+
 void ApplicationSolar::render() const {
-    // 1. Render the scene as usual to our new framebuffer
+    // 1. Render the scene as usual to our new framebuffer, its GPU time is measured until the quad pass
+    Profiler& profiler = Profiler::getInstance();
+    profiler.beginGpuScope("Offscreen pass");
     offScreenRender();
 
-    // 2. Traverse scenegraph to render Geometry node
-    auto transformAndDrawGeometry = [this](shared_ptr<Node> node) {
-        auto geoNode = dynamic_pointer_cast<GeometryNode>(node);
-        if (!geoNode) { return; } // Render only GeometryNode
-
-        // ------------------------ Transformation section ---------------------------
-        if (geoNode->getShader() == "planetShader" && geoNode->getName() != "Sun Geometry" && _isRotating) {
-            // Rotate GeometryNode's parent, because rightnow all holder node is in the same position as sun
-            // Then the rotation of holder will affect position of childe geometry node aswell
-            auto parent = geoNode->getParent();
-            parent->setLocalTransform(rotate(parent->getLocalTransform(), static_cast<float>(_timer.getElapsedTime() * 10.0f), fvec3{ 0.0f, 1.0f, 0.0f }));
-        }
-        // ------------------------ End transformation section ------------------------
-        
-        // ------------------- Shading & Drawing section ------------------------------- 
-        // (todo-moch: we can extract rendering process to a method in Node object)
-        auto geometry = geoNode->getGeometry();
-        auto shaderToUse = geoNode->getShader();
-        
-        auto geoNodeWorldTransform = geoNode->getWorldTransform();
-        auto geoNodeColor = geoNode->getGeometryColor();
-        auto geoNodeTexture = geoNode->getTexture();
-        auto sunNode = SceneGraph::getInstance().getDirectionalLight();
-        auto sunNodeWorldTransform = sunNode->getWorldTransform();
-        auto sunNodeColor = sunNode->getLightColor() * sunNode->getLightIntensity();
-        auto cameraNode = SceneGraph::getInstance().getCamera();
-        auto cameraNodeWorldTransform = cameraNode->getWorldTransform();
-
-        // Bind shader to use
-        glUseProgram(m_shaders.at(shaderToUse).handle);
-        
-        // Upload ModelMatrix & NormalMatrix
-        glUniformMatrix4fv(m_shaders.at(shaderToUse).u_locs.at("ModelMatrix"), 1, GL_FALSE, glm::value_ptr(geoNodeWorldTransform)); // Note: glUniformMatrix4fv() is used for per draw call (i.e. uniforms, entire primitive), while glVertexAttribPointer() is used for per vertex
-        glm::fmat4 normalMatrix = glm::inverseTranspose(glm::inverse(cameraNodeWorldTransform) * geoNodeWorldTransform);
-        glUniformMatrix4fv(m_shaders.at(shaderToUse).u_locs.at("NormalMatrix"), 1, GL_FALSE, glm::value_ptr(normalMatrix)); // extra matrix for normal transformation to keep them orthogonal to surface
-
-        // Upload light attribute to fragment shader
-        if (shaderToUse == "planetShader") {
-            // glUniform3fv(m_shaders.at(shaderToUse).u_locs.at("GeometryColor"), 1, glm::value_ptr(geoNodeColor));
-            glUniform3fv(m_shaders.at(shaderToUse).u_locs.at("AmbientColor"), 1, glm::value_ptr(fvec3{ 1.0f, 1.0f, 1.0f }));
-            glUniform1f(m_shaders.at(shaderToUse).u_locs.at("AmbientStrength"), geoNode->getName() == "Sun Geometry" ? sunNode->getLightIntensity() : 0.2f);
-            glUniform3fv(m_shaders.at(shaderToUse).u_locs.at("LightColor"), 1, glm::value_ptr(sunNodeColor));
-            glUniform3fv(m_shaders.at(shaderToUse).u_locs.at("LightPosition"), 1, glm::value_ptr(sunNodeWorldTransform * glm::vec4{ 0, 0, 0, 1 })); // Make sure 
-            glUniform3fv(m_shaders.at(shaderToUse).u_locs.at("CameraPosition"), 1, glm::value_ptr(cameraNodeWorldTransform * glm::vec4{ 0, 0, 0, 1 }));
-            glUniform1b(m_shaders.at(shaderToUse).u_locs.at("EnableToonShading"), _enableToonShading);
+    // 2. Queue geometry nodes with the GL state they need, sorted so that nodes sharing state are drawn together
+    auto sunNode = SceneGraph::getInstance().getDirectionalLight();
+    auto cameraNode = SceneGraph::getInstance().getCamera();
+    fmat4 cameraNodeWorldTransform = cameraNode->getWorldTransform();
+    fmat4 viewMatrix;
+    simd_math::affine_inverse(&cameraNodeWorldTransform, &viewMatrix, 1);
+    GLuint planetProgram = m_shaders.at("planetShader").handle;
+    GLuint skyboxProgram = m_shaders.at("skyboxShader").handle;
+    GLuint starProgram = m_shaders.at("starShader").handle;
+
+    // buffers were filled by the scene updater's threads, matrices are already batch computed
+    auto const& drawBuffers = _sceneUpdater.getDrawBuffers();
+    {
+        PROFILE_SCOPE("Queue draws");
+        _renderQueue.clear();
+        _drawnTriangles = 0;
+        string lastShaderName;
+        GLuint lastProgram = 0;
+        for (unsigned list = 0; list < drawBuffers.size(); ++list) {
+            auto const& buffer = drawBuffers[list];
+            for (unsigned i = 0; i < buffer.size(); ++i) {
+                GeometryNode* geoNode = buffer.nodes[i];
+                auto geoNodeTexture = geoNode->getTexture();
+                string shaderName = geoNode->getShader();
+                if (shaderName != lastShaderName) { // most neighbouring nodes use the same shader
+                    lastShaderName = shaderName;
+                    lastProgram = m_shaders.at(shaderName).handle;
+                }
+                DrawState state;
+                state.program = lastProgram;
+                state.textureTarget = geoNodeTexture.target;
+                state.texture = geoNodeTexture.handle;
+                model_object geometry = geoNode->getGeometry(); // the level of detail selected by the scene updater
+                state.vertexArray = geometry.vertex_AO;
+                _drawnTriangles += geometry.draw_mode == GL_TRIANGLES ? size_t(geometry.num_elements / 3) : 0;
+                // nodes are drawn with the multi draw variant of their shader if it has one, batches of equal state become one draw call
+                if (_enableMultiDraw) {
+                    auto multiDrawShader = _multiDrawShaders.find(shaderName);
+                    if (multiDrawShader != _multiDrawShaders.end()) { state.program = m_shaders.at(multiDrawShader->second).handle; }
+                }
+                // stars and skybox are behind everything, drawing them last lets the depth test reject most of their fragments
+                RenderPass pass = state.program == skyboxProgram || state.program == starProgram ? RenderPass::Background : RenderPass::Opaque;
+                float depth = -(viewMatrix * buffer.modelMatrices[i][3]).z;
+                _renderQueue.push(pass, state, depth, list, i);
+            }
         }
+    }
+    {
+        PROFILE_SCOPE("Sort draws");
+        _renderQueue.sort();
+    }
 
-        // Select texture, access it and upload texture data to shader program
-        if (shaderToUse == "planetShader" || shaderToUse == "skyboxShader") {
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(geoNodeTexture.target, geoNodeTexture.handle);
-            glUniform1i(m_shaders.at(shaderToUse).u_locs.at("Texture"), 0);
+    // 3. Render Geometry node, program, texture and vertex array are only bound when they change
+    std::set<GLuint> multiDrawPrograms;
+    for (auto const& each : _multiDrawShaders) { multiDrawPrograms.insert(m_shaders.at(each.second).handle); }
+    shader_program const* currentShader = nullptr;
+    _drawCalls = 0;
+    uploadFrameData(); // camera and light of this frame, read by every program from the uniform buffer
+    auto onProgram = [&](GLuint program) {
+        for (auto const& each : m_shaders) {
+            if (each.second.handle == program) { currentShader = &each.second; }
         }
+        currentShader->uniforms.set(ENABLE_TOON_SHADING, _enableToonShading); // no-op for programs without toon shading
+        currentShader->uniforms.set(TEXTURE, 0); // textures are bound to unit 0, no-op for programs without texture
+    };
+    auto drawGeometry = [&](unsigned list, unsigned i) {
+        GeometryNode* geoNode = drawBuffers[list].nodes[i];
+        auto geometry = geoNode->getGeometry();
 
-        // Draw VBO
-        glBindVertexArray(geometry.vertex_AO);
-        if (shaderToUse == "planetShader") {
-            glDrawElements(geometry.draw_mode, geometry.num_elements, model::INDEX.type, NULL);
+        // Upload ModelMatrix & NormalMatrix
+        currentShader->uniforms.set(MODEL_MATRIX, drawBuffers[list].modelMatrices[i]); // Note: uniforms are used per draw call (i.e. entire primitive), while glVertexAttribPointer() is used for per vertex
+        currentShader->uniforms.set(NORMAL_MATRIX, drawBuffers[list].normalMatrices[i]); // extra matrix for normal transformation to keep them orthogonal to surface
+
+        // Draw the node's range of the arena's buffers
+        if (currentShader->handle == planetProgram) {
+            currentShader->uniforms.set(AMBIENT_STRENGTH, geoNode->getParent() == sunNode ? sunNode->getLightIntensity() : 0.2f); // the sun's own geometry glows
+            currentShader->uniforms.set(TEXTURE_LAYER, float(geoNode->getTexture().layer));
         }
-        else {
-            glDrawArrays(geometry.draw_mode, 0, geometry.num_elements);
+        glDrawElementsBaseVertex(geometry.draw_mode, geometry.num_elements, _geometryArena.getIndexType(), (void*)(_geometryArena.getIndexSize() * geometry.first_index), geometry.base_vertex);
+        ++_drawCalls;
+    };
+    auto drawBatch = [&](vector<DrawRef> const& batch) {
+        if (multiDrawPrograms.count(currentShader->handle)) {
+            _drawCalls += drawMultiIndirect(batch);
+            return;
         }
-        // ------------------- End drawing section --------------------------
+        for (auto const& ref : batch) { drawGeometry(ref.list, ref.index); }
     };
-    SceneGraph::getInstance().getRoot()->traverse(transformAndDrawGeometry);
+    {
+        PROFILE_SCOPE("Submit draws");
+        _renderQueue.submitBatches(onProgram, drawBatch);
+    }
+    profiler.endGpuScope();
 
-    // 3. Draw a quad that spans the entire screen with the new framebuffer's color buffer as its texture.
+    // 4. Draw a quad that spans the entire screen with the new framebuffer's color buffer as its texture.
     renderScreenTextureToQuadObject();
+
+    // 5. The next frame writes its data into the next region of the stream buffer, this one is fenced until the GPU read it
+    _streamBuffer.nextFrame();
+}
+
+unsigned ApplicationSolar::getDrawCalls() const {
+    return _drawCalls;
+}
+
+size_t ApplicationSolar::getDrawnTriangles() const {
+    return _drawnTriangles;
+}
+
+void ApplicationSolar::setLodEnabled(bool isLodEnabled) {
+    _sceneUpdater.setLodEnabled(isLodEnabled);
+}
+
+SceneUpdater::CullStatistics ApplicationSolar::getCullStatistics() const {
+    return _sceneUpdater.getCullStatistics();
+}
+
+float ApplicationSolar::getSceneRadius() const {
+    return _sceneRadius;
+}
+
+unsigned ApplicationSolar::drawMultiIndirect(vector<DrawRef> const& batch) const {
+    auto sunNode = SceneGraph::getInstance().getDirectionalLight();
+    auto const& drawBuffers = _sceneUpdater.getDrawBuffers();
+    size_t drawCount = batch.size();
+
+    // Lighting is done in world space, so the normal matrix is the inverse transpose of the model matrix alone
+    _instanceModelMatrices.resize(drawCount);
+    _instanceNormalMatrices.resize(drawCount);
+    for (size_t i = 0; i < drawCount; ++i) {
+        _instanceModelMatrices[i] = drawBuffers[batch[i].list].modelMatrices[batch[i].index];
+    }
+    simd_math::normal_matrix(fmat4{}, _instanceModelMatrices.data(), _instanceNormalMatrices.data(), drawCount);
+
+    _drawInstances.resize(drawCount);
+    for (size_t i = 0; i < drawCount; ++i) {
+        GeometryNode* geoNode = drawBuffers[batch[i].list].nodes[batch[i].index];
+        DrawInstance& instance = _drawInstances[i];
+        instance.modelMatrix = _instanceModelMatrices[i];
+        instance.normalMatrix = glm::fmat3(_instanceNormalMatrices[i]);
+        instance.textureLayer = float(geoNode->getTexture().layer);
+        instance.ambientStrength = geoNode->getParent() == sunNode ? sunNode->getLightIntensity() : 0.2f; // the sun's own geometry glows
+    }
+    GLuint firstInstance = _geometryArena.uploadInstances(_drawInstances.data(), drawCount);
+
+    // One command per run of nodes sharing a mesh, its instances read consecutive records. A change of the primitive type needs a new call
+    unsigned drawCalls = 0;
+    GLenum drawMode = GL_NONE;
+    _drawCommands.clear();
+    for (size_t i = 0; i < drawCount; ++i) {
+        model_object geometry = drawBuffers[batch[i].list].nodes[batch[i].index]->getGeometry();
+        if (geometry.draw_mode != drawMode && !_drawCommands.empty()) {
+            _geometryArena.draw(drawMode, _drawCommands);
+            drawCalls += _geometryArena.hasMultiDrawIndirect() ? 1 : unsigned(_drawCommands.size());
+            _drawCommands.clear();
+        }
+        drawMode = geometry.draw_mode;
+        DrawElementsIndirectCommand* last = _drawCommands.empty() ? nullptr : &_drawCommands.back();
+        if (last && last->firstIndex == geometry.first_index && last->baseVertex == geometry.base_vertex && last->count == GLuint(geometry.num_elements)) {
+            ++last->instanceCount;
+        }
+        else {
+            _drawCommands.push_back(GeometryArena::command(geometry, 1, firstInstance + GLuint(i)));
+        }
+    }
+    _geometryArena.draw(drawMode, _drawCommands);
+    drawCalls += _geometryArena.hasMultiDrawIndirect() ? 1 : unsigned(_drawCommands.size());
+    return drawCalls;
 }
 
 void ApplicationSolar::offScreenRender() const {
@@ -507,6 +762,8 @@ void ApplicationSolar::offScreenRender() const {
 }
 
 void ApplicationSolar::renderScreenTextureToQuadObject() const {
+    PROFILE_SCOPE("Quad pass");
+    PROFILE_GPU_SCOPE("Quad pass");
     // Bind back to default framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);       // Set clear color to white (not really necessary actually, since we won't be able to see behind the quad anyways)
@@ -517,34 +774,44 @@ void ApplicationSolar::renderScreenTextureToQuadObject() const {
     glUseProgram(m_shaders.at("quadShader").handle);
     glBindVertexArray(_screenQuadObject.vertex_AO);
     glBindTexture(GL_TEXTURE_2D, _screenTexture);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glDrawElementsBaseVertex(_screenQuadObject.draw_mode, _screenQuadObject.num_elements, _geometryArena.getIndexType(), (void*)(_geometryArena.getIndexSize() * _screenQuadObject.first_index), _screenQuadObject.base_vertex);
 }
 
-void ApplicationSolar::uploadView() {
+void ApplicationSolar::uploadFrameData() const {
+    auto& scene = SceneGraph::getInstance();
+    auto cameraNode = scene.getCamera();
+    auto sunNode = scene.getDirectionalLight();
+    fmat4 cameraWorldTransform = cameraNode->getWorldTransform();
+    fmat4 sunWorldTransform = sunNode->getWorldTransform();
+
+    FrameData frameData;
     // vertices are transformed in camera space, so camera transform must be inverted
-    fmat4 viewMatrix = glm::inverse(SceneGraph::getInstance().getCamera()->getWorldTransform());
-    
-    // upload matrix to gpu
-    for (auto& const each : _shaderList) {
-        glUseProgram(m_shaders.at(each.first).handle);
-        glUniformMatrix4fv(m_shaders.at(each.first).u_locs.at("ViewMatrix"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
-    }
+    simd_math::affine_inverse(&cameraWorldTransform, &frameData.viewMatrix, 1);
+    frameData.projectionMatrix = cameraNode->getProjectionMatrix();
+    frameData.cameraPosition = cameraWorldTransform * glm::fvec4{ 0.0f, 0.0f, 0.0f, 1.0f };
+    frameData.lightPosition = sunWorldTransform * glm::fvec4{ 0.0f, 0.0f, 0.0f, 1.0f };
+    frameData.lightColor = glm::fvec4{ sunNode->getLightColor() * sunNode->getLightIntensity(), 0.0f };
+    frameData.ambientColor = glm::fvec4{ 1.0f, 1.0f, 1.0f, 0.0f };
+    _frameDataBuffer.update(&frameData); // one buffer update for all programs, none if nothing changed
+}
+
+void ApplicationSolar::uploadView() {
+    // camera may have been moved by input callbacks, refresh its cached world transform first
+    SceneGraph::getInstance().updateWorldTransforms();
+    uploadFrameData();
     
     // For quad.frag
-    glUseProgram(m_shaders.at("quadShader").handle);
-    glUniform1i(m_shaders.at("quadShader").u_locs.at("ScreenTexture"), 0);
-    glUniform1b(m_shaders.at("quadShader").u_locs.at("EnableVerticalMirror"), _enableVericallMirror);
-    glUniform1b(m_shaders.at("quadShader").u_locs.at("EnableHorizontalMirror"), _enableHorizontalMirror);
-    glUniform1b(m_shaders.at("quadShader").u_locs.at("EnableGrayscale"), _enableGrayscale);
-    glUniform1b(m_shaders.at("quadShader").u_locs.at("EnableBlur"), _enableBlur);
+    auto& quadShader = m_shaders.at("quadShader");
+    glUseProgram(quadShader.handle);
+    quadShader.uniforms.set(SCREEN_TEXTURE, 0);
+    quadShader.uniforms.set(ENABLE_VERTICAL_MIRROR, _enableVericallMirror);
+    quadShader.uniforms.set(ENABLE_HORIZONTAL_MIRROR, _enableHorizontalMirror);
+    quadShader.uniforms.set(ENABLE_GRAYSCALE, _enableGrayscale);
+    quadShader.uniforms.set(ENABLE_BLUR, _enableBlur);
 }
 
 void ApplicationSolar::uploadProjection() {
-    fmat4 projectionMatrix = SceneGraph::getInstance().getCamera()->getProjectionMatrix();
-    for (auto& const each : _shaderList) {
-        glUseProgram(m_shaders.at(each.first).handle);
-        glUniformMatrix4fv(m_shaders.at(each.first).u_locs.at("ProjectionMatrix"), 1, GL_FALSE, glm::value_ptr(projectionMatrix));
-    }
+    uploadFrameData();
 }
 
 // update uniform locations (triggered before render())
@@ -575,6 +842,75 @@ void ApplicationSolar::keyCallback(int key, int action, int mods) {
         uploadView();
     } else if (key == GLFW_KEY_SPACE && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
         _isRotating = !_isRotating;
+    } else if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+        _sceneUpdater.setSingleThreaded(!_sceneUpdater.isSingleThreaded()); // A/B comparison of the parallel scene update
+        std::cout << "Scene update threads: " << _sceneUpdater.getThreadCount() << std::endl;
+    } else if (key == GLFW_KEY_N && action == GLFW_PRESS) {
+        _enableMultiDraw = !_enableMultiDraw; // A/B comparison of one multi draw indirect call per batch and one draw call per node
+        std::cout << "Multi draw " << (_enableMultiDraw ? "on" : "off") << (_geometryArena.hasMultiDrawIndirect() ? "" : " (emulated, no GL 4.3 or ARB_multi_draw_indirect)") << std::endl;
+    } else if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+        _enableStreaming = !_enableStreaming; // A/B comparison of the mapped stream buffer and glBufferData uploads
+        _frameDataBuffer.setStreamBuffer(_enableStreaming ? &_streamBuffer : nullptr);
+        _geometryArena.setStreamBuffer(_enableStreaming ? &_streamBuffer : nullptr);
+        std::cout << "Stream buffer " << (_enableStreaming ? "on" : "off") << std::endl;
+    } else if (key == GLFW_KEY_B && action == GLFW_PRESS) {
+        addAsteroidBelt(10000);
+        std::cout << "Asteroids: " << _asteroidCount << std::endl;
+    } else if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+        // A/B comparison of frustum culling: hierarchy -> none -> linear
+        static char const* const modeNames[] = { "off", "linear", "hierarchy" };
+        SceneUpdater::CullMode mode = SceneUpdater::CullMode((unsigned(_sceneUpdater.getCullMode()) + 1) % 3);
+        _sceneUpdater.setCullMode(mode);
+        std::cout << "Frustum culling " << modeNames[unsigned(mode)] << std::endl;
+    } else if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+        _sceneUpdater.setLodEnabled(!_sceneUpdater.isLodEnabled()); // A/B comparison of levels of detail and full meshes
+        std::cout << "Levels of detail " << (_sceneUpdater.isLodEnabled() ? "on" : "off") << std::endl;
+    } else if (key == GLFW_KEY_I && action == GLFW_PRESS) {
+        auto const& statistics = _renderQueue.getStatistics(); // state changes of the last frame
+        auto cullStatistics = _sceneUpdater.getCullStatistics();
+        auto const& boundsStatistics = SceneGraph::getInstance().getBoundingVolumes().getStatistics();
+        std::cout << "Geometry nodes: " << cullStatistics.tested << ", visible: " << cullStatistics.visible
+                  << ", culled: " << cullStatistics.tested - cullStatistics.visible << std::endl;
+        vector<size_t> lodNodes(_planetLods.size(), 0); // visible planets per level of detail
+        for (auto const& buffer : _sceneUpdater.getDrawBuffers()) {
+            for (GeometryNode* node : buffer.nodes) {
+                if (node->getLodCount() == _planetLods.size()) { ++lodNodes[node->getLod()]; }
+            }
+        }
+        std::cout << "Levels of detail " << (_sceneUpdater.isLodEnabled() ? "on" : "off") << ", planets per level:";
+        for (size_t lod = 0; lod < _planetLods.size(); ++lod) { std::cout << " " << lodNodes[lod] << " (" << _planetLods[lod].num_elements / 3 << " triangles)"; }
+        std::cout << std::endl;
+        std::cout << "Bounding volumes: " << boundsStatistics.leaves << " leaves, refits: " << boundsStatistics.refits
+                  << ", reinserts: " << boundsStatistics.reinserts << ", rebuilds: " << boundsStatistics.rebuilds
+                  << ", cost: " << boundsStatistics.cost << std::endl;
+        std::cout << "Draws: " << statistics.draws << ", batches: " << statistics.batches
+                  << ", program changes: " << statistics.programChanges << " (" << statistics.avoidedProgramChanges << " avoided)"
+                  << ", texture changes: " << statistics.textureChanges << " (" << statistics.avoidedTextureChanges << " avoided)"
+                  << ", vertex array changes: " << statistics.vertexArrayChanges << " (" << statistics.avoidedVertexArrayChanges << " avoided)" << std::endl;
+        std::cout << "Frame data buffer updates: " << _frameDataBuffer.getUpdateCount() << std::endl;
+        std::cout << "Geometry arena: " << _geometryArena.getVertexCount() << " vertices (" << _geometryArena.getVertexCount() * sizeof(ArenaPackedVertex)
+                  << " bytes), " << _geometryArena.getIndexCount() << " indices (" << _geometryArena.getIndexCount() * _geometryArena.getIndexSize() << " bytes)" << std::endl;
+        auto const& streamStatistics = _streamBuffer.getStatistics();
+        std::cout << "Stream buffer: " << (_streamBuffer.isPersistent() ? "persistent mapping" : "copy, no GL 4.4 or ARB_buffer_storage")
+                  << ", region " << _streamBuffer.getRegionSize() << " bytes, peak " << streamStatistics.peakBytes << " bytes, stalls: " << streamStatistics.stalls
+                  << " (" << streamStatistics.stallMicroseconds / 1000.0 << " ms), overflows: " << streamStatistics.overflows << std::endl;
+        for (auto const& each : m_shaders) { // uniform uploads since the program was linked
+            auto const& uniformStatistics = each.second.uniforms.getStatistics();
+            std::cout << each.first << " uniform uploads: " << uniformStatistics.uploads << " (" << uniformStatistics.skippedUploads << " unchanged values skipped)" << std::endl;
+        }
+    } else if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        // write the frames in the profiler's ring buffer, open the trace in chrome://tracing or ui.perfetto.dev
+        auto const& profiler = Profiler::getInstance();
+        auto frames = profiler.getFrames();
+        auto slowest = std::max_element(frames.begin(), frames.end(), [](Profiler::Frame const& a, Profiler::Frame const& b) { return a.duration < b.duration; });
+        if (profiler.exportChromeTrace("frame_trace.json") && profiler.exportCsv("frame_times.csv")) {
+            std::cout << "Wrote " << frames.size() << " frames to frame_trace.json and frame_times.csv";
+            if (slowest != frames.end()) { std::cout << ", slowest: frame " << slowest->index << " with " << slowest->duration / 1000.0 << " ms"; }
+            std::cout << std::endl;
+        }
+        else {
+            std::cerr << "Could not write frame_trace.json or frame_times.csv" << std::endl;
+        }
     } else if (key == GLFW_KEY_1 && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
         _enableToonShading = !_enableToonShading;
     } else if (key == GLFW_KEY_7 && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
@@ -603,6 +939,17 @@ void ApplicationSolar::mouseCallback(double pos_x, double pos_y) {
     camera->setLocalTransform(rotate(camera->getLocalTransform(), radians(float(pos_y* mouseSensitivity)), fvec3{ -1.0f, 0.0f, 0.0f }));
 
     uploadView();
+
+    // The cursor is disabled and the view follows it, so pick the planet under the screen center
+    auto& scene = SceneGraph::getInstance();
+    fmat4 cameraTransform = camera->getWorldTransform();
+    fvec3 rayDirection = glm::normalize(fvec3{ cameraTransform * glm::fvec4{ 0.0f, 0.0f, -1.0f, 0.0f } });
+    auto isPlanet = [](GeometryNode* node) { return node->getShader() == "planetShader"; }; // orbits enclose their planets
+    auto hit = scene.getBoundingVolumes().queryRay(fvec3{ cameraTransform[3] }, rayDirection, PICK_DISTANCE, scene.getTransforms(), isPlanet);
+    if (hit.node && hit.node != _pickedNode) {
+        std::cout << "Picked: " << hit.node->getName() << " (" << hit.distance << ")" << std::endl;
+    }
+    _pickedNode = hit.node;
 }
 
 //handle resizing
@@ -610,9 +957,13 @@ void ApplicationSolar::resizeCallback(unsigned width, unsigned height) {
   SceneGraph::getInstance().getCamera()->setProjectionMatrix(utils::calculate_projection_matrix(float(width) / float(height))); // recalculate projection matrix for new aspect ration
   uploadProjection(); // upload new projection matrix
   initializeFrameBuffer(width, height); // Re-size window impact frame buffer !!
+  _sceneUpdater.setViewportHeight(height); // levels of detail are selected by size in pixels
 }
 
 ///////////////////////////// exe entry point /////////////////////////////
+// solar_bench compiles this file with its own entry point
+#ifndef SOLAR_BENCH
 int main(int argc, char* argv[]) {
   Application::run<ApplicationSolar>(argc, argv, 3, 2);
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,238 @@
+// Microbenchmark of the scenegraph's bounding volume hierarchy: frustum, sphere and ray queries
+// against a linear scan over all geometry nodes (results are compared), and the per frame update
+// cost when a part of the planets moves along their orbits.
+// usage: benchmark_bounding_volumes [planet count] [queries] [frames]
+#include "SceneGraph.hpp"
+#include "GeometryNode.hpp"
+#include "Node.hpp"
+#include "simd_math.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+using glm::fmat4;
+using glm::fvec3;
+using glm::fvec4;
+using std::vector;
+
+typedef BoundingVolumeHierarchy::Box Box;
+
+// same world box as the hierarchy's leaves
+static Box worldBox(GeometryNode* node) {
+    bounding_volume const& bounds = node->getBounds();
+    fmat4 world = node->getWorldTransform();
+    fvec3 center = fvec3{world * fvec4{(bounds.min + bounds.max) * 0.5f, 1.0f}};
+    fvec3 halfSize = (bounds.max - bounds.min) * 0.5f;
+    fvec3 extent = glm::abs(fvec3{world[0]}) * halfSize.x + glm::abs(fvec3{world[1]}) * halfSize.y + glm::abs(fvec3{world[2]}) * halfSize.z;
+    return Box{center - extent, center + extent};
+}
+
+static bool isInFrustum(Box const& box, fvec4 const* planes) {
+    for (int p = 0; p < 6; ++p) {
+        fvec3 positive{planes[p].x >= 0.0f ? box.max.x : box.min.x, planes[p].y >= 0.0f ? box.max.y : box.min.y, planes[p].z >= 0.0f ? box.max.z : box.min.z};
+        if (glm::dot(fvec3{planes[p]}, positive) + planes[p].w < 0.0f) { return false; }
+    }
+    return true;
+}
+
+static float raySphere(fvec3 const& origin, fvec3 const& direction, GeometryNode* node) {
+    fmat4 world = node->getWorldTransform();
+    fvec3 offset = origin - fvec3{world * fvec4{node->getBounds().center, 1.0f}};
+    float radius = node->getBounds().radius * std::max(glm::length(fvec3{world[0]}), std::max(glm::length(fvec3{world[1]}), glm::length(fvec3{world[2]})));
+    float b = glm::dot(offset, direction);
+    float discriminant = b * b - (glm::dot(offset, offset) - radius * radius);
+    if (discriminant < 0.0f) { return std::numeric_limits<float>::infinity(); }
+    float root = std::sqrt(discriminant);
+    float distance = -b - root >= 0.0f ? -b - root : -b + root;
+    return distance >= 0.0f ? distance : std::numeric_limits<float>::infinity();
+}
+
+template<typename Function>
+static double measureUs(unsigned repetitions, Function const& function) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < repetitions; ++i) { function(i); }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / repetitions;
+}
+
+static void report(char const* query, double hierarchyUs, double linearUs, std::size_t results, bool isEqual) {
+    std::cout << std::left << std::setw(8) << query << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << hierarchyUs << " us hierarchy" << std::setw(11) << linearUs << " us linear"
+              << std::setw(9) << linearUs / hierarchyUs << "x  results " << results << (isEqual ? "" : "  MISMATCH") << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t planetCount = argc > 1 ? std::size_t(std::atoi(argv[1])) : 200000u;
+    unsigned queries = argc > 2 ? unsigned(std::atoi(argv[2])) : 200u;
+    unsigned frames = argc > 3 ? unsigned(std::atoi(argv[3])) : 20u;
+
+    // Root -> orbit holders -> planets, holders are rotated to move the planets
+    auto& scene = SceneGraph::getInstance();
+    scene.reserveNodes<Node>(planetCount + 1);
+    scene.reserveNodes<GeometryNode>(planetCount);
+    Node* root = scene.createNode<Node>("Root");
+    scene.setRoot(root);
+    model_object sphere;
+    sphere.bounds.center = fvec3{0.0f};
+    sphere.bounds.radius = 1.0f;
+    sphere.bounds.min = fvec3{-1.0f};
+    sphere.bounds.max = fvec3{1.0f};
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    float worldSize = 4.0f * std::cbrt(float(planetCount)); // about one planet per 64 cubic units
+    vector<Node*> holders;
+    vector<GeometryNode*> planets;
+    for (std::size_t i = 0; i < planetCount; ++i) {
+        Node* holder = scene.createNode<Node>("Holder " + std::to_string(i));
+        holder->setLocalTransform(glm::translate(fmat4{}, fvec3{unit(gen), unit(gen), unit(gen)} * worldSize));
+        GeometryNode* planet = scene.createNode<GeometryNode>("Planet " + std::to_string(i), "planetShader", sphere, fvec3{1.0f});
+        planet->setLocalTransform(glm::scale(glm::translate(fmat4{}, fvec3{3.0f, 0.0f, 0.0f}), fvec3{0.5f + 0.5f * std::abs(unit(gen))}));
+        root->addChild(holder);
+        holder->addChild(planet);
+        holders.push_back(holder);
+        planets.push_back(planet);
+    }
+    scene.updateWorldTransforms();
+    auto const& bvh = scene.getBoundingVolumes();
+    std::cout << "planets: " << planetCount << ", queries: " << queries << ", tree cost: " << bvh.getStatistics().cost << std::endl;
+
+    // random cameras, spheres and rays inside the world
+    vector<fvec3> origins(queries), targets(queries);
+    for (unsigned i = 0; i < queries; ++i) {
+        origins[i] = fvec3{unit(gen), unit(gen), unit(gen)} * worldSize;
+        targets[i] = fvec3{unit(gen), unit(gen), unit(gen)} * worldSize;
+    }
+    fmat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, worldSize * 0.5f);
+    vector<Box> boxes(planetCount);
+    for (std::size_t i = 0; i < planetCount; ++i) { boxes[i] = worldBox(planets[i]); }
+    auto frustum = [&](unsigned i, fvec4* planes) {
+        simd_math::frustum_planes(projection * glm::lookAt(origins[i], targets[i], fvec3{0.0f, 1.0f, 0.0f}), planes);
+    };
+
+    bool isMatching = true;
+    vector<GeometryNode*> result, reference;
+    std::size_t results = 0;
+    bool isEqual = true;
+    auto compare = [&]() {
+        std::sort(result.begin(), result.end());
+        std::sort(reference.begin(), reference.end());
+        isEqual = isEqual && result == reference;
+    };
+
+    // 1. frustum
+    double hierarchyUs = measureUs(queries, [&](unsigned i) {
+        fvec4 planes[6];
+        frustum(i, planes);
+        result.clear();
+        bvh.queryFrustum(planes, result);
+    });
+    double linearUs = measureUs(queries, [&](unsigned i) {
+        fvec4 planes[6];
+        frustum(i, planes);
+        reference.clear();
+        for (std::size_t p = 0; p < planetCount; ++p) {
+            if (isInFrustum(boxes[p], planes)) { reference.push_back(planets[p]); }
+        }
+    });
+    results = 0;
+    for (unsigned i = 0; i < queries; ++i) {
+        fvec4 planes[6];
+        frustum(i, planes);
+        result.clear();
+        reference.clear();
+        bvh.queryFrustum(planes, result);
+        for (std::size_t p = 0; p < planetCount; ++p) {
+            if (isInFrustum(boxes[p], planes)) { reference.push_back(planets[p]); }
+        }
+        results += result.size();
+        compare();
+    }
+    report("frustum", hierarchyUs, linearUs, results / queries, isEqual);
+    isMatching = isMatching && isEqual;
+
+    // 2. sphere overlap, "what is near this point"
+    float queryRadius = 10.0f;
+    auto overlaps = [queryRadius](Box const& box, fvec3 const& center) {
+        fvec3 offset = glm::clamp(center, box.min, box.max) - center;
+        return glm::dot(offset, offset) <= queryRadius * queryRadius;
+    };
+    hierarchyUs = measureUs(queries, [&](unsigned i) {
+        result.clear();
+        bvh.querySphere(origins[i], queryRadius, result);
+    });
+    linearUs = measureUs(queries, [&](unsigned i) {
+        reference.clear();
+        for (std::size_t p = 0; p < planetCount; ++p) {
+            if (overlaps(boxes[p], origins[i])) { reference.push_back(planets[p]); }
+        }
+    });
+    isEqual = true;
+    results = 0;
+    for (unsigned i = 0; i < queries; ++i) {
+        result.clear();
+        reference.clear();
+        bvh.querySphere(origins[i], queryRadius, result);
+        for (std::size_t p = 0; p < planetCount; ++p) {
+            if (overlaps(boxes[p], origins[i])) { reference.push_back(planets[p]); }
+        }
+        results += result.size();
+        compare();
+    }
+    report("sphere", hierarchyUs, linearUs, results / queries, isEqual);
+    isMatching = isMatching && isEqual;
+
+    // 3. nearest ray hit, like picking
+    float maxDistance = 4.0f * worldSize;
+    vector<GeometryNode*> hits(queries), referenceHits(queries);
+    hierarchyUs = measureUs(queries, [&](unsigned i) {
+        hits[i] = bvh.queryRay(origins[i], glm::normalize(targets[i] - origins[i]), maxDistance, scene.getTransforms()).node;
+    });
+    linearUs = measureUs(queries, [&](unsigned i) {
+        fvec3 direction = glm::normalize(targets[i] - origins[i]);
+        float nearest = maxDistance;
+        referenceHits[i] = nullptr;
+        for (std::size_t p = 0; p < planetCount; ++p) {
+            float distance = raySphere(origins[i], direction, planets[p]);
+            if (distance <= nearest) {
+                nearest = distance;
+                referenceHits[i] = planets[p];
+            }
+        }
+    });
+    results = std::size_t(std::count_if(hits.begin(), hits.end(), [](GeometryNode* node) { return node != nullptr; }));
+    isEqual = hits == referenceHits;
+    report("ray", hierarchyUs, linearUs, results, isEqual);
+    isMatching = isMatching && isEqual;
+
+    // 4. update, a part of the planets moves along its orbit in every frame
+    for (unsigned percent : {1u, 10u, 100u}) {
+        std::size_t moving = std::max(std::size_t(1), planetCount * percent / 100);
+        std::size_t rebuilds = bvh.getStatistics().rebuilds, refits = 0, reinserts = 0;
+        double updateUs = 0.0;
+        for (unsigned frame = 0; frame < frames; ++frame) {
+            for (std::size_t i = 0; i < moving; ++i) {
+                Node* holder = holders[(std::size_t(frame) * moving + i) % planetCount];
+                holder->setLocalTransform(glm::rotate(holder->getLocalTransform(), 0.05f, fvec3{0.0f, 1.0f, 0.0f}));
+            }
+            updateUs += measureUs(1, [&](unsigned) { scene.updateWorldTransforms(); }) / frames; // world transforms and bounds
+            refits += bvh.getStatistics().refits;
+            reinserts += bvh.getStatistics().reinserts;
+        }
+        std::cout << "update " << std::setw(3) << percent << "% moving " << std::fixed << std::setprecision(1)
+                  << std::setw(10) << updateUs << " us/frame  refits " << refits / frames
+                  << ", reinserts " << reinserts / frames << ", rebuilds " << bvh.getStatistics().rebuilds - rebuilds
+                  << ", cost " << std::setprecision(2) << bvh.getStatistics().cost << std::endl;
+    }
+
+    scene.clear();
+    return isMatching ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,71 @@
+// Microbenchmark of the simd_math frustum culling kernel for every supported instruction set,
+// bounding spheres scattered in a cube around a camera, about a tenth of them is visible.
+// usage: benchmark_frustum_culling [sphere count] [iterations]
+#include "simd_math.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+using glm::fmat4;
+using glm::fvec3;
+using std::vector;
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::size_t(std::atoi(argv[1])) : 1000000u;
+    unsigned iterations = argc > 2 ? unsigned(std::atoi(argv[2])) : 50u;
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.1f, 2.0f);
+    vector<float> x(count), y(count), z(count), radius(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        x[i] = position(gen);
+        y[i] = position(gen);
+        z[i] = position(gen);
+        radius[i] = size(gen);
+    }
+    fmat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    fmat4 view = glm::lookAt(fvec3{0.0f, 0.0f, 0.0f}, fvec3{0.0f, 0.0f, -1.0f}, fvec3{0.0f, 1.0f, 0.0f});
+    glm::fvec4 planes[6];
+    simd_math::frustum_planes(projection * view, planes);
+
+    std::cout << "spheres: " << count << ", iterations: " << iterations
+              << ", detected: " << simd_math::name(simd_math::detect()) << std::endl;
+
+    vector<simd_math::instruction_set> sets{simd_math::instruction_set::scalar};
+    if (simd_math::detect() >= simd_math::instruction_set::sse) { sets.push_back(simd_math::instruction_set::sse); }
+    if (simd_math::detect() >= simd_math::instruction_set::avx) { sets.push_back(simd_math::instruction_set::avx); }
+
+    vector<unsigned char> visible(count), reference(count);
+    double scalarTime = 0.0;
+    std::size_t scalarVisible = 0;
+    bool isMatching = true;
+    for (auto set : sets) {
+        simd_math::force(set);
+        std::size_t visibleCount = simd_math::cull_spheres(planes, x.data(), y.data(), z.data(), radius.data(), visible.data(), count); // warm up
+        auto start = std::chrono::high_resolution_clock::now();
+        for (unsigned i = 0; i < iterations; ++i) {
+            visibleCount = simd_math::cull_spheres(planes, x.data(), y.data(), z.data(), radius.data(), visible.data(), count);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / (double(iterations) * double(count));
+
+        if (set == simd_math::instruction_set::scalar) {
+            scalarTime = ns;
+            scalarVisible = visibleCount;
+            reference = visible;
+        }
+        bool isEqual = visibleCount == scalarVisible && visible == reference;
+        isMatching = isMatching && isEqual;
+        std::cout << std::left << std::setw(8) << simd_math::name(set) << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(9) << ns << " ns/sphere" << std::setprecision(2) << std::setw(8) << scalarTime / ns << "x"
+                  << "   visible " << visibleCount << (isEqual ? "" : "  MISMATCH") << std::endl;
+    }
+    simd_math::force(simd_math::detect());
+    return isMatching ? EXIT_SUCCESS : EXIT_FAILURE;
+}
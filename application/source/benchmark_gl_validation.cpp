@@ -0,0 +1,100 @@
+// Microbenchmark of the per call overhead of GL error checking: the same stream of state changes and
+// tiny draws is issued at every window_handler::validation_level in a hidden window.
+// usage: benchmark_gl_validation [draws] [repetitions]
+#include "window_handler.hpp"
+
+#include <glbinding/gl/gl.h>
+#include <glbinding/Binding.h>
+using namespace gl;
+
+//dont load gl bindings from glfw
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+static const unsigned CALLS_PER_DRAW = 4;
+
+static GLuint compileProgram() {
+    char const* vertexSource = "#version 150\nuniform vec4 Offset;\nvoid main() { gl_Position = Offset; }\n";
+    char const* fragmentSource = "#version 150\nout vec4 Color;\nvoid main() { Color = vec4(1.0); }\n";
+    GLuint program = glCreateProgram();
+    for (auto const& stage : { std::make_pair(GL_VERTEX_SHADER, vertexSource), std::make_pair(GL_FRAGMENT_SHADER, fragmentSource) }) {
+        GLuint shader = glCreateShader(stage.first);
+        glShaderSource(shader, 1, &stage.second, nullptr);
+        glCompileShader(shader);
+        glAttachShader(program, shader);
+        glDeleteShader(shader);
+    }
+    glLinkProgram(program);
+    return program;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned draws = argc > 1 ? unsigned(std::atoi(argv[1])) : 100000u;
+    unsigned repetitions = argc > 2 ? unsigned(std::atoi(argv[2])) : 5u;
+
+    if (!glfwInit()) {
+        std::cerr << "Could not initialize GLFW" << std::endl;
+        return EXIT_FAILURE;
+    }
+    glfwWindowHint(GLFW_VISIBLE, false);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, true);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true); // the same context for every level
+    GLFWwindow* window = glfwCreateWindow(64, 64, "benchmark_gl_validation", nullptr, nullptr);
+    if (!window) {
+        std::cerr << "Could not create an OpenGL 3.2 context" << std::endl;
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+    glfwMakeContextCurrent(window);
+    glbinding::Binding::initialize();
+    std::cout << "GL " << glGetString(GL_VERSION) << ", " << draws << " draws of " << CALLS_PER_DRAW << " calls, best of " << repetitions << std::endl;
+
+    GLuint program = compileProgram();
+    GLint offsetLocation = glGetUniformLocation(program, "Offset");
+    GLuint vertexArrays[2];
+    glGenVertexArrays(2, vertexArrays);
+
+    // like the render loop: program, per draw uniform, vertex array and the draw call
+    auto drawAll = [&]() {
+        for (unsigned i = 0; i < draws; ++i) {
+            glUseProgram(program);
+            glUniform4f(offsetLocation, float(i % 7) * 0.1f, 0.0f, 0.0f, 1.0f);
+            glBindVertexArray(vertexArrays[i & 1]);
+            glDrawArrays(GL_POINTS, 0, 1);
+        }
+        glFinish(); // include the GPU side, asynchronous debug output must not hide work there
+    };
+
+    double noneNs = 0.0;
+    for (auto level : { window_handler::validation_level::none, window_handler::validation_level::debug_output, window_handler::validation_level::full }) {
+        window_handler::set_validation_level(level);
+        drawAll(); // warm up
+        double bestNs = 0.0;
+        for (unsigned repetition = 0; repetition < repetitions; ++repetition) {
+            auto start = std::chrono::high_resolution_clock::now();
+            drawAll();
+            auto end = std::chrono::high_resolution_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(end - start).count() / (double(draws) * CALLS_PER_DRAW);
+            bestNs = repetition == 0 ? ns : std::min(bestNs, ns);
+        }
+        if (level == window_handler::validation_level::none) { noneNs = bestNs; }
+        std::cout << std::left << std::setw(14) << window_handler::to_string(level) << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(9) << bestNs << " ns/call" << std::setprecision(2) << std::setw(8) << bestNs / noneNs << "x" << std::endl;
+    }
+
+    window_handler::set_validation_level(window_handler::validation_level::none);
+    glDeleteVertexArrays(2, vertexArrays);
+    glDeleteProgram(program);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return EXIT_SUCCESS;
+}
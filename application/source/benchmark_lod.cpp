@@ -0,0 +1,87 @@
+// Microbenchmark of the level of detail chain: triangles, vertices and error of each level of a loaded obj simplified
+// by mesh_optimizer::simplify, the time to build it, and the screen radius in pixels below which GeometryNode selects a level.
+// The error has to bound the distance of the full mesh's vertices to the closest triangle of the level, measured here by brute force.
+// usage: benchmark_lod [obj path] [triangle budgets...]
+#include "model_loader.hpp"
+#include "mesh_optimizer.hpp"
+#include "GeometryNode.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+using std::vector;
+
+static glm::fvec3 positionOf(model const& mesh, std::size_t vertex) {
+    GLfloat const* values = mesh.data.data() + vertex * std::size_t(mesh.vertex_bytes) / sizeof(GLfloat);
+    return glm::fvec3{values[0], values[1], values[2]};
+}
+
+// distance of point to triangle abc, by the region of the closest feature
+static float distanceToTriangle(glm::fvec3 const& p, glm::fvec3 const& a, glm::fvec3 const& b, glm::fvec3 const& c) {
+    glm::fvec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) { return glm::length(ap); }
+    glm::fvec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) { return glm::length(bp); }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) { return glm::length(p - (a + ab * (d1 / (d1 - d3)))); }
+    glm::fvec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) { return glm::length(cp); }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) { return glm::length(p - (a + ac * (d2 / (d2 - d6)))); }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) { return glm::length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))))); }
+    float denominator = 1.0f / (va + vb + vc);
+    return glm::length(p - (a + ab * (vb * denominator) + ac * (vc * denominator)));
+}
+
+// largest distance of the vertices of mesh to the surface of level
+static float hausdorff(model const& mesh, model const& level) {
+    float result = 0.0f;
+    for (std::size_t vertex = 0; vertex < mesh.vertex_num; ++vertex) {
+        glm::fvec3 p = positionOf(mesh, vertex);
+        float closest = std::numeric_limits<float>::max();
+        for (std::size_t i = 0; i + 2 < level.indices.size(); i += 3) {
+            closest = std::min(closest, distanceToTriangle(p, positionOf(level, level.indices[i]), positionOf(level, level.indices[i + 1]), positionOf(level, level.indices[i + 2])));
+        }
+        result = std::max(result, closest);
+    }
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "resources/models/sphere.obj";
+    vector<std::size_t> budgets;
+    for (int i = 2; i < argc; ++i) { budgets.push_back(std::size_t(std::strtoul(argv[i], nullptr, 10))); }
+    if (budgets.empty()) { budgets = {1024, 256, 64}; }
+    model mesh = model_loader::obj(path, model::NORMAL | model::TEXCOORD);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    vector<model> levels = model_loader::lod_chain(mesh, budgets);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << path << ": " << levels.size() << " levels built in " << std::fixed << std::setprecision(2)
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms, bounding radius " << mesh.bounds.radius << std::endl;
+
+    bool isCorrect = true;
+    for (std::size_t lod = 0; lod < levels.size(); ++lod) {
+        model const& level = levels[lod];
+        float measured = lod == 0 ? 0.0f : hausdorff(mesh, level);
+        float limit = lod == 0 ? std::numeric_limits<float>::infinity() : level.lod_error > 0.0f ? GeometryNode::LOD_PIXEL_ERROR * mesh.bounds.radius / level.lod_error : 0.0f;
+        std::cout << "level " << lod << std::setw(8) << level.indices.size() / 3 << " triangles" << std::setw(8) << level.vertex_num << " vertices"
+                  << std::setprecision(5) << "  error " << level.lod_error << ", measured " << measured
+                  << std::setprecision(1) << "  below " << limit << " px radius" << std::endl;
+        // up to the float rounding of the measurement, which adds and compares in float instead of double
+        isCorrect = isCorrect && measured <= level.lod_error + 1e-6f * mesh.bounds.radius && (lod == 0 || level.indices.size() < levels[lod - 1].indices.size());
+    }
+    std::cout << (isCorrect ? "" : "MISMATCH of measured and reported error or of the triangle counts\n");
+    return isCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,76 @@
+// Microbenchmark of model loading: parsing the obj with tinyobjloader against the binary mesh cache,
+// cold (no cache, parse and write it), warm (map the cache) and touched (source rewritten with the same
+// content, the cache is validated by hash). The cached data is compared to the parsed model.
+// The source is copied next to the working directory, so the cache of the resources is left alone.
+// usage: benchmark_mesh_cache [obj path] [repetitions]
+#include "model_loader.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+static std::string const COPY_PATH = "benchmark_mesh_cache.obj";
+
+static void copyFile(std::string const& from, std::string const& to) {
+    std::ifstream source(from, std::ios::binary);
+    std::ofstream destination(to, std::ios::binary | std::ios::trunc);
+    destination << source.rdbuf();
+}
+
+// milliseconds of load, averaged over repetitions, prepare runs before every load and is not measured
+template<typename Prepare, typename Load>
+static double measureMs(unsigned repetitions, Prepare const& prepare, Load const& load) {
+    double total = 0.0;
+    for (unsigned i = 0; i < repetitions; ++i) {
+        prepare();
+        auto start = std::chrono::high_resolution_clock::now();
+        load();
+        auto end = std::chrono::high_resolution_clock::now();
+        total += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    return total / repetitions;
+}
+
+static void report(char const* name, double ms, double parseMs) {
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << ms << " ms" << std::setw(10) << std::setprecision(1) << parseMs / ms << "x parse" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string sourcePath = argc > 1 ? argv[1] : "resources/models/sphere.obj";
+    unsigned repetitions = argc > 2 ? unsigned(std::atoi(argv[2])) : 20u;
+    model::attrib_flag_t attributes = model::NORMAL | model::TEXCOORD;
+    std::string cachePath = COPY_PATH + ".mesh";
+    copyFile(sourcePath, COPY_PATH);
+    std::remove(cachePath.c_str());
+
+    model parsed;
+    double parseMs = measureMs(repetitions, [] {}, [&] { parsed = model_loader::obj(COPY_PATH, attributes); });
+    mesh_data mesh;
+    double coldMs = measureMs(repetitions, [&] { mesh = mesh_data{}; std::remove(cachePath.c_str()); },
+                              [&] { mesh = model_loader::cached_obj(COPY_PATH, attributes); });
+    double warmMs = measureMs(repetitions, [&] { mesh = mesh_data{}; }, [&] { mesh = model_loader::cached_obj(COPY_PATH, attributes); });
+    double touchedMs = measureMs(repetitions, [&] { mesh = mesh_data{}; copyFile(sourcePath, COPY_PATH); },
+                                 [&] { mesh = model_loader::cached_obj(COPY_PATH, attributes); });
+
+    bool isEqual = mesh.vertex_num == parsed.vertex_num && mesh.index_num == parsed.indices.size() && mesh.vertex_bytes == parsed.vertex_bytes
+                   && mesh.offsets == parsed.offsets && mesh.bounds.radius == parsed.bounds.radius
+                   && std::memcmp(mesh.vertices, parsed.data.data(), parsed.data.size() * sizeof(GLfloat)) == 0
+                   && std::memcmp(mesh.indices, parsed.indices.data(), parsed.indices.size() * sizeof(GLuint)) == 0;
+    std::cout << sourcePath << ": " << parsed.vertex_num << " vertices, " << parsed.indices.size() << " indices, repetitions: " << repetitions
+              << (isEqual ? "" : "  MISMATCH") << std::endl;
+    report("parse", parseMs, parseMs);
+    report("cold", coldMs, parseMs);
+    report("warm", warmMs, parseMs);
+    report("touched", touchedMs, parseMs);
+
+    mesh = mesh_data{};
+    std::remove(cachePath.c_str());
+    std::remove(COPY_PATH.c_str());
+    return isEqual ? EXIT_SUCCESS : EXIT_FAILURE;
+}
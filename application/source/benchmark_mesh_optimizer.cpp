@@ -0,0 +1,63 @@
+// Microbenchmark of the mesh optimizer: vertex count, ACMR and ATVR of a loaded obj before and after welding,
+// triangle and vertex reordering, simulated with FIFO caches of 16 and 32 entries, and the time of each step.
+// The same for the mesh with shuffled triangles, the order of meshes exported without any optimisation.
+// usage: benchmark_mesh_optimizer [obj path]
+#include "model_loader.hpp"
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using std::vector;
+
+template<typename Function>
+static double measureMs(Function const& function) {
+    auto start = std::chrono::high_resolution_clock::now();
+    function();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void report(char const* name, vector<GLuint> const& indices, std::size_t vertexNum) {
+    auto fifo16 = mesh_optimizer::analyze(indices, vertexNum, 16);
+    auto fifo32 = mesh_optimizer::analyze(indices, vertexNum, 32);
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3) << std::setw(9) << vertexNum << " vertices"
+              << "  ACMR " << fifo16.acmr << " / " << fifo32.acmr << "  ATVR " << fifo16.atvr << " / " << fifo32.atvr << std::endl;
+}
+
+static void optimize(char const* name, model mesh) {
+    std::size_t stride = std::size_t(mesh.vertex_bytes) / sizeof(GLfloat);
+    std::cout << name << ", FIFO 16 / 32 entries" << std::endl;
+    report("before", mesh.indices, mesh.vertex_num);
+    double weldMs = measureMs([&] { mesh_optimizer::weld(mesh.data, stride, mesh.indices); });
+    report("welded", mesh.indices, mesh.data.size() / stride);
+    double trianglesMs = measureMs([&] { mesh_optimizer::reorder_triangles(mesh.indices, mesh.data.size() / stride); });
+    report("forsyth", mesh.indices, mesh.data.size() / stride);
+    double verticesMs = measureMs([&] { mesh_optimizer::reorder_vertices(mesh.data, stride, mesh.indices); });
+    report("fetch", mesh.indices, mesh.data.size() / stride);
+    std::cout << std::setprecision(2) << "weld " << weldMs << " ms, triangle order " << trianglesMs << " ms, vertex order " << verticesMs << " ms\n" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "resources/models/sphere.obj";
+    model mesh = model_loader::obj(path, model::NORMAL | model::TEXCOORD, false);
+    std::cout << path << ": " << mesh.indices.size() / 3 << " triangles\n" << std::endl;
+    optimize("as exported", mesh);
+
+    // triangles in random order, the worst case for the caches
+    std::mt19937 gen(7);
+    vector<std::size_t> order(mesh.indices.size() / 3);
+    for (std::size_t i = 0; i < order.size(); ++i) { order[i] = i; }
+    std::shuffle(order.begin(), order.end(), gen);
+    vector<GLuint> shuffled;
+    shuffled.reserve(mesh.indices.size());
+    for (std::size_t triangle : order) { shuffled.insert(shuffled.end(), mesh.indices.begin() + std::ptrdiff_t(3 * triangle), mesh.indices.begin() + std::ptrdiff_t(3 * triangle + 3)); }
+    mesh.indices.swap(shuffled);
+    optimize("shuffled", mesh);
+    return EXIT_SUCCESS;
+}
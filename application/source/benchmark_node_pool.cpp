@@ -0,0 +1,104 @@
+// Builds, reparents and tears down a scene of pooled nodes, compared to allocating every
+// node separately with make_shared as the scenegraph did before.
+// usage: benchmark_node_pool [node count] [branching factor]
+#include "SceneGraph.hpp"
+#include "Node.hpp"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+using std::vector;
+
+// node layout of the old scenegraph: every node is its own heap allocation, children in a list of shared_ptr
+struct SharedNode {
+    std::string name;
+    glm::mat4 localTransform;
+    glm::mat4 worldTransform;
+    SharedNode* parent = nullptr;
+    std::list<std::shared_ptr<SharedNode>> children;
+};
+
+template<typename Function>
+static double measure_ms(Function const& func) {
+    auto start = std::chrono::high_resolution_clock::now();
+    func();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void report(std::string const& phase, double sharedMs, double pooledMs) {
+    std::cout << std::left << std::setw(10) << phase << std::right << std::fixed << std::setprecision(2)
+              << "make_shared " << std::setw(9) << sharedMs << " ms   pool " << std::setw(9) << pooledMs << " ms"
+              << std::setw(8) << sharedMs / pooledMs << "x" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t nodeCount = argc > 1 ? std::size_t(std::atoi(argv[1])) : 1000000u;
+    std::size_t branching = argc > 2 ? std::size_t(std::atoi(argv[2])) : 4u;
+    std::cout << "nodes: " << nodeCount << ", branching: " << branching << std::endl;
+
+    std::shared_ptr<SharedNode> sharedRoot;
+    vector<SharedNode*> sharedNodes(nodeCount);
+    auto sharedBuild = [&]() {
+        sharedRoot = std::make_shared<SharedNode>();
+        sharedRoot->name = "Root";
+        sharedNodes[0] = sharedRoot.get();
+        for (std::size_t i = 1; i < nodeCount; ++i) {
+            auto node = std::make_shared<SharedNode>();
+            node->name = "Node";
+            node->parent = sharedNodes[(i - 1) / branching];
+            node->parent->children.push_back(node);
+            sharedNodes[i] = node.get();
+        }
+    };
+    auto& scene = SceneGraph::getInstance();
+    vector<Node*> pooledNodes(nodeCount);
+    auto pooledBuild = [&]() {
+        scene.reserveNodes<Node>(nodeCount);
+        pooledNodes[0] = scene.createNode<Node>("Root");
+        scene.setRoot(pooledNodes[0]);
+        for (std::size_t i = 1; i < nodeCount; ++i) {
+            pooledNodes[i] = scene.createNode<Node>("Node");
+            pooledNodes[(i - 1) / branching]->addChild(pooledNodes[i]);
+        }
+    };
+
+    // 1. build
+    report("build", measure_ms(sharedBuild), measure_ms(pooledBuild));
+
+    // 2. move the second half of the nodes with their subtrees to other parents
+    std::size_t firstMoved = nodeCount / 2;
+    double sharedReparent = measure_ms([&]() {
+        for (std::size_t i = firstMoved; i < nodeCount; ++i) {
+            SharedNode* node = sharedNodes[i];
+            SharedNode* oldParent = node->parent;
+            for (auto it = oldParent->children.begin(); it != oldParent->children.end(); ++it) {
+                if (it->get() == node) {
+                    sharedNodes[i - firstMoved]->children.splice(sharedNodes[i - firstMoved]->children.end(), oldParent->children, it);
+                    break;
+                }
+            }
+            node->parent = sharedNodes[i - firstMoved];
+        }
+    });
+    double pooledReparent = measure_ms([&]() {
+        for (std::size_t i = firstMoved; i < nodeCount; ++i) { pooledNodes[i]->setParent(pooledNodes[i - firstMoved]); }
+    });
+    report("reparent", sharedReparent, pooledReparent);
+
+    // 3. tear down
+    report("teardown", measure_ms([&]() { sharedRoot.reset(); }), measure_ms([&]() { scene.clear(); }));
+
+    // 4. build again, the pool reuses its chunks and transform storage
+    report("rebuild", measure_ms(sharedBuild), measure_ms(pooledBuild));
+    sharedRoot.reset();
+    scene.clear();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+// Microbenchmark of obj parsing: tinyobjloader against model_loader::parse_obj with growing thread counts,
+// in MB/s of the file. Every result is compared to tinyobjloader's shapes. Without an obj path a sphere of
+// segments x segments / 2 quads is generated, with groups, materials, triangles, negative indices and exponents.
+// usage: benchmark_obj_parser [segments] [repetitions] [obj path]
+#include "model_loader.hpp"
+#include "TaskPool.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+using std::vector;
+
+static std::string const GENERATED_PATH = "benchmark_obj_parser.obj";
+
+static void generateSphere(std::string const& path, unsigned segments) {
+    unsigned rings = std::max(2u, segments / 2);
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    std::fprintf(file, "# generated by benchmark_obj_parser\no Sphere\n");
+    for (unsigned ring = 0; ring <= rings; ++ring) {
+        for (unsigned segment = 0; segment <= segments; ++segment) {
+            double theta = 3.14159265358979323846 * ring / rings, phi = 2.0 * 3.14159265358979323846 * segment / segments;
+            double x = std::sin(theta) * std::cos(phi), y = std::cos(theta), z = std::sin(theta) * std::sin(phi);
+            std::fprintf(file, "v %f %f %f\n", x, y, z);
+            // some coordinates in exponent notation, some lines with windows line breaks
+            std::fprintf(file, segment % 7 == 0 ? "vt %e %e\r\n" : "vt %f %f\n", double(segment) / segments, double(ring) / rings);
+            std::fprintf(file, "vn %f %f %f\n", x, y, z);
+        }
+    }
+    unsigned columns = segments + 1;
+    for (unsigned ring = 0; ring < rings; ++ring) {
+        if (ring % 64 == 0) { std::fprintf(file, "g band_%u\nusemtl material_%u\n", ring / 64, ring / 64 % 3); }
+        for (unsigned segment = 0; segment < segments; ++segment) {
+            unsigned a = ring * columns + segment + 1, b = a + 1, c = a + columns + 1, d = a + columns;
+            if (segment % 5 == 0) { // two triangles, the second with indices relative to the vertex count
+                int total = int((rings + 1) * columns);
+                std::fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+                std::fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", int(a) - total - 1, int(a) - total - 1, int(a) - total - 1,
+                             int(c) - total - 1, int(c) - total - 1, int(c) - total - 1, int(d) - total - 1, int(d) - total - 1, int(d) - total - 1);
+            }
+            else if (segment % 5 == 1) { // positions and normals only
+                std::fprintf(file, "f %u//%u %u//%u %u//%u %u//%u\n", a, a, b, b, c, c, d, d);
+            }
+            else {
+                std::fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c, d, d, d);
+            }
+        }
+    }
+    std::fclose(file);
+}
+
+static bool isEqual(vector<tinyobj::shape_t> const& shapes, vector<tinyobj::shape_t> const& reference) {
+    if (shapes.size() != reference.size()) { return false; }
+    for (std::size_t i = 0; i < shapes.size(); ++i) {
+        tinyobj::mesh_t const& mesh = shapes[i].mesh;
+        tinyobj::mesh_t const& expected = reference[i].mesh;
+        if (shapes[i].name != reference[i].name || mesh.positions != expected.positions || mesh.normals != expected.normals
+            || mesh.texcoords != expected.texcoords || mesh.indices != expected.indices || mesh.material_ids != expected.material_ids) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Function>
+static double measureMs(unsigned repetitions, Function const& function) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < repetitions; ++i) { function(); }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / repetitions;
+}
+
+static void report(std::string const& name, double ms, double megabytes, double referenceMs, bool isMatching) {
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1) << std::setw(10) << ms << " ms"
+              << std::setw(10) << megabytes / (ms / 1000.0) << " MB/s" << std::setw(8) << referenceMs / ms << "x"
+              << (isMatching ? "" : "  MISMATCH") << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned segments = argc > 1 ? unsigned(std::atoi(argv[1])) : 1000u;
+    unsigned repetitions = argc > 2 ? unsigned(std::atoi(argv[2])) : 3u;
+    std::string path = argc > 3 ? argv[3] : GENERATED_PATH;
+    if (argc <= 3) { generateSphere(path, segments); }
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    double megabytes = double(file.tellg()) / (1024.0 * 1024.0);
+
+    vector<tinyobj::shape_t> reference;
+    vector<tinyobj::material_t> materials;
+    std::string referenceError;
+    double referenceMs = measureMs(repetitions, [&] { referenceError = tinyobj::LoadObj(reference, materials, path.c_str()); });
+    std::size_t triangles = 0;
+    for (auto const& shape : reference) { triangles += shape.mesh.indices.size() / 3; }
+    std::cout << path << ": " << std::fixed << std::setprecision(1) << megabytes << " MB, " << reference.size() << " shapes, "
+              << triangles << " triangles, repetitions: " << repetitions << std::endl;
+    report("tinyobjloader", referenceMs, megabytes, referenceMs, true);
+
+    bool isMatching = true;
+    unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; ; threads = std::min(threads * 2, hardwareThreads)) {
+        TaskPool taskPool{threads};
+        vector<tinyobj::shape_t> shapes;
+        std::string error;
+        double ms = measureMs(repetitions, [&] {
+            materials.clear();
+            error = model_loader::parse_obj(shapes, materials, path, &taskPool);
+        });
+        bool isEqualResult = error == referenceError && isEqual(shapes, reference);
+        isMatching = isMatching && isEqualResult;
+        report("parse_obj x" + std::to_string(threads), ms, megabytes, referenceMs, isEqualResult);
+        if (threads == hardwareThreads) { break; }
+    }
+
+    if (argc <= 3) { std::remove(GENERATED_PATH.c_str()); }
+    return isMatching ? EXIT_SUCCESS : EXIT_FAILURE;
+}
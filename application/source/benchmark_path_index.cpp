@@ -0,0 +1,89 @@
+// Looks up children and full paths among many siblings through SceneGraph's path index,
+// compared to the linear scan with string compares that getChild() used before.
+// usage: benchmark_path_index [sibling count] [lookups]
+#include "SceneGraph.hpp"
+#include "Node.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+// node layout of the old scenegraph, children in a list of shared_ptr searched by name
+struct SharedNode {
+    string name;
+    std::list<std::shared_ptr<SharedNode>> children;
+    SharedNode* getChild(string const& childName) {
+        for (auto& child : children) {
+            if (child->name == childName) { return child.get(); }
+        }
+        return nullptr;
+    }
+};
+
+template<typename Function>
+static double measure_ns_per_lookup(std::size_t lookups, Function const& func) {
+    auto start = std::chrono::high_resolution_clock::now();
+    func();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / double(lookups);
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t siblingCount = argc > 1 ? std::size_t(std::atoi(argv[1])) : 10000u;
+    std::size_t lookups = argc > 2 ? std::size_t(std::atoi(argv[2])) : 100000u;
+
+    // Root/Planet i/Planet i Geometry
+    SharedNode sharedRoot;
+    auto& scene = SceneGraph::getInstance();
+    Node* root = scene.createNode<Node>("Root");
+    scene.setRoot(root);
+    vector<string> names(siblingCount);
+    for (std::size_t i = 0; i < siblingCount; ++i) {
+        names[i] = "Planet " + std::to_string(i);
+        auto holder = std::make_shared<SharedNode>();
+        holder->name = names[i];
+        auto geometry = std::make_shared<SharedNode>();
+        geometry->name = names[i] + " Geometry";
+        holder->children.push_back(geometry);
+        sharedRoot.children.push_back(holder);
+
+        Node* node = scene.createNode<Node>(names[i]);
+        root->addChild(node);
+        node->addChild(scene.createNode<Node>(names[i] + " Geometry"));
+    }
+
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<std::size_t> dist(0, siblingCount - 1);
+    vector<string> queries(lookups), paths(lookups);
+    for (std::size_t i = 0; i < lookups; ++i) {
+        queries[i] = names[dist(gen)];
+        paths[i] = "Root/" + queries[i] + "/" + queries[i] + " Geometry";
+    }
+
+    std::size_t found = 0;
+    double scanTime = measure_ns_per_lookup(lookups, [&]() {
+        for (auto const& query : queries) { found += sharedRoot.getChild(query) ? 1 : 0; }
+    });
+    double indexTime = measure_ns_per_lookup(lookups, [&]() {
+        for (auto const& query : queries) { found += root->getChild(query) ? 1 : 0; }
+    });
+    double pathTime = measure_ns_per_lookup(lookups, [&]() {
+        for (auto const& path : paths) { found += scene.findNode(path) ? 1 : 0; }
+    });
+
+    std::cout << "siblings: " << siblingCount << ", lookups: " << lookups << ", found: " << found << std::endl
+              << std::fixed << std::setprecision(1)
+              << "getChild linear scan  " << std::setw(10) << scanTime << " ns/lookup" << std::endl
+              << "getChild path index   " << std::setw(10) << indexTime << " ns/lookup" << std::endl
+              << "findNode full path    " << std::setw(10) << pathTime << " ns/lookup" << std::endl;
+    scene.clear();
+    return EXIT_SUCCESS;
+}
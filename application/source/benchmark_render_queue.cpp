@@ -0,0 +1,82 @@
+// Sorts the draw calls of a synthetic frame with RenderQueue's radix sort and with std::sort
+// of the same keys, and reports how many state changes remain after sorting.
+// usage: benchmark_render_queue [draw count] [frames]
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+using std::vector;
+
+struct Draw {
+    RenderPass pass;
+    DrawState state;
+    float depth;
+};
+
+// GL state changes when the draws are submitted in the given order
+static unsigned countStateChanges(vector<Draw> const& draws) {
+    unsigned changes = 0;
+    for (std::size_t i = 0; i < draws.size(); ++i) {
+        if (i == 0) { changes += 3; continue; }
+        changes += draws[i].state.program != draws[i - 1].state.program ? 1 : 0;
+        changes += draws[i].state.texture != draws[i - 1].state.texture ? 1 : 0;
+        changes += draws[i].state.vertexArray != draws[i - 1].state.vertexArray ? 1 : 0;
+    }
+    return changes;
+}
+
+static bool isStateOrdered(Draw const& a, Draw const& b) {
+    if (a.pass != b.pass) { return a.pass < b.pass; }
+    if (a.state.program != b.state.program) { return a.state.program < b.state.program; }
+    if (a.state.texture != b.state.texture) { return a.state.texture < b.state.texture; }
+    if (a.state.vertexArray != b.state.vertexArray) { return a.state.vertexArray < b.state.vertexArray; }
+    return a.depth < b.depth;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t drawCount = argc > 1 ? std::size_t(std::atoi(argv[1])) : 100000u;
+    unsigned frames = argc > 2 ? unsigned(std::atoi(argv[2])) : 50u;
+
+    // few programs, some dozen textures and vertex arrays, like the solar system with more bodies
+    std::mt19937 random(42);
+    vector<Draw> draws(drawCount);
+    for (auto& draw : draws) {
+        draw.pass = random() % 16 == 0 ? RenderPass::Background : RenderPass::Opaque;
+        draw.state.program = GLuint(1 + random() % 5);
+        draw.state.textureTarget = GL_TEXTURE_2D;
+        draw.state.texture = GLuint(1 + random() % 32);
+        draw.state.vertexArray = GLuint(1 + random() % 8);
+        draw.depth = std::uniform_real_distribution<float>(0.1f, 1000.0f)(random);
+    }
+
+    RenderQueue queue;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned frame = 0; frame < frames; ++frame) {
+        queue.clear();
+        for (std::size_t i = 0; i < draws.size(); ++i) { queue.push(draws[i].pass, draws[i].state, draws[i].depth, 0, unsigned(i)); }
+        queue.sort();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double radixMs = std::chrono::duration<double, std::milli>(end - start).count() / frames;
+
+    vector<Draw> sorted;
+    start = std::chrono::high_resolution_clock::now();
+    for (unsigned frame = 0; frame < frames; ++frame) {
+        sorted = draws;
+        std::sort(sorted.begin(), sorted.end(), isStateOrdered);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double stdSortMs = std::chrono::duration<double, std::milli>(end - start).count() / frames;
+
+    std::cout << "draws: " << drawCount << ", frames: " << frames << std::endl
+              << std::fixed << std::setprecision(3)
+              << "RenderQueue push + radix sort " << std::setw(9) << radixMs << " ms/frame" << std::endl
+              << "std::sort by state            " << std::setw(9) << stdSortMs << " ms/frame" << std::endl
+              << "state changes unsorted " << countStateChanges(draws) << ", sorted " << countStateChanges(sorted) << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+// Runs the per frame SceneUpdater on a synthetic scene with every thread count up to the
+// hardware concurrency and reports the speedup over the single threaded update.
+// usage: benchmark_scene_update [node count] [frames] [max threads]
+#include "SceneGraph.hpp"
+#include "SceneUpdater.hpp"
+#include "GeometryNode.hpp"
+#include "Node.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+using glm::fmat4;
+using glm::fvec3;
+using std::vector;
+
+// Root -> systems -> planet holders -> planet geometry -> moon holders -> moon geometry
+static void buildScene(std::size_t nodeCount) {
+    auto& scene = SceneGraph::getInstance();
+    scene.reserveNodes<Node>(nodeCount / 2);
+    scene.reserveNodes<GeometryNode>(nodeCount / 2);
+    Node* root = scene.createNode<Node>("Root");
+    scene.setRoot(root);
+    const std::size_t planetsPerSystem = 10, moonsPerPlanet = 4;
+    const std::size_t nodesPerSystem = 2 + planetsPerSystem * (2 + moonsPerPlanet * 2);
+    for (std::size_t system = 0; system < nodeCount / nodesPerSystem; ++system) {
+        Node* systemNode = scene.createNode<Node>("System " + std::to_string(system));
+        systemNode->setLocalTransform(glm::translate(fmat4{}, fvec3{float(system % 100) * 100.0f, 0.0f, float(system / 100) * 100.0f}));
+        root->addChild(systemNode);
+        systemNode->addChild(scene.createNode<GeometryNode>("Star", "planetShader", model_object{}, fvec3{1.0f}));
+        for (std::size_t planet = 0; planet < planetsPerSystem; ++planet) {
+            Node* holder = scene.createNode<Node>("Planet Holder");
+            GeometryNode* planetGeo = scene.createNode<GeometryNode>("Planet", "planetShader", model_object{}, fvec3{1.0f});
+            planetGeo->setLocalTransform(glm::translate(fmat4{}, fvec3{float(planet + 1) * 5.0f, 0.0f, 0.0f}));
+            systemNode->addChild(holder);
+            holder->addChild(planetGeo);
+            for (std::size_t moon = 0; moon < moonsPerPlanet; ++moon) {
+                Node* moonHolder = scene.createNode<Node>("Moon Holder");
+                GeometryNode* moonGeo = scene.createNode<GeometryNode>("Moon", "planetShader", model_object{}, fvec3{1.0f});
+                moonGeo->setLocalTransform(glm::translate(fmat4{}, fvec3{float(moon + 1), 0.0f, 0.0f}));
+                planetGeo->addChild(moonHolder);
+                moonHolder->addChild(moonGeo);
+            }
+        }
+    }
+}
+
+static std::size_t countDraws(SceneUpdater const& updater) {
+    std::size_t drawCount = 0;
+    for (auto const& buffer : updater.getDrawBuffers()) { drawCount += buffer.size(); }
+    return drawCount;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t nodeCount = argc > 1 ? std::size_t(std::atoi(argv[1])) : 1000000u;
+    unsigned frames = argc > 2 ? unsigned(std::atoi(argv[2])) : 20u;
+    unsigned hardwareThreads = argc > 3 ? unsigned(std::atoi(argv[3])) : std::max(std::thread::hardware_concurrency(), 1u);
+
+    buildScene(nodeCount);
+    std::cout << "nodes: " << SceneGraph::getInstance().getTransforms().size() << ", frames: " << frames
+              << ", max threads: " << hardwareThreads << std::endl;
+
+    vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < hardwareThreads; threads *= 2) { threadCounts.push_back(threads); }
+    threadCounts.push_back(hardwareThreads);
+
+    double singleThreadedMs = 0.0;
+    for (unsigned threads : threadCounts) {
+        SceneUpdater updater(threads);
+        updater.setSingleThreaded(threads == 1);
+        // every holder rotates in every frame, so every world transform is recomputed
+        updater.setAnimation([](Node& node) {
+            if (node.getFirstChild() && node.getFirstChild()->getType() == NodeType::Geometry) {
+                node.setLocalTransform(glm::rotate(node.getLocalTransform(), 0.01f, fvec3{0.0f, 1.0f, 0.0f}));
+            }
+        });
+        updater.update(); // warm up
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (unsigned frame = 0; frame < frames; ++frame) { updater.update(); }
+        auto end = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count() / frames;
+
+        if (threads == 1) { singleThreadedMs = ms; }
+        std::cout << std::setw(3) << threads << " threads " << std::fixed << std::setprecision(2) << std::setw(9) << ms << " ms/frame"
+                  << std::setw(7) << singleThreadedMs / ms << "x  draws " << countDraws(updater) << std::endl;
+    }
+    SceneGraph::getInstance().clear();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+// Microbenchmarks of the simd_math batch kernels for every supported instruction set
+// against plain glm, including the largest deviation from the glm result.
+// usage: benchmark_simd_math [matrix count] [iterations]
+#include "simd_math.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using glm::fmat4;
+using std::vector;
+
+template<typename Function>
+static double measure_ns_per_matrix(unsigned iterations, std::size_t count, Function const& func) {
+    func(); // warm up caches
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < iterations; ++i) { func(); }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (double(iterations) * double(count));
+}
+
+static float max_difference(vector<fmat4> const& lhs, vector<fmat4> const& rhs) {
+    float difference = 0.0f;
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 4; ++r) { difference = std::max(difference, std::abs(lhs[i][c][r] - rhs[i][c][r])); }
+        }
+    }
+    return difference;
+}
+
+static void report(std::string const& kernel, std::string const& variant, double nanoseconds, double glmNanoseconds, float difference) {
+    std::cout << std::left << std::setw(16) << kernel << std::setw(8) << variant
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2) << nanoseconds << " ns/matrix"
+              << std::setw(8) << glmNanoseconds / nanoseconds << "x"
+              << "   max diff " << std::scientific << std::setprecision(1) << difference << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::size_t(std::atoi(argv[1])) : 4096u;
+    unsigned iterations = argc > 2 ? unsigned(std::atoi(argv[2])) : 500u;
+
+    // random affine transforms like the ones in the scenegraph
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    auto randomAffine = [&]() {
+        fmat4 m = glm::translate(fmat4{}, glm::fvec3{dist(gen), dist(gen), dist(gen)} * 10.0f);
+        m = glm::rotate(m, dist(gen) * 3.14f, glm::normalize(glm::fvec3{dist(gen), dist(gen), dist(gen)} + glm::fvec3{0.0f, 0.0f, 2.0f}));
+        return glm::scale(m, glm::fvec3{1.5f + dist(gen)});
+    };
+    vector<fmat4> lhs(count), rhs(count), out(count), reference(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        lhs[i] = randomAffine();
+        rhs[i] = randomAffine();
+    }
+    fmat4 view = glm::inverse(randomAffine());
+
+    std::cout << "matrices: " << count << ", iterations: " << iterations
+              << ", detected: " << simd_math::name(simd_math::detect()) << std::endl;
+
+    vector<simd_math::instruction_set> sets{simd_math::instruction_set::scalar};
+    if (simd_math::detect() >= simd_math::instruction_set::sse) { sets.push_back(simd_math::instruction_set::sse); }
+    if (simd_math::detect() >= simd_math::instruction_set::avx) { sets.push_back(simd_math::instruction_set::avx); }
+
+    // 1. batched mat4 x mat4
+    double glmTime = measure_ns_per_matrix(iterations, count, [&]() {
+        for (std::size_t i = 0; i < count; ++i) { reference[i] = lhs[i] * rhs[i]; }
+    });
+    report("multiply", "glm", glmTime, glmTime, 0.0f);
+    for (auto set : sets) {
+        simd_math::force(set);
+        double time = measure_ns_per_matrix(iterations, count, [&]() { simd_math::multiply(lhs.data(), rhs.data(), out.data(), count); });
+        report("multiply", simd_math::name(set), time, glmTime, max_difference(out, reference));
+    }
+
+    // 2. affine inverse
+    glmTime = measure_ns_per_matrix(iterations, count, [&]() {
+        for (std::size_t i = 0; i < count; ++i) { reference[i] = glm::inverse(lhs[i]); }
+    });
+    report("affine_inverse", "glm", glmTime, glmTime, 0.0f);
+    for (auto set : sets) {
+        simd_math::force(set);
+        double time = measure_ns_per_matrix(iterations, count, [&]() { simd_math::affine_inverse(lhs.data(), out.data(), count); });
+        report("affine_inverse", simd_math::name(set), time, glmTime, max_difference(out, reference));
+    }
+
+    // 3. normal matrix as computed per draw call in ApplicationSolar::render()
+    glmTime = measure_ns_per_matrix(iterations, count, [&]() {
+        for (std::size_t i = 0; i < count; ++i) { reference[i] = glm::inverseTranspose(view * lhs[i]); }
+    });
+    report("normal_matrix", "glm", glmTime, glmTime, 0.0f);
+    for (auto set : sets) {
+        simd_math::force(set);
+        double time = measure_ns_per_matrix(iterations, count, [&]() { simd_math::normal_matrix(view, lhs.data(), out.data(), count); });
+        report("normal_matrix", simd_math::name(set), time, glmTime, max_difference(out, reference));
+    }
+
+    simd_math::force(simd_math::detect());
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+// Microbenchmark of the stream buffer: allocations of instance records of 108 bytes and of uniform blocks at the
+// uniform buffer offset alignment over many frames in a headless context, so every region and a growth are used.
+// Each offset has to be a multiple of its alignment from the start of the buffer, as baseInstance and
+// glBindBufferRange need, and the written records have to arrive there, which is read back at the end.
+// usage: benchmark_stream_buffer [frames] [records per frame]
+#include "StreamBuffer.hpp"
+#include "window_handler.hpp"
+
+#include <glbinding/gl/gl.h>
+#include <glbinding/Binding.h>
+using namespace gl;
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+using std::vector;
+
+static const size_t RECORD_SIZE = 108; // sizeof(DrawInstance) of the solar system
+static const size_t REGION_SIZE = 1 << 20;
+
+int main(int argc, char* argv[]) {
+    unsigned frames = argc > 1 ? unsigned(std::atoi(argv[1])) : 30u;
+    size_t records = argc > 2 ? size_t(std::atoi(argv[2])) : 1000u;
+
+    window_handler::headless_context* context = window_handler::initialize_headless(glm::uvec2{64, 64}, 3, 2);
+    if (!context) {
+        std::cerr << "Could not create a headless OpenGL context" << std::endl;
+        return EXIT_FAILURE;
+    }
+    GLint uniformAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+
+    bool isAligned = true, isWritten = true;
+    double allocateMs = 0.0;
+    {
+        StreamBuffer stream(REGION_SIZE);
+        vector<unsigned char> record(RECORD_SIZE);
+        for (unsigned frame = 0; frame < frames; ++frame) {
+            // a frame of a third of the region first, later one larger than the region so it grows
+            size_t count = frame == frames / 2 ? REGION_SIZE / RECORD_SIZE + records : records;
+            auto start = std::chrono::high_resolution_clock::now();
+            StreamBuffer::Allocation block = stream.allocate(64, size_t(uniformAlignment));
+            StreamBuffer::Allocation instances = stream.allocate(RECORD_SIZE * count, RECORD_SIZE);
+            allocateMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            isAligned = isAligned && block.offset % size_t(uniformAlignment) == 0;
+            if (instances.data) {
+                isAligned = isAligned && instances.offset % RECORD_SIZE == 0;
+                // the record i of the frame is filled with its baseInstance, read back from the buffer below
+                for (size_t i = 0; i < count; ++i) {
+                    std::memset(record.data(), int((instances.offset / RECORD_SIZE + i) & 0xff), RECORD_SIZE);
+                    std::memcpy(static_cast<unsigned char*>(instances.data) + i * RECORD_SIZE, record.data(), RECORD_SIZE);
+                }
+                stream.flush();
+                vector<unsigned char> readBack(RECORD_SIZE * count);
+                glFinish();
+                glBindBuffer(GL_COPY_READ_BUFFER, stream.getHandle());
+                glGetBufferSubData(GL_COPY_READ_BUFFER, GLintptr(instances.offset), GLsizeiptr(readBack.size()), readBack.data());
+                for (size_t i = 0; i < count && isWritten; ++i) {
+                    isWritten = readBack[i * RECORD_SIZE] == ((instances.offset / RECORD_SIZE + i) & 0xff);
+                }
+            }
+            stream.nextFrame();
+        }
+        std::cout << frames << " frames of " << records << " records of " << RECORD_SIZE << " bytes and a uniform block at alignment " << uniformAlignment
+                  << ", region " << REGION_SIZE << " grown to " << stream.getRegionSize() << " bytes, "
+                  << (stream.isPersistent() ? "persistent mapping" : "copy") << std::endl;
+        std::cout << "overflows: " << stream.getStatistics().overflows << ", stalls: " << stream.getStatistics().stalls
+                  << ", allocation " << std::fixed << std::setprecision(4) << allocateMs / frames << " ms per frame" << std::endl;
+    }
+    window_handler::close_headless(context);
+    std::cout << (isAligned && isWritten ? "" : "MISMATCH of offsets and alignments or of the written records\n");
+    return isAligned && isWritten ? EXIT_SUCCESS : EXIT_FAILURE;
+}
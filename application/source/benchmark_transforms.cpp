@@ -0,0 +1,114 @@
+// Compares the world transform update of the flat TransformHierarchy (one forward sweep
+// over contiguous arrays) with a pointer based node tree as Node used to store it.
+// usage: benchmark_transforms [node count] [iterations]
+#include "TransformHierarchy.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include <vector>
+using glm::mat4;
+using std::list;
+using std::shared_ptr;
+using std::vector;
+
+// node layout of the old scenegraph: matrices inside heap objects, children behind shared_ptr
+struct PointerNode {
+    PointerNode* parent = nullptr;
+    list<shared_ptr<PointerNode>> children;
+    mat4 localTransform;
+    mat4 worldTransform;
+
+    void updateWorldTransform() {
+        worldTransform = parent ? parent->worldTransform * localTransform : localTransform;
+        for (auto const& child : children) {
+            child->updateWorldTransform();
+        }
+    }
+};
+
+static const unsigned BRANCHING = 4; // children per node, gives a depth of ~9 levels for 200k nodes
+
+template<typename Function>
+static double measure_ms(unsigned iterations, Function const& func) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < iterations; ++i) { func(); }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned nodeCount = argc > 1 ? unsigned(std::atoi(argv[1])) : 200000u;
+    unsigned iterations = argc > 2 ? unsigned(std::atoi(argv[2])) : 20u;
+
+    // node i has parent (i - 1) / BRANCHING, so node 0 is the root
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> angle(0.0f, 6.28f);
+    vector<mat4> locals(nodeCount);
+    for (auto& local : locals) {
+        local = glm::rotate(glm::translate(mat4{}, glm::vec3{1.0f, 0.0f, 0.0f}), angle(gen), glm::vec3{0.0f, 1.0f, 0.0f});
+    }
+
+    // pointer tree, allocated in shuffled order to get the scattered heap of a long running application
+    vector<shared_ptr<PointerNode>> pointerNodes(nodeCount);
+    vector<unsigned> allocationOrder(nodeCount);
+    for (unsigned i = 0; i < nodeCount; ++i) { allocationOrder[i] = i; }
+    std::shuffle(allocationOrder.begin(), allocationOrder.end(), gen);
+    for (unsigned i : allocationOrder) {
+        pointerNodes[i] = std::make_shared<PointerNode>();
+        pointerNodes[i]->localTransform = locals[i];
+    }
+    for (unsigned i = 1; i < nodeCount; ++i) {
+        auto& parent = pointerNodes[(i - 1) / BRANCHING];
+        pointerNodes[i]->parent = parent.get();
+        parent->children.push_back(pointerNodes[i]);
+    }
+
+    // flat hierarchy with the same shape
+    TransformHierarchy hierarchy;
+    vector<TransformHierarchy::Handle> handles(nodeCount);
+    for (unsigned i = 0; i < nodeCount; ++i) {
+        handles[i] = hierarchy.allocate();
+        hierarchy.setLocalTransform(handles[i], locals[i]);
+        if (i > 0) { hierarchy.setParent(handles[i], handles[(i - 1) / BRANCHING]); }
+    }
+    hierarchy.update(); // initial sort
+
+    // every frame the root changes, so all world transforms have to be recomputed
+    mat4 rootTransform{};
+    double pointerMs = measure_ms(iterations, [&]() {
+        rootTransform = glm::rotate(rootTransform, 0.01f, glm::vec3{0.0f, 1.0f, 0.0f});
+        pointerNodes[0]->localTransform = rootTransform;
+        pointerNodes[0]->updateWorldTransform();
+    });
+    double flatMs = measure_ms(iterations, [&]() {
+        rootTransform = glm::rotate(rootTransform, 0.01f, glm::vec3{0.0f, 1.0f, 0.0f});
+        hierarchy.setLocalTransform(handles[0], rootTransform);
+        hierarchy.update();
+    });
+
+    // both paths must produce the same matrices for the same root
+    pointerNodes[0]->localTransform = rootTransform;
+    pointerNodes[0]->updateWorldTransform();
+    mat4 const& pointerLeaf = pointerNodes[nodeCount - 1]->worldTransform;
+    mat4 const& flatLeaf = hierarchy.getWorldTransform(handles[nodeCount - 1]);
+    float maxError = 0.0f;
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) { maxError = std::max(maxError, std::abs(pointerLeaf[c][r] - flatLeaf[c][r])); }
+    }
+
+    // per node: read local, write world (parent world is hot in cache for both)
+    double bytes = double(nodeCount) * 2.0 * sizeof(mat4);
+    std::cout << "nodes: " << nodeCount << ", iterations: " << iterations << std::endl;
+    std::cout << "pointer tree:   " << pointerMs << " ms/update, " << bytes / (pointerMs * 1.0e6) << " GB/s" << std::endl;
+    std::cout << "flat hierarchy: " << flatMs << " ms/update, " << bytes / (flatMs * 1.0e6) << " GB/s" << std::endl;
+    std::cout << "speedup: " << pointerMs / flatMs << "x, max difference: " << maxError << std::endl;
+    return maxError < 1.0e-3f ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,86 @@
+// Microbenchmark of quantized vertex formats: vertex and index bytes of a loaded obj as floats and packed by
+// model_loader::pack, the time to pack and the largest errors, the angle of normals and the texture coordinate
+// distance in texels of a 1024 texture like those of the planets. Tangents are checked on generated unit vectors, as obj has none.
+// usage: benchmark_vertex_packing [obj path]
+#include "model_loader.hpp"
+#include "vertex_packing.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using std::vector;
+
+static double degrees(glm::fvec3 const& a, glm::fvec3 const& b) {
+    return std::acos(std::min(1.0, double(glm::dot(glm::normalize(a), glm::normalize(b))))) * 180.0 / 3.14159265358979323846;
+}
+
+static void reportBytes(char const* name, std::size_t vertexBytes, std::size_t indexBytes, std::size_t floatBytes) {
+    std::cout << std::left << std::setw(8) << name << std::right << std::setw(10) << vertexBytes << " vertex bytes" << std::setw(10) << indexBytes
+              << " index bytes" << std::fixed << std::setprecision(1) << std::setw(8) << 100.0 * double(vertexBytes + indexBytes) / double(floatBytes) << " %" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "resources/models/sphere.obj";
+    model mesh = model_loader::obj(path, model::NORMAL | model::TEXCOORD);
+    auto start = std::chrono::high_resolution_clock::now();
+    mesh_data packed = model_loader::pack(mesh);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::size_t floatVertexBytes = mesh.vertex_num * std::size_t(mesh.vertex_bytes), floatIndexBytes = mesh.indices.size() * sizeof(GLuint);
+    std::size_t packedIndexBytes = packed.index_num * (packed.index_type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+    std::cout << path << ": " << mesh.vertex_num << " vertices, " << mesh.indices.size() << " indices, packed in "
+              << std::fixed << std::setprecision(3) << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    reportBytes("float", floatVertexBytes, floatIndexBytes, floatVertexBytes + floatIndexBytes);
+    reportBytes("packed", packed.vertex_num * std::size_t(packed.vertex_bytes), packedIndexBytes, floatVertexBytes + floatIndexBytes);
+
+    vector<model::attribute> sources = vertex_packing::formats(mesh);
+    double normalError = 0.0, texcoordError = 0.0, positionError = 0.0;
+    for (std::size_t vertex = 0; vertex < mesh.vertex_num; ++vertex) {
+        void const* source = mesh.data.data() + vertex * std::size_t(mesh.vertex_bytes) / sizeof(GLfloat);
+        void const* target = static_cast<unsigned char const*>(packed.vertices) + vertex * std::size_t(packed.vertex_bytes);
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+            glm::fvec4 expected = vertex_packing::read(source, sources[i]), actual = vertex_packing::read(target, packed.formats[i]);
+            if (sources[i].flag == model::NORMAL.flag) {
+                normalError = std::max(normalError, degrees(glm::fvec3{expected.x, expected.y, expected.z}, glm::fvec3{actual.x, actual.y, actual.z}));
+            }
+            else if (sources[i].flag == model::TEXCOORD.flag) {
+                texcoordError = std::max(texcoordError, 1024.0 * double(glm::length(glm::fvec2{expected.x, expected.y} - glm::fvec2{actual.x, actual.y})));
+            }
+            else {
+                positionError = std::max(positionError, double(glm::length(expected - actual)));
+            }
+        }
+    }
+    bool isIndexEqual = true;
+    for (std::size_t i = 0; i < packed.index_num; ++i) {
+        GLuint index = packed.index_type == GL_UNSIGNED_SHORT ? static_cast<GLushort const*>(packed.indices)[i] : static_cast<GLuint const*>(packed.indices)[i];
+        isIndexEqual = isIndexEqual && index == mesh.indices[i];
+    }
+
+    // unit tangents in 10_10_10_2, with the handedness in w
+    std::mt19937 gen(7);
+    std::normal_distribution<float> distribution;
+    double tangentError = 0.0;
+    bool isHandednessEqual = true;
+    for (int i = 0; i < 100000; ++i) {
+        glm::fvec4 tangent{glm::normalize(glm::fvec3{distribution(gen), distribution(gen), distribution(gen)}), i % 2 == 0 ? 1.0f : -1.0f};
+        std::uint32_t encoded = vertex_packing::snorm_10_10_10_2(tangent);
+        glm::fvec4 decoded = vertex_packing::read(&encoded, model::TANGENT_PACKED);
+        tangentError = std::max(tangentError, degrees(glm::fvec3{tangent.x, tangent.y, tangent.z}, glm::fvec3{decoded.x, decoded.y, decoded.z}));
+        isHandednessEqual = isHandednessEqual && decoded.w == tangent.w;
+    }
+
+    std::cout << std::setprecision(4) << "largest errors: normal " << normalError << " degrees, texture coordinates " << texcoordError
+              << " texels, position " << positionError << ", tangent " << tangentError << " degrees" << std::endl;
+    bool isCorrect = isIndexEqual && isHandednessEqual && positionError == 0.0;
+    std::cout << (isCorrect ? "" : "MISMATCH of indices, positions or handedness\n");
+    return isCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}
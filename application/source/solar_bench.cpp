@@ -0,0 +1,238 @@
+// Regression benchmark of the solar system renderer on procedurally generated scenes. The camera follows a
+// fixed path while the scene animates with a fixed timestep, afterwards frame time percentiles, CPU time per
+// profiler scope, GPU pass times, draw calls and drawn triangles of the measured frames are written as JSON.
+// usage: solar_bench [resource path] [--systems=N] [--planets=M] [--moons=K] [--depth=D] [--stars=S] [--seed=X]
+//                    [--path=orbit|flyby|close] [--lod=0|1] [--warmup=W] [--output=FILE] [options of Application::run, e.g. --headless --frames=N]
+#include "application_solar.hpp"
+#include "SceneGraph.hpp"
+#include "CameraNode.hpp"
+#include "Profiler.hpp"
+#include "utils.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+using glm::fmat4;
+using glm::fvec3;
+using std::map;
+using std::string;
+using std::vector;
+
+struct BenchOptions {
+	GeneratedScene scene;
+	string path = "orbit";
+	unsigned warmup = 10; // first frames are not measured, they include uploads and first use of programs
+	string output = "solar_bench.json";
+	unsigned frames = 0;
+	unsigned lod = 1; // levels of detail of the planets, 0 draws every planet with the full mesh
+};
+static BenchOptions options;
+
+class SolarBench : public ApplicationSolar {
+	public:
+		SolarBench(std::string const& resource_path);
+		// move the camera along the path, then animate
+		void update();
+		// count draw calls of the frame
+		void render() const;
+		void resizeCallback(unsigned width, unsigned height);
+		// write the report
+		void finish();
+
+	private:
+		// far plane behind the whole generated scene
+		void setProjection(float aspect);
+		// camera world transform at t in [0, 1), the path is followed once per run
+		fmat4 cameraTransform(float t) const;
+
+		unsigned _frame;
+		mutable vector<unsigned> _drawCalls; // per frame
+		mutable vector<size_t> _drawnTriangles;
+		vector<size_t> _visibleNodes;
+};
+
+SolarBench::SolarBench(std::string const& resource_path)
+	: ApplicationSolar{resource_path, &options.scene}
+	, _frame{0}
+{
+	setProjection(initial_aspect_ratio);
+	Profiler::getInstance().setFrameCount(options.frames + 1); // keep every frame of the run
+	setLodEnabled(options.lod != 0);
+	_drawCalls.reserve(options.frames);
+	_drawnTriangles.reserve(options.frames);
+	_visibleNodes.reserve(options.frames);
+}
+
+void SolarBench::setProjection(float aspect) {
+	float farPlane = std::max(100.0f, 4.0f * getSceneRadius());
+	SceneGraph::getInstance().getCamera()->setProjectionMatrix(glm::perspective(glm::radians(60.0f), aspect, 0.1f, farPlane));
+	uploadProjection();
+}
+
+void SolarBench::resizeCallback(unsigned width, unsigned height) {
+	ApplicationSolar::resizeCallback(width, height);
+	setProjection(float(width) / float(height));
+}
+
+fmat4 SolarBench::cameraTransform(float t) const {
+	float angle = 2.0f * 3.14159265358979323846f * t;
+	float radius = getSceneRadius();
+	fvec3 eye, target{0.0f};
+	if (options.path == "flyby") { // low straight line across the systems
+		eye = fvec3{(2.0f * t - 1.0f) * radius, 4.0f, 0.3f * radius};
+		target = eye + fvec3{1.0f, -0.1f, -0.2f};
+	}
+	else if (options.path == "close") { // between the planets of the center
+		eye = fvec3{15.0f * std::cos(angle), 3.0f, 15.0f * std::sin(angle)};
+	}
+	else { // orbit, the whole scene in view
+		eye = fvec3{1.2f * radius * std::cos(angle), 0.3f * radius, 1.2f * radius * std::sin(angle)};
+	}
+	return glm::inverse(glm::lookAt(eye, target, fvec3{0.0f, 1.0f, 0.0f}));
+}
+
+void SolarBench::update() {
+	float t = options.frames > 0 ? float(_frame) / float(options.frames) : 0.0f;
+	SceneGraph::getInstance().getCamera()->setLocalTransform(cameraTransform(t));
+	ApplicationSolar::update();
+	_visibleNodes.push_back(getCullStatistics().visible);
+	++_frame;
+}
+
+void SolarBench::render() const {
+	ApplicationSolar::render();
+	_drawCalls.push_back(getDrawCalls());
+	_drawnTriangles.push_back(getDrawnTriangles());
+}
+
+// sorted has to be sorted, nearest rank
+static double percentile(vector<double> const& sorted, double p) {
+	if (sorted.empty()) { return 0.0; }
+	return sorted[std::min(sorted.size() - 1, size_t(p * double(sorted.size())))];
+}
+
+static void writeStatistics(std::ostream& stream, vector<double> values) {
+	std::sort(values.begin(), values.end());
+	double sum = 0.0;
+	for (double value : values) { sum += value; }
+	stream << "{\"mean\": " << (values.empty() ? 0.0 : sum / double(values.size())) << ", \"min\": " << (values.empty() ? 0.0 : values.front())
+	       << ", \"p50\": " << percentile(values, 0.5) << ", \"p95\": " << percentile(values, 0.95) << ", \"p99\": " << percentile(values, 0.99)
+	       << ", \"max\": " << (values.empty() ? 0.0 : values.back()) << ", \"samples\": " << values.size() << "}";
+}
+
+void SolarBench::finish() {
+	// milliseconds of the measured frames, scopes of one name are summed over all threads
+	vector<double> frameTimes, drawCalls, drawnTriangles, visibleNodes;
+	map<string, vector<double>> cpuPhases, gpuPasses;
+	for (auto const& frame : Profiler::getInstance().getFrames()) {
+		if (frame.index < options.warmup || frame.index >= _drawCalls.size()) { continue; }
+		frameTimes.push_back(frame.duration / 1000.0);
+		drawCalls.push_back(double(_drawCalls[size_t(frame.index)]));
+		drawnTriangles.push_back(double(_drawnTriangles[size_t(frame.index)]));
+		visibleNodes.push_back(double(_visibleNodes[size_t(frame.index)]));
+		map<string, double> cpuTimes, gpuTimes;
+		for (auto const& scope : frame.scopes) {
+			(scope.thread == Profiler::GPU_THREAD ? gpuTimes : cpuTimes)[scope.name] += scope.duration / 1000.0;
+		}
+		for (auto const& each : cpuTimes) { cpuPhases[each.first].push_back(each.second); }
+		for (auto const& each : gpuTimes) { gpuPasses[each.first].push_back(each.second); } // the last frames may miss results
+	}
+
+	std::ofstream file(options.output);
+	file << std::fixed << std::setprecision(4);
+	GeneratedScene const& scene = options.scene;
+	file << "{\n  \"scene\": {\"systems\": " << scene.systems << ", \"planets\": " << scene.planets << ", \"moons\": " << scene.moons
+	     << ", \"depth\": " << scene.depth << ", \"stars\": " << scene.stars << ", \"seed\": " << scene.seed
+	     << ", \"nodes\": " << SceneGraph::getInstance().getTransforms().size()
+	     << ", \"geometry_nodes\": " << SceneGraph::getInstance().getGeometryNodes().size() << "},\n"
+	     << "  \"run\": {\"path\": \"" << options.path << "\", \"lod\": " << options.lod << ", \"frames\": " << options.frames << ", \"warmup\": " << options.warmup << "},\n"
+	     << "  \"frame_ms\": ";
+	writeStatistics(file, frameTimes);
+	file << ",\n  \"draw_calls\": ";
+	writeStatistics(file, drawCalls);
+	file << ",\n  \"triangles\": ";
+	writeStatistics(file, drawnTriangles);
+	file << ",\n  \"visible_nodes\": ";
+	writeStatistics(file, visibleNodes);
+	auto writePhases = [&file](char const* name, map<string, vector<double>> const& phases) {
+		file << ",\n  \"" << name << "\": {";
+		bool isFirst = true;
+		for (auto const& each : phases) {
+			file << (isFirst ? "\n" : ",\n") << "    \"" << each.first << "\": ";
+			writeStatistics(file, each.second);
+			isFirst = false;
+		}
+		file << (phases.empty() ? "}" : "\n  }");
+	};
+	writePhases("cpu_ms", cpuPhases);
+	writePhases("gpu_ms", gpuPasses);
+	file << "\n}\n";
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+	if (file) {
+		std::cout << "Wrote " << options.output << ", frame ms p50 " << percentile(frameTimes, 0.5) << ", p95 " << percentile(frameTimes, 0.95)
+		          << ", p99 " << percentile(frameTimes, 0.99) << std::endl;
+	}
+	else {
+		std::cerr << "Could not write " << options.output << std::endl;
+	}
+}
+
+// true if argument is --name=value, value is parsed with format
+template<typename T>
+static bool readOption(string const& argument, char const* name, char const* format, T& value) {
+	string prefix = string("--") + name + "=";
+	if (argument.compare(0, prefix.size(), prefix) != 0) { return false; }
+	if (std::sscanf(argument.c_str() + prefix.size(), format, &value) != 1) {
+		std::cerr << "Invalid option " << argument << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	// options of the benchmark are consumed, all others are passed on to Application::run
+	vector<char*> arguments;
+	static char defaultFrames[] = "--frames=600";
+	bool hasFrames = false;
+	GeneratedScene& scene = options.scene;
+	for (int i = 0; i < argc; ++i) {
+		string argument = argv[i];
+		if (i > 0 && (readOption(argument, "systems", "%u", scene.systems) || readOption(argument, "planets", "%u", scene.planets)
+		              || readOption(argument, "moons", "%u", scene.moons) || readOption(argument, "depth", "%u", scene.depth)
+		              || readOption(argument, "stars", "%u", scene.stars) || readOption(argument, "seed", "%u", scene.seed)
+		              || readOption(argument, "lod", "%u", options.lod) || readOption(argument, "warmup", "%u", options.warmup))) {
+			continue;
+		}
+		if (argument.compare(0, 7, "--path=") == 0) {
+			options.path = argument.substr(7);
+			continue;
+		}
+		if (argument.compare(0, 9, "--output=") == 0) {
+			options.output = argument.substr(9);
+			continue;
+		}
+		hasFrames = hasFrames || argument.compare(0, 9, "--frames=") == 0;
+		arguments.push_back(argv[i]);
+	}
+	if (!hasFrames) { arguments.push_back(defaultFrames); } // a benchmark has to end
+	options.frames = utils::read_run_options(int(arguments.size()), arguments.data()).frames;
+	if (scene.systems == 0 || scene.depth == 0 || options.warmup >= options.frames
+	    || (options.path != "orbit" && options.path != "flyby" && options.path != "close")) {
+		std::cerr << "usage: " << argv[0] << " [resource path] [--systems=N] [--planets=M] [--moons=K] [--depth=D] [--stars=S] [--seed=X]\n"
+		          << "       [--path=orbit|flyby|close] [--lod=0|1] [--warmup=W] [--output=FILE] [--headless] [--frames=N] [--size=WxH] [--trace=FILE]\n"
+		          << "systems and depth have to be at least 1, warmup less than frames" << std::endl;
+		return EXIT_FAILURE;
+	}
+	Application::run<SolarBench>(int(arguments.size()), arguments.data(), 3, 2);
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <functional>
+#include <glm/gtc/type_precision.hpp>
+#include "TransformHierarchy.hpp"
+using glm::fvec3;
+using glm::fvec4;
+using std::vector;
+
+class Node;
+class GeometryNode;
+
+// Dynamic AABB tree over the world space bounds of geometry nodes, answers frustum, sphere and
+// ray queries in O(log n + results). Leaf boxes are enlarged by a margin, so small movements do
+// not touch the tree. update() gets the world transforms recomputed since the last update and
+//   1. refits the leaves which left their margin and their ancestors
+//   2. reinserts a limited number of them at the cheapest place (surface area heuristic)
+//   3. rebuilds the whole tree when refitting made it much more costly than after the last build
+// Geometry without bounds is kept outside the tree and returned by every frustum query.
+class BoundingVolumeHierarchy {
+    public:
+        struct Box {
+            fvec3 min;
+            fvec3 max;
+        };
+        struct RayHit {
+            GeometryNode* node = nullptr; // nullptr if nothing was hit
+            float distance = 0.0f;
+        };
+        struct Statistics {
+            size_t leaves = 0;
+            size_t unboundedNodes = 0;
+            size_t refits = 0;    // leaves which left their margin in the last update
+            size_t reinserts = 0; // of which were moved to a better place in the tree
+            size_t rebuilds = 0;  // since construction
+            float cost = 0.0f;    // summed surface area of inner boxes relative to the root box
+        };
+        static const int NO_LEAF = -1;
+
+        BoundingVolumeHierarchy();
+        // returns the leaf id of the node, it is placed in the tree by the next update()
+        int insert(GeometryNode* node);
+        void remove(int leaf, Node const* node); // ignored if the leaf does not hold node, safe to call from node destructors
+        void clear();
+        // bounds of inserted nodes and of nodes whose world transform was recomputed, call after TransformHierarchy::update
+        void update(TransformHierarchy const& transforms);
+        void rebuild(); // top-down median split of all leaves
+        // append nodes whose bounds intersect the frustum, planes as returned by simd_math::frustum_planes
+        void queryFrustum(fvec4 const planes[6], vector<GeometryNode*>& result) const;
+        void querySphere(fvec3 const& center, float radius, vector<GeometryNode*>& result) const;
+        // nearest node whose world bounding sphere is hit, direction has to be normalized.
+        // Nodes for which filter returns false are ignored, e.g. to pick planets but not their orbits
+        typedef std::function<bool(GeometryNode*)> Filter;
+        RayHit queryRay(fvec3 const& origin, fvec3 const& direction, float maxDistance, TransformHierarchy const& transforms,
+                        Filter const& filter = Filter()) const;
+        Statistics const& getStatistics() const;
+
+    private:
+        static const int NO_NODE = -1;
+        static const size_t MIN_REINSERTS = 32; // per update, at least this many or 1/64 of the leaves
+        struct TreeNode {
+            Box box;      // enlarged by the margin for leaves
+            Box tightBox; // leaves only, world bounds without margin
+            int parent = NO_NODE;
+            int left = NO_NODE; // NO_NODE for leaves
+            int right = NO_NODE;
+            GeometryNode* geometry = nullptr; // leaves only
+            TransformHierarchy::Handle transform = TransformHierarchy::INVALID_HANDLE;
+            unsigned listIndex = 0; // position in _leaves or _unbounded
+            bool isLinked = false;  // leaf is part of the tree, false until its first update
+            bool isPending = false; // inserted since the last update
+            bool isUnbounded = false;
+            bool isLeaf() const { return left == NO_NODE; }
+        };
+
+        int allocateNode();
+        void freeNode(int id);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        void refitAncestors(int id); // recompute inner boxes from the parent of id up to the root
+        int build(int* begin, int* end); // subtree over the leaves [begin, end), returns its root
+        void setBox(int id, Box const& box); // keeps the summed inner area up to date
+        float computeCost() const;
+
+        vector<TreeNode> _nodes;
+        vector<int> _freeNodes;
+        vector<int> _leaves;    // leaves with bounds, linked or not
+        vector<int> _unbounded; // leaves without bounds, never linked
+        vector<int> _pendingLeaves; // may hold ids which were removed or reused since, see TreeNode::isPending
+        vector<int> _leafOfTransform; // leaf id by transform handle
+        vector<TransformHierarchy::Handle> _updatedTransforms; // scratch of update()
+        vector<int> _escapedLeaves;
+        vector<int> _newLeaves;
+        vector<int> _buildLeaves; // scratch of rebuild()
+        int _root;
+        double _innerArea; // summed surface area of all inner boxes, updated with every change
+        float _builtCost; // cost after the last rebuild
+        size_t _updateCount;
+        Statistics _statistics;
+};
+
@@ -0,0 +1,116 @@
+#pragma once
+#include "structs.hpp"
+#include "model.hpp"
+#include <vector>
+#include <glbinding/gl/gl.h>
+#include <glm/gtc/type_precision.hpp>
+using namespace gl;
+using std::vector;
+
+class StreamBuffer;
+
+// Vertex of the geometry added to an arena, stored quantized as ArenaPackedVertex
+struct ArenaVertex {
+    glm::fvec3 position;
+    glm::fvec3 normal;
+    glm::fvec2 texcoord;
+};
+
+// Vertex layout shared by all geometry of an arena, locations 0 to 2 of its vertex array, see vertexFormats.
+// 20 instead of 32 bytes: the normal in octahedral encoding as 2 x snorm16, which the vertex shader decodes, and texture
+// coordinates as half floats, which keep coordinates outside [0, 1] exactly where unorm16 could not (u of the sphere
+// reaches 1.39). Unlit geometry may store other data, e.g. star colors
+struct ArenaPackedVertex {
+    glm::fvec3 position;
+    glm::i16vec2 normal;
+    glm::u16vec2 texcoord; // bits of half floats
+};
+
+// Record of an indirect draw, layout fixed by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance; // first record of the instance buffer read by this command
+};
+
+// Static meshes suballocated from one vertex and one index buffer behind one vertex array, so
+// draws of different meshes need no rebinding and a whole batch is one glMultiDrawElementsIndirect.
+// Meshes are appended, the buffers grow by copying on the GPU. Indices are relative to each mesh's
+// base vertex and 16 bit until a mesh with more than 65536 vertices is added, then all become 32 bit.
+// Per draw data comes from an
+// optional instance buffer whose attributes are offset by each command's baseInstance. With a
+// StreamBuffer, instance records and commands are written into its mapped memory instead.
+// Without GL 4.3 or ARB_multi_draw_indirect the commands are issued one by one. Needs a current GL context
+class GeometryArena {
+    public:
+        // float per instance attribute, mat4 and mat3 take one attribute per column
+        struct InstanceAttribute {
+            GLuint location;
+            GLint components;
+            size_t offset; // in bytes from the start of an instance record
+        };
+
+        GeometryArena(size_t vertexCapacity = 1 << 16, size_t indexCapacity = 1 << 18);
+        ~GeometryArena();
+        GeometryArena(GeometryArena const&) = delete;
+        GeometryArena& operator=(GeometryArena const&) = delete;
+
+        // copies the mesh into the shared buffers, the returned object references its range and the arena's vertex array
+        model_object add(vector<ArenaVertex> const& vertices, vector<GLuint> const& indices, GLenum drawMode);
+        // vertices already in the layout of the arena
+        model_object add(vector<ArenaPackedVertex> const& vertices, vector<GLuint> const& indices, GLenum drawMode);
+        // positions, normals and texture coordinates of a loaded model, missing attributes are zero
+        model_object add(model const& mesh, GLenum drawMode);
+        // like a model, uploaded without a copy if the data already has the layout of ArenaPackedVertex,
+        // e.g. a mapped mesh cache of model_loader::cached_obj with packed vertices
+        model_object add(mesh_data const& mesh, GLenum drawMode);
+        // per instance attributes of the vertex array, records are stride bytes apart
+        void setInstanceLayout(vector<InstanceAttribute> const& attributes, GLsizei stride);
+        // instance records and indirect commands are written into stream, nullptr uses buffers of the arena
+        void setStreamBuffer(StreamBuffer* stream);
+        // makes count records the instance data of the next draws, returns the baseInstance of the first record.
+        // The arena's vertex array has to be bound
+        GLuint uploadInstances(void const* data, size_t count);
+        // draws all commands with the arena's vertex array bound, one GL call if multi draw indirect is supported
+        void draw(GLenum mode, vector<DrawElementsIndirectCommand> const& commands);
+        // command drawing instanceCount instances of the geometry's range
+        static DrawElementsIndirectCommand command(model_object const& geometry, GLuint instanceCount, GLuint baseInstance);
+
+        GLuint getVertexArray() const;
+        size_t getVertexCount() const;
+        size_t getIndexCount() const;
+        // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, may change with every add
+        GLenum getIndexType() const;
+        size_t getIndexSize() const;
+        bool hasMultiDrawIndirect() const;
+        // attribute formats of ArenaPackedVertex with their offsets, location i of the vertex array reads the i-th
+        static vector<model::attribute> const& vertexFormats();
+
+    private:
+        model_object add(ArenaPackedVertex const* vertices, size_t vertexCount, void const* indices, GLenum indexType, size_t indexCount, GLenum drawMode);
+        // switches to 32 bit indices, the indices of the arena are read back and widened
+        void widenIndices();
+        // (re)attaches vertex and index buffer to the vertex array, after creation and growth
+        void setVertexBuffers();
+        void setInstanceOffset(GLuint baseInstance); // fallback for contexts without base instance draws
+        void setInstanceSource(GLuint buffer); // points the instance attributes at buffer
+
+        GLuint _vertexArray;
+        GLuint _vertexBuffer;
+        GLuint _indexBuffer;
+        GLuint _instanceBuffer;
+        GLuint _instanceSource; // buffer the instance attributes read, _instanceBuffer or the stream's
+        GLuint _indirectBuffer;
+        size_t _vertexCapacity;
+        size_t _indexCapacity;
+        size_t _vertexCount;
+        size_t _indexCount;
+        GLenum _indexType;
+        vector<InstanceAttribute> _instanceAttributes;
+        GLsizei _instanceStride;
+        StreamBuffer* _stream;
+        bool _hasMultiDrawIndirect; // GL 4.3 or ARB_multi_draw_indirect
+        bool _hasBaseInstance;      // GL 4.2 or ARB_base_instance
+};
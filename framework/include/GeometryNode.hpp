@@ -2,22 +2,43 @@
 #include "Node.hpp"
 #include "structs.hpp"
 #include <string>
+#include <vector>
 #include <glm/gtc/matrix_transform.hpp>
 using glm::fvec3;
 using std::string;
+using std::vector;
 
 class GeometryNode : public Node {
 	public:
 		GeometryNode(string name, string shader, model_object geometry, fvec3 geoColor, texture_object texture = texture_object());
+		// levels of detail of one mesh, the original first, see setLods
+		GeometryNode(string name, string shader, vector<model_object> const& lods, fvec3 geoColor, texture_object texture = texture_object());
 		string getShader();
 		fvec3 getGeometryColor();
-		model_object getGeometry();
+		model_object getGeometry(); // the selected level of detail
 		texture_object getTexture();
-		void setGeometry(model_object geoModel);
+		bounding_volume const& getBounds() const; // model space bounds of the geometry
+		void setGeometry(model_object geoModel); // a single level
+		// geometry and coarser levels with their lod_error, e.g. of model_loader::lod_chain. The bounds are those of the first
+		void setLods(vector<model_object> const& lods);
+		// level for the geometry's bounding sphere projected to screenRadius pixels: the coarsest one whose lod_error stays
+		// below LOD_PIXEL_ERROR pixels on screen. Coarser levels without a positive error are never selected. A level is only left when the radius moved LOD_HYSTERESIS beyond its limit,
+		// so nodes near a limit do not switch every frame
+		void selectLod(float screenRadius);
+		unsigned getLod() const;
+		unsigned getLodCount() const;
+
+		static const float LOD_PIXEL_ERROR;
+		static const float LOD_HYSTERESIS;
 
 	private:
+		float lodLimit(unsigned lod) const; // largest screen radius of the level, infinite for the first
+
+
 		string _shader;
 		fvec3 _geoColor;
 		model_object _geometry;
 		texture_object _texture;
+		vector<model_object> _lods; // empty for a single level
+		unsigned _lod;
 };
\ No newline at end of file
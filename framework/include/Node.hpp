@@ -1,41 +1,190 @@
 #pragma once
-#include <list>
 #include <string>
-#include <memory>
-#include <functional>
+#include <utility>
+#include <type_traits>
+#include <iterator>
+#include <cstddef>
 #include <glm/gtc/matrix_transform.hpp>
+#include "TransformHierarchy.hpp"
 using glm::mat4;
-using std::list;
 using std::string;
-using std::function;
-using std::shared_ptr;
 
+// Generational handle of a pooled node, resolves to nullptr once the node was destroyed
+struct NodeHandle {
+    unsigned index = ~0u;    // slot in the pool
+    unsigned generation = 0; // incremented whenever the slot is freed
+    unsigned pool = ~0u;     // one pool per node type
+    bool isValid() const { return pool != ~0u; }
+    bool operator==(NodeHandle const& other) const { return index == other.index && generation == other.generation && pool == other.pool; }
+    bool operator!=(NodeHandle const& other) const { return !(*this == other); }
+};
+
+// Returned by traversal visitors to control the walk
+enum class VisitResult {
+    Continue,     // visit children of this node
+    SkipChildren, // prune subtree below this node (pre-order only)
+    Stop          // end traversal immediately
+};
+enum class TraversalOrder { PreOrder, PostOrder };
+
+// Concrete type of a node, hot loops switch on it instead of using dynamic_cast
+enum class NodeType { Transform, Geometry, Light, Camera };
+
+class NodeIterator;
+class NodeRange;
+template<typename T> class NodePool;
+
+// Nodes are owned by SceneGraph's pools (see SceneGraph::createNode), links between them are non-owning
 class Node {
     public:
         Node(string name);
-        shared_ptr<Node> getParent();
-        void setParent(Node* parentNode);
-        shared_ptr<Node> getChild(string childName);
-        list<shared_ptr<Node>> getChildrenList();
+        NodeType getType();
+        bool isInScene(); // attached below SceneGraph's root, only these nodes are in its typed lists
+        NodeHandle getHandle(); // invalid for nodes which are not created by SceneGraph
+        Node* getParent();
+        void setParent(Node* parentNode); // O(1) reparenting, nullptr detaches the node
+        Node* getChild(string childName); // O(1), scans at most a few siblings or probes SceneGraph's child index
+        Node* getFirstChild();
+        Node* getNextSibling();
         string getName();
-        string getPath();
-        int getDepth();
-        void setDepth(int newDepth);
+        string getPath(); // names from the topmost ancestor down to this node, e.g. "Root/Earth Holder/Earth Geometry"
+        int getDepth(); // number of ancestors
         mat4 getLocalTransform();
         void setLocalTransform(mat4 localTransform);
-        mat4 getWorldTransform();
+        mat4 getWorldTransform(); // cached, valid after the last SceneGraph::updateWorldTransforms() pass
         void setWorldTransform(mat4 worldTransform);
-        void addChild(shared_ptr<Node> child);
-        shared_ptr<Node> removeChild(string childName);
-        void traverse(const function<void(shared_ptr<Node>)>& func);
-        virtual ~Node() = default; // Provide dynamic type information to the compiler, so we can use dynamic_pointer_cast()
+        bool isDirty();
+        TransformHierarchy::Handle getTransformHandle(); // handle into SceneGraph's flat transform storage
+        void addChild(Node* child); // O(1), appends child to the sibling list
+        Node* removeChild(string childName);
+        void removeChild(Node* child); // O(1)
+        // Call visitor(Node&) for this node and all descendants, visitor may return VisitResult to prune or stop
+        // Returns false if the traversal was stopped by the visitor
+        template<typename Visitor>
+        bool visit(Visitor&& visitor, TraversalOrder order = TraversalOrder::PreOrder);
+        // Pre-order range over this node and all descendants, e.g. for (Node& node : root->preOrder())
+        NodeRange preOrder();
+        virtual ~Node(); // Provide dynamic type information to the compiler, so we can use dynamic_cast
+
+    protected:
+        Node(string name, NodeType type); // for derived node types
 
     private:
-        shared_ptr<Node> _parent;
-        list<shared_ptr<Node>> _children;
-        string _name;
-        string _path;
-        int _depth;
-        mat4 _localTransform;
-        mat4 _worldTransform;
+        friend class NodeIterator;
+        friend class SceneGraph;
+        template<typename T> friend class NodePool;
+        Node(Node const&) = delete;
+        Node& operator=(Node const&) = delete;
+        void unlink(); // remove from parent's sibling list
+        template<typename Visitor> bool visitPreOrder(Visitor& visitor);
+        template<typename Visitor> bool visitPostOrder(Visitor& visitor);
+
+        // intrusive hierarchy links
+        Node* _parent;
+        Node* _firstChild;
+        Node* _lastChild;
+        Node* _prevSibling;
+        Node* _nextSibling;
+        NodeHandle _handle;
+        NodeType _type;
+        bool _isInScene;
+        bool _hasIndexedChildren; // children are in SceneGraph's child index, small families are scanned instead
+        unsigned _childCount;
+        unsigned _listIndex; // position in SceneGraph's list of this node type
+        int _boundsLeaf; // leaf in SceneGraph's bounding volume hierarchy, geometry nodes only
+        unsigned _nameId; // interned name, see SceneGraph::internName()
+        TransformHierarchy::Handle _transform; // local/world matrices live in SceneGraph's transform storage
 };
+
+// Pre-order iterator walking with parent and sibling links, so no stack has to be allocated
+class NodeIterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Node value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Node* pointer;
+        typedef Node& reference;
+
+        NodeIterator(Node* current = nullptr, Node* root = nullptr) : _current(current), _root(root) { }
+        Node& operator*() const { return *_current; }
+        Node* operator->() const { return _current; }
+        NodeIterator& operator++() { advance(true); return *this; }
+        void skipChildren() { advance(false); } // continue with next node that is not a descendant of current one
+        bool operator==(NodeIterator const& other) const { return _current == other._current; }
+        bool operator!=(NodeIterator const& other) const { return _current != other._current; }
+
+    private:
+        void advance(bool descend) {
+            if (descend && _current->_firstChild) {
+                _current = _current->_firstChild;
+                return;
+            }
+            // climb up until a node has a next sibling, the range ends at the root
+            while (_current != _root) {
+                if (_current->_nextSibling) {
+                    _current = _current->_nextSibling;
+                    return;
+                }
+                _current = _current->_parent;
+            }
+            _current = nullptr;
+        }
+
+        Node* _current;
+        Node* _root;
+};
+
+class NodeRange {
+    public:
+        NodeRange(Node* root) : _root(root) { }
+        NodeIterator begin() const { return NodeIterator(_root, _root); }
+        NodeIterator end() const { return NodeIterator(); }
+
+    private:
+        Node* _root;
+};
+
+inline NodeRange Node::preOrder() { return NodeRange(this); }
+
+// ------------- Template implementation -------------
+namespace node_visit_detail {
+    template<typename Visitor>
+    inline VisitResult invoke(Visitor& visitor, Node& node, std::true_type /* visitor returns void */) {
+        visitor(node);
+        return VisitResult::Continue;
+    }
+    template<typename Visitor>
+    inline VisitResult invoke(Visitor& visitor, Node& node, std::false_type) {
+        return visitor(node);
+    }
+    template<typename Visitor>
+    inline VisitResult invoke(Visitor& visitor, Node& node) {
+        return invoke(visitor, node, std::is_void<decltype(visitor(node))>());
+    }
+}
+
+template<typename Visitor>
+bool Node::visit(Visitor&& visitor, TraversalOrder order) {
+    return order == TraversalOrder::PreOrder ? visitPreOrder(visitor) : visitPostOrder(visitor);
+}
+
+template<typename Visitor>
+bool Node::visitPreOrder(Visitor& visitor) {
+    VisitResult result = node_visit_detail::invoke(visitor, *this);
+    if (result == VisitResult::Stop) { return false; }
+    if (result == VisitResult::SkipChildren) { return true; }
+    for (Node* child = _firstChild; child; child = child->_nextSibling) {
+        if (!child->visitPreOrder(visitor)) { return false; }
+    }
+    return true;
+}
+
+template<typename Visitor>
+bool Node::visitPostOrder(Visitor& visitor) {
+    for (Node* child = _firstChild; child; ) {
+        Node* next = child->_nextSibling; // visitor may detach the child
+        if (!child->visitPostOrder(visitor)) { return false; }
+        child = next;
+    }
+    return node_visit_detail::invoke(visitor, *this) != VisitResult::Stop;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+#include "Node.hpp"
+using std::vector;
+using std::unique_ptr;
+
+// Type erased interface, so SceneGraph can resolve and destroy nodes of every pool by handle
+class NodePoolBase {
+    public:
+        virtual ~NodePoolBase() = default;
+        virtual Node* resolve(NodeHandle handle) = 0; // nullptr if the handle is stale
+        virtual void destroy(NodeHandle handle) = 0;
+        virtual void clear() = 0; // destroy all nodes of this pool at once
+        virtual size_t size() const = 0; // number of live nodes
+};
+
+// Arena for one node type. Nodes are constructed in place inside fixed size chunks, so their
+// addresses never change and one allocation serves CHUNK_SIZE nodes. Freed slots are recycled
+// through a free list, their generation is incremented so old handles no longer resolve.
+template<typename T>
+class NodePool : public NodePoolBase {
+    public:
+        static const unsigned CHUNK_SIZE = 1024;
+
+        NodePool(unsigned poolId) : _poolId(poolId), _capacity(0), _firstFree(NO_SLOT), _size(0) { }
+        ~NodePool() { clear(); }
+
+        template<typename... Args>
+        T* create(Args&&... args) {
+            if (_firstFree == NO_SLOT) { grow(); }
+            unsigned index = _firstFree;
+            Slot& slot = getSlot(index);
+            T* node = new (&slot.storage) T(std::forward<Args>(args)...);
+            _firstFree = slot.nextFree;
+            slot.isAlive = true;
+            node->_handle.index = index;
+            node->_handle.generation = slot.generation;
+            node->_handle.pool = _poolId;
+            ++_size;
+            return node;
+        }
+
+        Node* resolve(NodeHandle handle) override { return get(handle); }
+
+        T* get(NodeHandle handle) {
+            if (handle.pool != _poolId || handle.index >= _capacity) { return nullptr; }
+            Slot& slot = getSlot(handle.index);
+            return slot.isAlive && slot.generation == handle.generation ? object(slot) : nullptr;
+        }
+
+        void destroy(NodeHandle handle) override {
+            T* node = get(handle);
+            if (!node) { return; }
+            Slot& slot = getSlot(handle.index);
+            node->~T();
+            slot.isAlive = false;
+            ++slot.generation;
+            slot.nextFree = _firstFree;
+            _firstFree = handle.index;
+            --_size;
+        }
+
+        void clear() override {
+            for (unsigned index = 0; index < _capacity; ++index) {
+                Slot& slot = getSlot(index);
+                if (slot.isAlive) { destroy(object(slot)->_handle); }
+            }
+        }
+
+        size_t size() const override { return _size; }
+
+        void reserve(size_t count) { // preallocate chunks for count nodes
+            while (_capacity - _size < count) { grow(); }
+        }
+
+    private:
+        static const unsigned NO_SLOT = ~0u;
+
+        struct Slot {
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+            unsigned generation;
+            unsigned nextFree;
+            bool isAlive;
+        };
+
+        Slot& getSlot(unsigned index) { return _chunks[index / CHUNK_SIZE][index % CHUNK_SIZE]; }
+        static T* object(Slot& slot) { return reinterpret_cast<T*>(&slot.storage); }
+
+        void grow() {
+            _chunks.push_back(unique_ptr<Slot[]>(new Slot[CHUNK_SIZE]));
+            // chain new slots into the free list in ascending order
+            for (unsigned i = 0; i < CHUNK_SIZE; ++i) {
+                Slot& slot = _chunks.back()[i];
+                slot.generation = 0;
+                slot.isAlive = false;
+                slot.nextFree = i + 1 < CHUNK_SIZE ? _capacity + i + 1 : _firstFree;
+            }
+            _firstFree = _capacity;
+            _capacity += CHUNK_SIZE;
+        }
+
+        unsigned _poolId;
+        vector<unique_ptr<Slot[]>> _chunks;
+        unsigned _capacity;
+        unsigned _firstFree;
+        size_t _size;
+};
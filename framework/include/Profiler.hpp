@@ -0,0 +1,111 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+using std::string;
+using std::vector;
+
+// Frame profiler, keeps the CPU scopes of all threads and the GPU pass durations of the last
+// frames in a ring buffer, so a frame spike can still be inspected after it happened.
+//   - PROFILE_SCOPE("name") times the rest of the enclosing block on the calling thread
+//   - PROFILE_GPU_SCOPE("name") wraps the GL commands of the block in a GL_TIME_ELAPSED query.
+//     Queries are read a few frames later once their result is available, so the CPU never waits
+//     for the GPU, and stored in the frame which issued them. GL allows only one active time
+//     elapsed query, so GPU scopes must not nest
+// Application::run calls beginFrame() and endFrame(), scopes outside of frames (e.g. loading at
+// startup) go into the next frame. Names must be string literals, only the pointer is stored.
+// Defining PROFILER_DISABLED compiles the scope macros away.
+class Profiler {
+    public:
+        struct Scope {
+            char const* name;
+            double begin;    // microseconds since the profiler was created, GPU scopes: when the commands were issued
+            double duration; // microseconds
+            unsigned thread; // TaskPool::getThreadIndex() of the recording thread, GPU_THREAD for GPU scopes
+            unsigned depth;  // nesting level on its thread
+        };
+        struct Frame {
+            uint64_t index = 0;
+            double begin = 0.0;
+            double duration = 0.0;
+            vector<Scope> scopes;
+        };
+        // times the rest of the enclosing block, see PROFILE_SCOPE
+        class CpuScope {
+            public:
+                CpuScope(char const* name);
+                ~CpuScope();
+            private:
+                char const* _name;
+                double _begin;
+                bool _isRecording;
+        };
+        // GL_TIME_ELAPSED query around the GL commands of the enclosing block, see PROFILE_GPU_SCOPE
+        class GpuScope {
+            public:
+                GpuScope(char const* name);
+                ~GpuScope();
+        };
+        static const unsigned GPU_THREAD = ~0u;
+        static const size_t DEFAULT_FRAME_COUNT = 600; // 10 seconds at 60 fps
+
+        Profiler();
+        ~Profiler();
+        static Profiler& getInstance(); // get Profiler instance (singleton)
+        void setEnabled(bool isEnabled);
+        bool isEnabled() const;
+        void setFrameCount(size_t frameCount); // ring buffer size, drops the recorded frames
+        void clear();
+        void beginFrame();
+        void endFrame(); // also collects the results of finished GPU queries, needs the GL context if GPU scopes were used
+        // needs a current GL context, ignored while another GPU scope is active or GL has no timer queries
+        void beginGpuScope(char const* name);
+        void endGpuScope();
+        void record(char const* name, double begin, double end, unsigned depth); // CPU scope of the calling thread
+        double now() const; // microseconds since the profiler was created
+        vector<Frame> getFrames() const; // finished frames, oldest first
+        // one complete event per scope, load in chrome://tracing or https://ui.perfetto.dev
+        void writeChromeTrace(std::ostream& stream) const;
+        // one row per frame, one column of milliseconds per scope name summed over all threads
+        void writeCsv(std::ostream& stream) const;
+        bool exportChromeTrace(string const& filePath) const; // false if the file could not be written
+        bool exportCsv(string const& filePath) const;
+
+    private:
+        static const size_t MAX_GPU_QUERIES = 64; // scopes are dropped while this many queries are still pending
+        struct GpuQuery {
+            unsigned query = 0;
+            char const* name = nullptr;
+            uint64_t frame = 0;
+            double begin = 0.0;
+            bool isPending = false;
+        };
+
+        Profiler(Profiler const&) = delete;
+        Profiler& operator=(Profiler const&) = delete;
+        Frame& currentFrame(); // caller holds _mutex
+        void collectGpuQueries();
+        bool hasTimerQueries();
+
+        std::chrono::steady_clock::time_point _start;
+        mutable std::mutex _mutex; // guards _frames, scopes are recorded from all threads
+        vector<Frame> _frames; // ring buffer, the slot of _frameIndex is the frame being recorded
+        uint64_t _frameIndex;
+        bool _isEnabled;
+        vector<GpuQuery> _gpuQueries;
+        int _activeGpuQuery; // index in _gpuQueries, -1 if no GPU scope is active
+        int _timerQuerySupport; // -1 until checked with the first GPU scope
+};
+
+#ifndef PROFILER_DISABLED
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) Profiler::CpuScope PROFILER_CONCAT(profilerScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) Profiler::GpuScope PROFILER_CONCAT(profilerGpuScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_GPU_SCOPE(name) ((void)0)
+#endif
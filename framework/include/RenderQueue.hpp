@@ -0,0 +1,136 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glbinding/gl/gl.h>
+using namespace gl;
+using std::vector;
+
+// Coarse draw order, earlier passes are submitted first
+enum class RenderPass : unsigned { Opaque, Background };
+
+// GL state a draw call needs bound
+struct DrawState {
+    GLuint program = 0;
+    GLenum textureTarget = GL_NONE;
+    GLuint texture = 0; // 0 keeps whatever texture is bound
+    GLuint vertexArray = 0;
+    bool operator==(DrawState const& other) const {
+        return program == other.program && textureTarget == other.textureTarget && texture == other.texture && vertexArray == other.vertexArray;
+    }
+};
+
+// Where the caller keeps the data of a queued draw
+struct DrawRef {
+    unsigned list;
+    unsigned index;
+};
+
+// Per frame list of draw calls, sorted by a packed 64 bit key so that draws sharing a
+// program, texture and vertex array are submitted next to each other:
+//   | pass 4 | program 12 | texture 16 | vertex array 12 | depth 20 |
+// GL names are mapped to dense ids for the key. Submission compares the bound state and
+// only calls glUseProgram, glBindTexture and glBindVertexArray when it changes.
+class RenderQueue {
+    public:
+        // state changes of the last submit(), avoided = draws which reused the bound state
+        struct Statistics {
+            unsigned draws = 0;
+            unsigned batches = 0; // runs of consecutive draws with equal state
+            unsigned programChanges = 0;
+            unsigned textureChanges = 0;
+            unsigned vertexArrayChanges = 0;
+            unsigned avoidedProgramChanges = 0;
+            unsigned avoidedTextureChanges = 0;
+            unsigned avoidedVertexArrayChanges = 0;
+        };
+
+        void clear();
+        // depth: view space distance, draws of one state are submitted front to back.
+        // list and index tell the caller where the draw's data is, they are handed back on submit
+        void push(RenderPass pass, DrawState const& state, float depth, unsigned list, unsigned index);
+        void sort(); // LSD radix sort of the keys
+        size_t size() const;
+        // onProgram(program) runs after a program was bound, e.g. to upload per frame uniforms,
+        // draw(list, index) has to set per draw uniforms and issue the draw call
+        template<typename ProgramCallback, typename DrawCallback>
+        void submit(ProgramCallback const& onProgram, DrawCallback const& draw);
+        // drawBatch(vector<DrawRef> const&) gets all consecutive draws with equal state at once, e.g. to draw them instanced
+        template<typename ProgramCallback, typename BatchCallback>
+        void submitBatches(ProgramCallback const& onProgram, BatchCallback const& drawBatch);
+        Statistics const& getStatistics() const;
+
+    private:
+        struct Item {
+            DrawState state;
+            unsigned list;
+            unsigned index;
+        };
+        struct SortEntry {
+            uint64_t key;
+            unsigned item;
+        };
+
+        static unsigned denseId(vector<unsigned>& ids, unsigned& count, GLuint name, unsigned bits);
+
+        vector<Item> _items;
+        vector<SortEntry> _entries;
+        vector<SortEntry> _sortBuffer;
+        vector<unsigned> _radixCounts; // one histogram per 8 bit digit
+        vector<DrawRef> _batch;
+        vector<unsigned> _programIds, _textureIds, _vertexArrayIds; // indexed by GL name, 0 = no id yet
+        unsigned _programCount = 0, _textureCount = 0, _vertexArrayCount = 0;
+        Statistics _statistics;
+};
+
+// ------------- Template implementation -------------
+template<typename ProgramCallback, typename DrawCallback>
+void RenderQueue::submit(ProgramCallback const& onProgram, DrawCallback const& draw) {
+    submitBatches(onProgram, [&draw](vector<DrawRef> const& batch) {
+        for (auto const& ref : batch) { draw(ref.list, ref.index); }
+    });
+}
+
+template<typename ProgramCallback, typename BatchCallback>
+void RenderQueue::submitBatches(ProgramCallback const& onProgram, BatchCallback const& drawBatch) {
+    _statistics = Statistics();
+    DrawState bound;
+    bool isFirst = true;
+    unsigned texturedDraws = 0;
+    for (size_t begin = 0; begin < _entries.size();) {
+        DrawState const& state = _items[_entries[begin].item].state;
+        _batch.clear();
+        size_t end = begin;
+        for (; end < _entries.size() && _items[_entries[end].item].state == state; ++end) {
+            Item const& item = _items[_entries[end].item];
+            _batch.push_back(DrawRef{item.list, item.index});
+        }
+
+        if (isFirst || state.program != bound.program) {
+            glUseProgram(state.program);
+            bound.program = state.program;
+            ++_statistics.programChanges;
+            onProgram(state.program);
+        }
+        texturedDraws += state.texture != 0 ? unsigned(_batch.size()) : 0;
+        if (state.texture != 0 && (state.texture != bound.texture || state.textureTarget != bound.textureTarget)) {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(state.textureTarget, state.texture);
+            bound.texture = state.texture;
+            bound.textureTarget = state.textureTarget;
+            ++_statistics.textureChanges;
+        }
+        if (isFirst || state.vertexArray != bound.vertexArray) {
+            glBindVertexArray(state.vertexArray);
+            bound.vertexArray = state.vertexArray;
+            ++_statistics.vertexArrayChanges;
+        }
+        isFirst = false;
+        drawBatch(_batch);
+        _statistics.draws += unsigned(_batch.size());
+        ++_statistics.batches;
+        begin = end;
+    }
+    _statistics.avoidedProgramChanges = _statistics.draws - _statistics.programChanges;
+    _statistics.avoidedTextureChanges = texturedDraws - _statistics.textureChanges;
+    _statistics.avoidedVertexArrayChanges = _statistics.draws - _statistics.vertexArrayChanges;
+}
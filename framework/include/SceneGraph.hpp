@@ -1,29 +1,140 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <unordered_map>
 #include "Node.hpp"
+#include "NodePool.hpp"
+#include "TransformHierarchy.hpp"
+#include "TaskPool.hpp"
 #include "CameraNode.hpp"
 #include "PointLightNode.hpp"
+#include "BoundingVolumeHierarchy.hpp"
 using std::string;
-using std::shared_ptr;
+using std::vector;
+using std::unique_ptr;
+using std::unordered_map;
+
+class GeometryNode;
 
 class SceneGraph {
     public:
+        static const unsigned NO_NAME = ~0u;
+        // children of parents with more children are indexed, the index is dropped again at half of it
+        static const unsigned INDEXED_CHILDREN = 16;
+
         SceneGraph();
+        ~SceneGraph();
         static SceneGraph& getInstance(); // get SceneGraph instance (singleton)
         string getName();
         void setName(string name);
-        shared_ptr<Node> getRoot(); // get root node in this scenegraph
-        void setRoot(shared_ptr<Node> rootNode);
-        shared_ptr<CameraNode> getCamera(); // get a camera node in this scenegraph
-        void setCamera(shared_ptr<CameraNode> cameraNode);
-        shared_ptr<PointLightNode> getDirectionalLight(); // get a camera node in this scenegraph
-        void setDirectionalLight(shared_ptr<PointLightNode> directionalLight);
+        Node* getRoot(); // get root node in this scenegraph
+        void setRoot(Node* rootNode);
+        CameraNode* getCamera(); // get a camera node in this scenegraph
+        void setCamera(CameraNode* cameraNode);
+        PointLightNode* getDirectionalLight(); // get a camera node in this scenegraph
+        void setDirectionalLight(PointLightNode* directionalLight);
+        // nodes below the root by type, kept up to date when nodes are attached or detached. Unordered,
+        // removing a node moves the last node of its list into its place
+        vector<GeometryNode*> const& getGeometryNodes() const;
+        vector<PointLightNode*> const& getLights() const;
+        vector<CameraNode*> const& getCameras() const;
+        // world space bounds of the geometry nodes, updated by updateWorldTransforms()
+        BoundingVolumeHierarchy const& getBoundingVolumes() const;
+        // create node in the pool of its type, the node is owned by this scenegraph
+        template<typename T, typename... Args>
+        T* createNode(Args&&... args);
+        template<typename T>
+        void reserveNodes(size_t count); // preallocate pool and transform storage before building large scenes
+        void destroyNode(Node* node); // destroy node and its subtree
+        Node* getNode(NodeHandle handle); // nullptr if node was destroyed
+        template<typename T>
+        NodePool<T>& getPool(); // pool of one node type
+        void clear(); // destroy all nodes at once
+        Node* findNode(string const& path); // node at "Root/Earth Holder/Earth Geometry" below the root node, nullptr if there is none
+        unsigned internName(string const& name); // dense id of a node name, added on first use
+        unsigned findName(string const& name) const; // NO_NAME if no node was ever called like this
+        string const& getInternedName(unsigned nameId) const;
+        TransformHierarchy& getTransforms(); // flat storage of all node transforms
+        // recompute world transforms of all dirty nodes and refit their bounds, call once per frame before drawing
+        void updateWorldTransforms(TaskPool* taskPool = nullptr);
         void printGraph();
 
     private:
+        friend class Node; // keeps the child index up to date
+        // slot of the child index, node is nullptr in empty slots
+        struct ChildSlot {
+            uint64_t hash;
+            Node* node;
+        };
+        static uint64_t hashChild(Node const* parent, unsigned nameId);
+        void reserveChildIndex(size_t count); // grow to a power of two slots, at most half of them used
+        void insertChildSlot(ChildSlot slot);
+        void eraseChildSlot(Node* node);
+        void indexNode(Node* node); // call after node was linked to its parent
+        void unindexNode(Node* node); // call before node is unlinked from its parent
+        Node* findChild(Node* parent, unsigned nameId);
+        void setInScene(Node* subtree, bool isInScene); // add subtree to the typed lists or remove it
+        void addToLists(Node* node);
+        void removeFromLists(Node* node);
+        template<typename T> static void addToList(vector<T*>& list, Node* node);
+        template<typename T> static void removeFromList(vector<T*>& list, Node* node);
+        static unsigned nextPoolId();
+        template<typename T>
+        static unsigned poolId(); // dense id per node type, index into _pools
+
+        // declared first, so they outlive the nodes in _pools
+        TransformHierarchy _transforms;
+        vector<string> _names;
+        unordered_map<string, unsigned> _nameIds;
+        // open addressing over hash of (parent, name id) -> node, one probe per path component. Flat, so
+        // attaching and detaching never allocate, the slots only grow when the scene does
+        vector<ChildSlot> _childSlots;
+        size_t _indexedCount;
+        vector<unique_ptr<NodePoolBase>> _pools;
         string _name;
-        shared_ptr<Node> _root;
-        shared_ptr<CameraNode> _camera;
-        shared_ptr<PointLightNode> _dirLight;
+        Node* _root;
+        CameraNode* _camera;
+        PointLightNode* _dirLight;
+        vector<GeometryNode*> _geometryNodes;
+        vector<PointLightNode*> _lights;
+        vector<CameraNode*> _cameras;
+        BoundingVolumeHierarchy _boundingVolumes;
 };
+
+// ------------- Template implementation -------------
+inline uint64_t SceneGraph::hashChild(Node const* parent, unsigned nameId) {
+    // splitmix64 finalizer, spreads the children of one parent over the index
+    uint64_t hash = uint64_t(reinterpret_cast<uintptr_t>(parent)) ^ (uint64_t(nameId) * 0x9e3779b97f4a7c15ull);
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return hash ^ (hash >> 31);
+}
+
+template<typename T>
+unsigned SceneGraph::poolId() {
+    static unsigned id = nextPoolId();
+    return id;
+}
+
+template<typename T>
+NodePool<T>& SceneGraph::getPool() {
+    unsigned id = poolId<T>();
+    if (_pools.size() <= id) { _pools.resize(id + 1); }
+    if (!_pools[id]) { _pools[id].reset(new NodePool<T>(id)); }
+    return static_cast<NodePool<T>&>(*_pools[id]);
+}
+
+template<typename T>
+void SceneGraph::reserveNodes(size_t count) {
+    getPool<T>().reserve(count);
+    _transforms.reserve(_transforms.size() + count);
+    reserveChildIndex(_indexedCount + count);
+}
+
+template<typename T, typename... Args>
+T* SceneGraph::createNode(Args&&... args) {
+    return getPool<T>().create(std::forward<Args>(args)...);
+}
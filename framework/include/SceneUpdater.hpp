@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Node.hpp"
+#include "GeometryNode.hpp"
+#include "TaskPool.hpp"
+using glm::fmat4;
+using std::vector;
+
+// Draw data of the geometry nodes collected by one thread, in three parallel arrays
+struct DrawBuffer {
+    vector<GeometryNode*> nodes;
+    vector<fmat4> modelMatrices;  // world transform
+    vector<fmat4> normalMatrices; // inverseTranspose(view * model)
+    // culling scratch of the current chunk, world space bounding spheres as structure of arrays
+    vector<float> sphereX, sphereY, sphereZ, sphereRadius;
+    vector<unsigned char> isVisible;
+    size_t size() const { return nodes.size(); }
+    void clear();
+    char padding[64]; // keeps the vectors of different threads on different cache lines
+};
+
+// Per frame scene update, run before rendering. Independent subtrees below the root are
+// distributed over a work-stealing task pool for
+//   1. animation (user function called for every node)
+//   2. world transforms (flat sweep, see TransformHierarchy::update)
+//   3. draw packets of the scenegraph's geometry nodes, written into one DrawBuffer per thread.
+//      Nodes whose bounds are outside the camera frustum are skipped, the others select their level of detail
+class SceneUpdater {
+    public:
+        enum class CullMode {
+            None,
+            Linear,   // world bounding sphere of every node, SIMD batches in the draw packet tasks
+            Hierarchy // frustum query of the scenegraph's bounding volume hierarchy, then draw packets of the result
+        };
+        struct CullStatistics {
+            size_t tested = 0;
+            size_t visible = 0;
+        };
+
+        // may only change the node it is called for, nodes of other subtrees are updated at the same time
+        typedef std::function<void(Node&)> Animation;
+
+        SceneUpdater(unsigned threadCount = 0); // 0: one thread per hardware thread
+        void setAnimation(Animation animation); // empty function disables the animation phase
+        void setSingleThreaded(bool isSingleThreaded); // run every phase on the calling thread, for A/B comparison
+        bool isSingleThreaded() const;
+        unsigned getThreadCount() const; // threads used by the next update
+        void update();
+        vector<DrawBuffer> const& getDrawBuffers() const; // one per thread, order of nodes across buffers is unspecified
+        void setCullMode(CullMode mode); // Hierarchy by default
+        CullMode getCullMode() const;
+        CullStatistics getCullStatistics() const; // of the last update, all nodes count as visible without culling
+        void setViewportHeight(unsigned height); // in pixels, for the screen size of nodes with levels of detail
+        void setLodEnabled(bool isLodEnabled); // enabled by default, otherwise every node draws its first level
+        bool isLodEnabled() const;
+
+    private:
+        template<typename Function>
+        void forEachNode(Function const& function); // function(Node&, thread index) for every node below and including the root
+        void splitSubtrees(Node* root);
+        // world bounding spheres of nodes [begin, end) against the frustum, result in buffer.isVisible
+        static void cullChunk(DrawBuffer& buffer, vector<GeometryNode*> const& nodes, size_t begin, size_t end, glm::fvec4 const* frustumPlanes);
+        // radius in pixels of the node's world bounding sphere seen from cameraPosition, infinite for unbounded nodes or a camera inside.
+        // pixelScale is half the viewport height times the projection's y scale
+        static float screenRadius(GeometryNode& node, fmat4 const& world, glm::fvec3 const& cameraPosition, float pixelScale, bool isPerspective);
+
+        TaskPool _taskPool;
+        bool _isSingleThreaded;
+        CullMode _cullMode;
+        CullStatistics _cullStatistics;
+        unsigned _viewportHeight;
+        bool _isLodEnabled;
+        vector<GeometryNode*> _visibleNodes; // result of the hierarchy query
+        Animation _animation;
+        vector<DrawBuffer> _drawBuffers;
+        vector<Node*> _splitNodes; // visited by the scheduling thread, their children are distributed
+        vector<Node*> _subtrees;   // roots of the subtrees which are distributed
+        vector<Node*> _nextSubtrees;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+using namespace gl;
+using std::string;
+using std::vector;
+
+// Dense id of a uniform name, the same for every program. Handles are meant to be fetched once,
+// e.g. into a static constant, so no string is hashed or compared while rendering
+typedef unsigned UniformHandle;
+
+// Active uniforms of a linked program, found by GL_ACTIVE_UNIFORMS reflection and indexed by handle.
+// Keeps a shadow copy of the last uploaded values, setting a uniform to its current value is skipped.
+// Setters upload to the bound program, which has to be the reflected one
+class ShaderUniforms {
+    public:
+        struct Statistics {
+            unsigned uploads = 0;
+            unsigned skippedUploads = 0; // value was equal to the shadow copy
+        };
+
+        static UniformHandle getHandle(string const& name); // interns the name, not thread safe
+        // uniform blocks with this name are bound to the binding point by reflect(), so one buffer feeds all programs
+        static void setBlockBinding(string const& blockName, GLuint bindingPoint);
+
+        void reflect(GLuint program); // after every link, the new program starts with cleared uniforms
+        bool isActive(UniformHandle handle) const;
+        GLint getLocation(UniformHandle handle) const; // -1 if not active, setting it is a no-op
+
+        void set(UniformHandle handle, GLint value); // ints and samplers
+        void set(UniformHandle handle, bool value);
+        void set(UniformHandle handle, float value);
+        void set(UniformHandle handle, glm::fvec3 const& value);
+        void set(UniformHandle handle, glm::fvec4 const& value);
+        void set(UniformHandle handle, glm::fmat4 const& value);
+
+        Statistics const& getStatistics() const;
+
+    private:
+        struct Uniform {
+            GLint location = -1;
+            unsigned offset = 0; // of the value in the shadow copy
+            unsigned size = 0;
+            bool hasValue = false;
+        };
+
+        template<typename Upload>
+        void upload(UniformHandle handle, void const* value, unsigned size, Upload const& upload);
+        static unsigned getValueSize(GLenum type);
+        static void bindBlocks(GLuint program);
+
+        vector<Uniform> _uniforms; // indexed by handle
+        vector<unsigned char> _shadow;
+        Statistics _statistics;
+};
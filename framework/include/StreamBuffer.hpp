@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <glbinding/gl/gl.h>
+using namespace gl;
+using std::vector;
+
+// Ring buffer for data the CPU writes every frame, e.g. instance records, uniform blocks and
+// indirect draw commands. The buffer is split into regions, each frame writes into its own one
+// and nextFrame() puts a fence behind the frame's commands. A region is written again only after
+// its fence signaled, so the driver never has to orphan storage or wait for the GPU behind our back.
+// With GL 4.4 or ARB_buffer_storage the buffer is mapped once, persistent and coherent, and writes
+// go straight to memory the GPU reads. Otherwise they go to a CPU copy that flush() uploads.
+// Allocations that do not fit into the current region fail, the region grows at the next frame.
+// Needs a current GL context
+class StreamBuffer {
+    public:
+        struct Allocation {
+            void* data;    // nullptr if the region is full
+            size_t offset; // in bytes from the start of the buffer, for bindings, attribute and indirect offsets
+        };
+        struct Statistics {
+            unsigned frames = 0;
+            unsigned stalls = 0;        // regions which were still read by the GPU when they came around again
+            double stallMicroseconds = 0.0;
+            unsigned overflows = 0;     // failed allocations
+            size_t peakBytes = 0;       // most bytes written into one region
+        };
+        static const unsigned DEFAULT_REGION_COUNT = 3; // frame being written, frame queued on the GPU, frame being drawn
+
+        StreamBuffer(size_t regionSize, unsigned regionCount = DEFAULT_REGION_COUNT);
+        ~StreamBuffer();
+        StreamBuffer(StreamBuffer const&) = delete;
+        StreamBuffer& operator=(StreamBuffer const&) = delete;
+
+        // valid until the region comes around again, regionCount frames later. The offset from the start of the
+        // buffer is a multiple of alignment, which does not have to be a power of two, e.g. the size of an instance
+        // record so the offset is a whole record in every region
+        Allocation allocate(size_t size, size_t alignment = 16);
+        // makes the writes since the last flush visible to GL, call it before drawing with them. Nothing to do when persistently mapped
+        void flush();
+        // fences the commands which read the current region and moves on to the next one
+        void nextFrame();
+        GLuint getHandle() const; // changes when the buffer grows
+        unsigned getFrame() const; // nextFrame() calls so far
+        size_t getRegionSize() const;
+        bool isPersistent() const;
+        Statistics const& getStatistics() const;
+
+    private:
+        void create(size_t regionSize); // a new buffer, deleting the old one also unmaps it
+        void waitForAll();
+        void waitForRegion(); // before the first write into the current region
+
+        GLuint _handle;
+        unsigned char* _data; // persistent mapping or the CPU copy
+        vector<unsigned char> _copy;
+        vector<GLsync> _fences; // per region, nullptr if the GPU has no pending commands reading it
+        size_t _regionSize;
+        unsigned _region;
+        unsigned _frame;
+        size_t _head;    // bytes allocated in the current region
+        size_t _flushed; // bytes of the current region already uploaded from the CPU copy
+        size_t _requiredSize; // of the current region including failed allocations
+        bool _isPersistent;
+        bool _isRegionFree;
+        Statistics _statistics;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+using std::vector;
+using std::unique_ptr;
+
+// Work-stealing thread pool. Every thread owns a task queue: it pushes and pops at the back
+// of its own queue (newest task first, which is still warm in cache) and steals from the
+// front of the other queues when its own one is empty. The thread which calls wait() is
+// thread 0 and runs tasks as well, so a pool of n threads starts n - 1 workers.
+class TaskPool {
+    public:
+        typedef std::function<void()> Task;
+
+        TaskPool(unsigned threadCount = 0); // 0: one thread per hardware thread
+        ~TaskPool();
+        unsigned getThreadCount() const; // including the calling thread
+        static unsigned getThreadIndex(); // 0 for the calling thread, 1..n-1 inside the workers
+        void push(Task task); // may also be called from inside a task
+        void wait(); // help running tasks until all pushed tasks are finished
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        TaskPool(TaskPool const&) = delete;
+        TaskPool& operator=(TaskPool const&) = delete;
+        bool runTask(unsigned self); // pop own task or steal one, false if every queue was empty
+        void workerLoop(unsigned self);
+
+        vector<unique_ptr<Queue>> _queues; // one per thread, index = thread index
+        vector<std::thread> _workers;
+        std::atomic<unsigned> _queuedTasks;  // tasks waiting in a queue, sleeping workers wake up for them
+        std::atomic<unsigned> _pendingTasks; // queued and running tasks, wait() returns at 0
+        std::mutex _wakeMutex;
+        std::condition_variable _wakeCondition;
+        bool _isStopping;
+};
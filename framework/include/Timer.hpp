@@ -3,6 +3,8 @@ class Timer {
     public:
         Timer();
         double getElapsedTime();
+        // every timer reports this many seconds per call instead of the real time, 0 switches back
+        static void setFixedTimestep(double seconds);
 
     private:
         double _lastTime;
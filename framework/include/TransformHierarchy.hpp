@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <glm/gtc/matrix_transform.hpp>
+using glm::mat4;
+using std::vector;
+
+class TaskPool;
+
+// Flat (SoA) storage of all node transforms. Transforms are kept in depth-first order,
+// so every parent precedes its children and the world update is a single forward sweep
+// over contiguous arrays instead of chasing child pointers through the node tree.
+class TransformHierarchy {
+    public:
+        typedef unsigned Handle; // stable id of a transform, independent from its position in sweep order
+        static const Handle INVALID_HANDLE = ~0u;
+        static const int NO_PARENT = -1;
+
+        TransformHierarchy();
+        Handle allocate(); // new transform without parent, local and world are identity
+        void reserve(size_t count); // preallocate storage for count transforms
+        void clear(); // drop all transforms, storage is kept for reuse
+        void release(Handle handle);
+        void setParent(Handle handle, Handle parentHandle); // pass INVALID_HANDLE to detach
+        mat4 const& getLocalTransform(Handle handle) const;
+        void setLocalTransform(Handle handle, mat4 const& localTransform);
+        mat4 const& getWorldTransform(Handle handle) const;
+        void setWorldTransform(Handle handle, mat4 const& worldTransform);
+        bool isDirty(Handle handle) const;
+        bool wasUpdated(Handle handle) const; // world transform was recomputed by the last update()
+        void collectUpdated(vector<Handle>& handles) const; // append the handles of all transforms recomputed by the last update()
+        // restore depth-first order if hierarchy changed, then recompute dirty world transforms,
+        // with a task pool disjoint subtrees are swept concurrently
+        void update(TaskPool* taskPool = nullptr);
+        size_t size() const; // number of entries in sweep order (including released ones until next update)
+
+    private:
+        void sortHierarchy();
+        void sweep(size_t begin, size_t end); // world transforms of entries [begin, end), then clear their dirty flags
+        void scheduleSubtrees(size_t begin, size_t end, size_t grain, TaskPool& taskPool);
+
+        // hot data, indexed by sweep order
+        vector<mat4> _localTransforms;
+        vector<mat4> _worldTransforms;
+        vector<int> _parentIndices;
+        vector<unsigned char> _dirtyFlags;
+        vector<unsigned char> _updatedFlags; // dirty flags of the last update, before they were cleared
+        vector<unsigned> _subtreeEnds; // entries [i, _subtreeEnds[i]) are the subtree of entry i
+        vector<Handle> _indexToHandle;
+        vector<size_t> _splitIndices; // entries swept by the scheduling thread in a parallel update
+        // cold data, indexed by handle
+        vector<unsigned> _handleToIndex;
+        vector<Handle> _parentHandles;
+        vector<Handle> _freeHandles;
+        bool _isSorted;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <glbinding/gl/gl.h>
+using namespace gl;
+using std::vector;
+
+class StreamBuffer;
+
+// Uniform buffer object attached to a fixed binding point. Every program whose block is bound
+// to the same point (see ShaderUniforms::setBlockBinding) reads it, so a change costs one
+// buffer update no matter how many programs exist. With a StreamBuffer the block is written into
+// its mapped memory and bound as a range of it. Needs a current GL context
+class UniformBuffer {
+    public:
+        UniformBuffer(GLuint bindingPoint, size_t size);
+        ~UniformBuffer();
+        UniformBuffer(UniformBuffer const&) = delete;
+        UniformBuffer& operator=(UniformBuffer const&) = delete;
+
+        // data has to match the block's std140 layout, updates equal to the last one are skipped.
+        // With a stream the block's copy expires when its region comes around again, update has to be called every frame
+        void update(void const* data);
+        void setStreamBuffer(StreamBuffer* stream); // nullptr uses the buffer's own storage
+        GLuint getHandle() const;
+        GLuint getBindingPoint() const;
+        unsigned getUpdateCount() const; // changes of the data so far
+
+    private:
+        GLuint _handle;
+        GLuint _bindingPoint;
+        vector<unsigned char> _shadow;
+        bool _hasData;
+        unsigned _updateCount;
+        StreamBuffer* _stream;
+        bool _isStreamed; // the binding point is attached to a range of the stream
+        unsigned _streamFrame; // StreamBuffer::getFrame() of the last write into the stream
+        size_t _offsetAlignment; // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+};
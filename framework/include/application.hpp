@@ -6,13 +6,18 @@
 #include <glm/gtc/type_precision.hpp>
 
 #include <map>
+#include <vector>
 
 struct GLFWwindow;
 // gpu representation of model
 class Application {
  public:
+  // open a window, or an offscreen context with --headless, and render until it is closed
+  // or the given number of frames was drawn, see utils::run_options
   template<typename T>
   static void run(int argc, char* argv[], unsigned ver_major, unsigned ver_minor);
+  // print frame count, fps and frame time percentiles of a run
+  static void print_timing_summary(std::vector<double> frame_times, double seconds);
 
   // allocate and initialize objects
   Application(std::string const& resource_path);
@@ -37,6 +42,10 @@ class Application {
   inline virtual void mouseCallback(double pos_x, double pos_y) {};
   // update framebuffer textures
   inline virtual void resizeCallback(unsigned width, unsigned height) {};
+  // update scene state, called every frame before render()
+  inline virtual void update() {};
+  // called once after the last frame, before the application is deleted
+  inline virtual void finish() {};
   // draw all objects
   virtual void render() const = 0;
 
@@ -56,16 +65,40 @@ class Application {
 
 #include "utils.hpp"
 #include "window_handler.hpp"
+#include "Profiler.hpp"
+#include "Timer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
 
 template<typename T>
 void Application::run(int argc, char* argv[], unsigned ver_major, unsigned ver_minor) {  
 
-    GLFWwindow* window = window_handler::initialize(initial_resolution, ver_major, ver_minor);
+    utils::run_options options = utils::read_run_options(argc, argv);
+    glm::uvec2 resolution = options.resolution.x > 0 ? options.resolution : initial_resolution;
+    GLFWwindow* window = nullptr;
+    window_handler::headless_context* headless = nullptr;
+    if (options.headless) {
+      headless = window_handler::initialize_headless(resolution, ver_major, ver_minor);
+      if (!headless) {
+        std::exit(EXIT_FAILURE);
+      }
+    }
+    else {
+      window = window_handler::initialize(resolution, ver_major, ver_minor);
+    }
+    Timer::setFixedTimestep(options.timestep);
     
     std::string resource_path = utils::read_resource_path(argc, argv);
     T* application = new T{resource_path};
 
-    window_handler::set_callback_object(window, application);
+    if (window) {
+      window_handler::set_callback_object(window, application);
+    }
+    if (resolution != initial_resolution) {
+      application->resize_callback(resolution.x, resolution.y);
+    }
 
     // do intial shader load an uniform upload
     application->reloadShaders(true);
@@ -75,21 +108,69 @@ void Application::run(int argc, char* argv[], unsigned ver_major, unsigned ver_m
     glDepthFunc(GL_LESS);
     
     // rendering loop
-    while (!glfwWindowShouldClose(window)) {
-      // query input
-      glfwPollEvents();
+    Profiler& profiler = Profiler::getInstance();
+    // frame times are only kept for the summary of a run with a frame count, an interactive session would grow them without bound
+    std::vector<double> frame_times;
+    frame_times.reserve(options.frames);
+    unsigned frame_count = 0;
+    auto run_start = std::chrono::steady_clock::now();
+    auto is_running = [&]() {
+      bool is_open = headless || !glfwWindowShouldClose(window);
+      return is_open && (options.frames == 0 || frame_count < options.frames);
+    };
+    while (is_running()) {
+      auto frame_start = std::chrono::steady_clock::now();
+      profiler.beginFrame();
+      if (window) {
+        // query input
+        PROFILE_SCOPE("Poll events");
+        glfwPollEvents();
+      }
       // clear buffer
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-      // draw geometry
-      application->render();
-      // swap draw buffer to front
-      glfwSwapBuffers(window);
-      // display fps
-      window_handler::show_fps(window);
+      {
+        // animate and prepare draw data
+        PROFILE_SCOPE("Update");
+        application->update();
+      }
+      {
+        // draw geometry
+        PROFILE_SCOPE("Render");
+        application->render();
+      }
+      if (window) {
+        // swap draw buffer to front, includes waiting for vsync
+        PROFILE_SCOPE("Swap buffers");
+        glfwSwapBuffers(window);
+        // display fps
+        window_handler::show_fps(window);
+      }
+      else {
+        // nothing is presented, wait for the gpu so frame times include its work
+        PROFILE_SCOPE("Finish");
+        glFinish();
+      }
+      profiler.endFrame();
+      ++frame_count;
+      if (options.frames > 0) {
+        frame_times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count());
+      }
     }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+    application->finish();
 
+    if (options.frames > 0) {
+      print_timing_summary(frame_times, seconds);
+    }
+    if (!options.trace_path.empty() && !profiler.exportChromeTrace(options.trace_path)) {
+      std::cerr << "Could not write " << options.trace_path << std::endl;
+    }
     delete application;
-    window_handler::close_and_quit(window, EXIT_SUCCESS);
+    if (window) {
+      window_handler::close_and_quit(window, EXIT_SUCCESS);
+    }
+    window_handler::close_headless(headless);
+    std::exit(EXIT_SUCCESS);
 }
 
 
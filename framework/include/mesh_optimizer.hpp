@@ -0,0 +1,59 @@
+#ifndef MESH_OPTIMIZER_HPP
+#define MESH_OPTIMIZER_HPP
+
+#include "model.hpp"
+
+#include <vector>
+
+// index and vertex order of triangle lists for the GPU's vertex caches
+namespace mesh_optimizer {
+
+// post transform cache use of a triangle list, simulated with a FIFO cache
+struct cache_statistics {
+  // average cache miss ratio, transformed vertices per triangle: 3 at worst, about 0.5 for large regular meshes
+  float acmr = 0.0f;
+  // average transformed vertex ratio, transformed vertices per referenced vertex: 1 at best
+  float atvr = 0.0f;
+};
+
+// result of optimize, cache statistics simulated with FIFO_CACHE_SIZE entries
+struct statistics {
+  std::size_t vertex_num_before = 0;
+  std::size_t vertex_num_after = 0;
+  cache_statistics before;
+  cache_statistics after;
+};
+
+// entries of the simulated FIFO cache, about the post transform cache of current GPUs
+std::size_t const FIFO_CACHE_SIZE = 16;
+// entries of the LRU cache the triangle order is optimized for
+std::size_t const LRU_CACHE_SIZE = 32;
+
+// all zero if an index is vertex_num or larger
+cache_statistics analyze(std::vector<GLuint> const& indices, std::size_t vertex_num, std::size_t cache_size = FIFO_CACHE_SIZE);
+
+// merges bitwise identical vertices of stride floats each, the first one of equal vertices is kept.
+// Nothing changes if an index is past the vertices
+void weld(std::vector<GLfloat>& data, std::size_t stride, std::vector<GLuint>& indices);
+
+// triangle order for a post transform cache of cache_size entries, Tom Forsyth's linear speed vertex cache optimisation
+void reorder_triangles(std::vector<GLuint>& indices, std::size_t vertex_num, std::size_t cache_size = LRU_CACHE_SIZE);
+
+// vertices in order of first use by the triangles for locality of vertex fetches, unreferenced vertices are removed
+void reorder_vertices(std::vector<GLfloat>& data, std::size_t stride, std::vector<GLuint>& indices);
+
+// all three steps on an indexed triangle model. A model whose data is no whole number of vertices
+// or whose indices go past them is left as it is
+statistics optimize(model& mesh);
+
+// quadric error metric simplification (Garland and Heckbert) by half edge collapses down to triangle_budget triangles:
+// a vertex moves onto a neighbour, so the remaining vertices keep their attributes. Vertices at the same position move
+// together, those on attribute seams only along the seam. Collapses which would fold a triangle over or make the surface
+// non manifold are skipped, so the budget may not be reached. The result is ordered for the vertex caches like optimize.
+// Returns an upper bound of the largest distance of a vertex of the original mesh to the simplified surface, in model
+// space: the distance to the nearest remaining triangle at or next to the vertex it was collapsed onto. Infinite if no triangle is left
+float simplify(model& mesh, std::size_t triangle_budget);
+
+}
+
+#endif
@@ -2,12 +2,26 @@
 #define MODEL_HPP
 
 #include <glbinding/gl/types.h>
+#include <glbinding/gl/enum.h>
+#include <glm/gtc/type_precision.hpp>
 
 #include <map>
+#include <memory>
 #include <vector>
 // use gl definitions from glbinding 
 using namespace gl;
 
+// bounding volumes of vertex positions in model space
+struct bounding_volume {
+  // sphere around the box center
+  glm::fvec3 center{0.0f};
+  // negative if unknown, unbounded geometry is never culled
+  float radius = -1.0f;
+  // axis aligned bounding box
+  glm::fvec3 min{0.0f};
+  glm::fvec3 max{0.0f};
+};
+
 // holds vertex information and triangle indices
 struct model {
 
@@ -16,11 +30,13 @@ struct model {
   // type holding info about a vertex/model attribute
   struct attribute {
 
-    attribute(attrib_flag_t f, GLsizei s, GLsizei c, GLenum t)
+    attribute(attrib_flag_t f, GLsizei s, GLsizei c, GLenum t, GLboolean n = GL_FALSE)
      :flag{f}
      ,size{s}
      ,components{c}
      ,type{t}
+     ,normalized{n}
+     ,offset{nullptr}
     {}
 
     // conversion to flag type for use as enum
@@ -36,6 +52,8 @@ struct model {
     GLint components;
     // Gl type
     GLenum type;
+    // integer components are read as floats in [0, 1] or [-1, 1], as the normalized argument of glVertexAttribPointer
+    GLboolean normalized;
     // offset from element beginning
     GLvoid* offset;
   };
@@ -50,6 +68,18 @@ struct model {
   static attribute const& BITANGENT;
   // is not a vertex attribute, so not stored in VERTEX_ATTRIBS
   static attribute const  INDEX;
+  // quantized formats of the attributes above, see model_loader::pack and vertex_packing
+  // unit normal in octahedral encoding as 2 x snorm16, decoded by the vertex shader
+  static attribute const  NORMAL_OCTAHEDRAL;
+  // texture coordinates in [0, 1] as 2 x unorm16
+  static attribute const  TEXCOORD_UNORM16;
+  // texture coordinates outside of [0, 1] as 2 x half float
+  static attribute const  TEXCOORD_HALF;
+  // unit tangent and bitangent as 10_10_10_2 snorm, the tangent's w is the handedness of the tangent frame
+  static attribute const  TANGENT_PACKED;
+  static attribute const  BITANGENT_PACKED;
+  // indices of meshes with at most 65536 vertices
+  static attribute const  INDEX_16;
   
   model();
   model(std::vector<GLfloat> const& databuff, attrib_flag_t attribs, std::vector<GLuint> const& trianglebuff = std::vector<GLuint>{});
@@ -61,6 +91,34 @@ struct model {
   // size of one vertex element in bytes
   GLsizei vertex_bytes;
   std::size_t vertex_num;
+  // computed by model_loader
+  bounding_volume bounds;
+  // upper bound of the distance of the original vertices to the surface of a simplified level of detail in model space,
+  // 0 for the original, see model_loader::lod_chain
+  float lod_error;
+};
+
+// vertex information and triangle indices like model, but read only and not owned,
+// e.g. a memory mapped mesh cache whose data can be uploaded without copying
+struct mesh_data {
+  // interleaved attributes, layout given by offsets and vertex_bytes as in model::data,
+  // the type of each attribute by formats
+  void const* vertices = nullptr;
+  // of index_type, GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
+  void const* indices = nullptr;
+  std::size_t vertex_num = 0;
+  std::size_t index_num = 0;
+  model::attrib_flag_t attributes = 0;
+  std::map<model::attrib_flag_t, GLvoid*> offsets;
+  // contained attributes in interleaved order with their offsets, the float ones of
+  // model::VERTEX_ATTRIBS or quantized ones like model::NORMAL_OCTAHEDRAL
+  std::vector<model::attribute> formats;
+  GLenum index_type = GL_UNSIGNED_INT;
+  GLsizei vertex_bytes = 0;
+  bounding_volume bounds;
+  float lod_error = 0.0f;
+  // keeps the memory behind vertices and indices alive, e.g. the file mapping
+  std::shared_ptr<void const> storage;
 };
 
 #endif
\ No newline at end of file
@@ -5,9 +5,43 @@
 
 #include "tiny_obj_loader.h"
 
+class TaskPool;
+
 namespace model_loader {
 
-model obj(std::string const& path, model::attrib_flag_t import_attribs = model::POSITION);
+// tinyobj::LoadObj with the same shapes, materials and error string, but the file is memory mapped and split at
+// line boundaries into chunks which are parsed in parallel on task_pool. Without one, files of a few MB get a pool
+// with one thread per hardware thread, smaller ones are parsed on the calling thread
+std::string parse_obj(std::vector<tinyobj::shape_t>& shapes, std::vector<tinyobj::material_t>& materials,
+                      std::string const& path, TaskPool* task_pool = nullptr);
+
+// optimize welds identical vertices and orders triangles and vertices for the vertex caches, see mesh_optimizer
+model obj(std::string const& path, model::attrib_flag_t import_attribs = model::POSITION, bool optimize = true);
+
+// quantized copy of mesh with about half the vertex and index memory: normals in octahedral encoding as 2 x snorm16,
+// texture coordinates as 2 x unorm16 if all are in [0, 1] and as half floats otherwise, tangents and bitangents
+// as 10_10_10_2 snorm and 16 bit indices for up to 65536 vertices. Positions stay floats, see model::NORMAL_OCTAHEDRAL
+mesh_data pack(model const& mesh);
+
+// obj through a binary cache next to it (path + ".mesh"), written on the first load and memory mapped afterwards.
+// The cache is rebuilt when the source changed, known by size and modification time or if these differ by content hash,
+// or when it was written with other import_attribs, optimize, packed or another format version. If it cannot be written
+// the parsed model is returned in memory. packed stores the mesh quantized by pack
+mesh_data cached_obj(std::string const& path, model::attrib_flag_t import_attribs = model::POSITION, bool optimize = true, bool packed = false);
+
+// levels of detail of mesh for drawing at a distance: mesh itself, then one level for each budget below its triangle count,
+// simplified from mesh by mesh_optimizer::simplify to at most that many triangles, largest first. A level which could not
+// get below the previous one or lost the whole surface is left out. lod_error of each level bounds the distance of the
+// vertices of mesh to its surface in model space, see mesh_optimizer::simplify. The bounds are those of mesh
+std::vector<model> lod_chain(model const& mesh, std::vector<std::size_t> const& triangle_budgets);
+
+// lod_chain of the optimized obj through binary caches like cached_obj, level 0 in path + ".mesh"
+// and the others in path + ".lod<budget>.mesh"
+std::vector<mesh_data> cached_lod_chain(std::string const& path, model::attrib_flag_t import_attribs,
+                                        std::vector<std::size_t> const& triangle_budgets, bool packed = false);
+
+// bounding box and sphere of interleaved vertex data, positions are the first 3 of stride floats per vertex
+bounding_volume bounds(std::vector<float> const& vertex_data, std::size_t stride);
 
 }
 
@@ -0,0 +1,43 @@
+#ifndef SIMD_MATH_HPP
+#define SIMD_MATH_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstddef>
+
+// batched matrix kernels with SSE/AVX implementations and scalar fallback,
+// the fastest instruction set supported by the cpu is selected at runtime
+namespace simd_math {
+  enum class instruction_set { scalar, sse, avx };
+
+  // best instruction set supported by cpu and os
+  instruction_set detect();
+  // instruction set currently used by the kernels
+  instruction_set active();
+  // use given instruction set (clamped to detected one), e.g. for A/B comparisons
+  void force(instruction_set set);
+  // printable name of instruction set
+  char const* name(instruction_set set);
+
+  // out[i] = lhs[i] * rhs[i]
+  void multiply(glm::fmat4 const* lhs, glm::fmat4 const* rhs, glm::fmat4* out, std::size_t count);
+  // out[i] = lhs * rhs[i]
+  void multiply(glm::fmat4 const& lhs, glm::fmat4 const* rhs, glm::fmat4* out, std::size_t count);
+  // hierarchy sweep over entries [begin, end), parents[i] < i or -1 for roots: worlds[i] = worlds[parents[i]] * locals[i]
+  // for entries that are dirty or have a dirty parent, recomputed entries are flagged dirty.
+  // Parents before begin must be final, so disjoint subtrees can be swept concurrently
+  void multiply_hierarchy(glm::fmat4 const* locals, int const* parents, unsigned char* dirty, glm::fmat4* worlds, std::size_t begin, std::size_t end);
+  // inverse of affine matrices (last row is 0, 0, 0, 1)
+  void affine_inverse(glm::fmat4 const* in, glm::fmat4* out, std::size_t count);
+  // out[i] = inverseTranspose(view * models[i]), view and models must be affine
+  void normal_matrix(glm::fmat4 const& view, glm::fmat4 const* models, glm::fmat4* out, std::size_t count);
+
+  // normalized planes (xyz normal pointing inside, w distance) of the view frustum, order left, right, bottom, top, near, far
+  void frustum_planes(glm::fmat4 const& view_projection, glm::fvec4 planes[6]);
+  // visible[i] = 1 if sphere i (structure of arrays) is not completely outside one of the 6 planes, else 0.
+  // Returns the number of visible spheres, a sphere with infinite radius is always visible
+  std::size_t cull_spheres(glm::fvec4 const planes[6], float const* x, float const* y, float const* z, float const* radius,
+                           unsigned char* visible, std::size_t count);
+}
+
+#endif
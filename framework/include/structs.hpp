@@ -3,6 +3,8 @@
 
 #include <map>
 #include <glbinding/gl/gl.h>
+#include "ShaderUniforms.hpp"
+#include "model.hpp"
 // use gl definitions from glbinding 
 using namespace gl;
 
@@ -18,6 +20,13 @@ struct model_object {
   GLenum draw_mode = GL_NONE;
   // indices number, if EBO exists
   GLsizei num_elements = 0;
+  // range in the buffers of a GeometryArena, see GeometryArena::add
+  GLuint first_index = 0;
+  GLint base_vertex = 0;
+  // model space bounds for culling
+  bounding_volume bounds;
+  // distance to the original surface of a simplified level of detail, see GeometryNode::selectLod
+  float lod_error = 0.0f;
 };
 
 // gpu representation of texture
@@ -26,6 +35,8 @@ struct texture_object {
   GLuint handle = 0;
   // binding point
   GLenum target = GL_NONE;
+  // layer of an array texture
+  unsigned layer = 0;
 };
 
 // shader handle and uniform storage
@@ -41,5 +52,7 @@ struct shader_program {
   GLuint handle;
   // uniform locations mapped to name
   std::map<std::string, GLint> u_locs{};
+  // active uniforms by handle, the shadow copy of their values changes in const render functions
+  mutable ShaderUniforms uniforms{};
 };
 #endif
\ No newline at end of file
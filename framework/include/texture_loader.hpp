@@ -7,6 +7,9 @@
 
 namespace texture_loader {
   pixel_data file(std::string const& file_name);
+  // bilinear resample of 8 bit image data to rgba with given size, missing channels
+  // are filled like glTexImage does (green/blue 0, alpha 1), e.g. for layers of an array texture
+  pixel_data resize_rgba(pixel_data const& image, std::size_t width, std::size_t height);
 }
 
 #endif
\ No newline at end of file
@@ -8,6 +8,7 @@ using namespace gl;
 #include <glm/gtc/type_precision.hpp>
 
 #include <map>
+#include <string>
 #include <vector>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -15,6 +16,15 @@ struct pixel_data;
 struct texture_object;
 
 namespace utils {
+  // command line options of Application::run, given as --name or --name=value
+  struct run_options {
+    bool headless = false;          // --headless, offscreen context without window, see window_handler::initialize_headless
+    unsigned frames = 0;            // --frames=N, 0 runs until the window is closed (300 when headless)
+    double timestep = 0.0;          // --timestep=S, fixed seconds per frame for the animation, 0 uses the real time (1/60 when headless)
+    glm::uvec2 resolution{0u, 0u};  // --size=WxH, 0 keeps the initial resolution
+    std::string trace_path{};       // --trace=FILE, write the profiler's chrome trace when the loop ends
+  };
+
   // generate texture object from texture struct
   texture_object create_texture_object(pixel_data const& tex);
   // print bound textures for all texture units
@@ -29,12 +39,18 @@ namespace utils {
   // return handle of bound vertex array object
   GLint get_bound_VAO();
 
+  // true if the current context has at least GL major.minor or the extension, e.g. (4, 3, "GL_ARB_multi_draw_indirect")
+  bool has_gl_support(int major, int minor, char const* extension);
+
   // read file and write content to string
   std::string read_file(std::string const& name);
 
-  // return path to resources depending on cmdline args
+  // return path to resources depending on cmdline args, the first argument which is not an option
   std::string read_resource_path(int argc, char* argv[]);
 
+  // parse --options, exits with usage on unknown ones
+  run_options read_run_options(int argc, char* argv[]);
+
   // calculate Vert+ FOV projection matrix
   glm::fmat4 calculate_projection_matrix(float aspect);
 
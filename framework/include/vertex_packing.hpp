@@ -0,0 +1,41 @@
+#ifndef VERTEX_PACKING_HPP
+#define VERTEX_PACKING_HPP
+
+#include "model.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// conversion of float vertex attributes to the quantized formats of model and back,
+// with the conversion rules of GL for normalized integers (GL 4.2 and later)
+namespace vertex_packing {
+
+// unit vector on the octahedron |x| + |y| + |z| = 1, whose lower half is folded over the upper one onto the square [-1, 1]^2,
+// as 2 x snorm16. The zero vector encodes (0, 0, 1)
+glm::i16vec2 octahedral(glm::fvec3 const& normal);
+glm::fvec3 from_octahedral(glm::fvec2 const& encoded);
+
+// value clamped to [0, 1]
+std::uint16_t unorm16(float value);
+// value clamped to [-1, 1]
+std::int16_t snorm16(float value);
+
+// IEEE 754 half float, rounded to nearest even, out of range values become infinity
+std::uint16_t half_float(float value);
+float from_half_float(std::uint16_t half);
+
+// xyz as 10 bit and w as 2 bit snorm, in the bit order of GL_INT_2_10_10_10_REV, values clamped to [-1, 1]
+std::uint32_t snorm_10_10_10_2(glm::fvec4 const& value);
+
+// attribute of format at its offset in vertex as floats, missing components are 0 and w is 1.
+// Normals in octahedral encoding are returned decoded
+glm::fvec4 read(void const* vertex, model::attribute const& format);
+
+// float formats of the attributes of mesh with their offsets, in interleaved order
+std::vector<model::attribute> formats(model const& mesh);
+
+}
+
+#endif
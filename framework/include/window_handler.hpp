@@ -12,12 +12,31 @@ class Application;
 struct GLFWwindow;
 
 namespace window_handler { 
-  // create window and set callbacks
+  // how GL errors are reported, the cost grows with the level
+  enum class validation_level {
+    none,         // no checks, GL calls go straight to the driver
+    debug_output, // KHR_debug messages, the driver reports them asynchronously without stalling
+    full          // glGetError after every call and synchronous debug messages, names the failing call but serializes the driver
+  };
+  // GL_VALIDATION environment variable (none, debug_output or full) or the build default, full in Debug builds and none otherwise
+  validation_level default_validation_level();
+  // change error checking of the current context, debug messages need a debug context, see initialize()
+  void set_validation_level(validation_level level);
+  validation_level get_validation_level();
+  char const* to_string(validation_level level);
+  // create window and set callbacks, requests a debug context unless the default validation level is none
   GLFWwindow* initialize(glm::uvec2 const& resolution, unsigned ver_major, unsigned ver_minor);
   // load shader programs and update uniform locations
   void set_callback_object(GLFWwindow* window, Application* app);
   // free resources
   void close_and_quit(GLFWwindow* window, int status);
+
+  // offscreen context without window or display
+  struct headless_context;
+  // GL context on an EGL pbuffer surface of the given size, works without X with Mesa's llvmpipe.
+  // nullptr if the framework was built without EGL or no such context could be created
+  headless_context* initialize_headless(glm::uvec2 const& resolution, unsigned ver_major, unsigned ver_minor);
+  void close_headless(headless_context* context);
     // calculate fps and show in window title
   void show_fps(GLFWwindow* window);
 }
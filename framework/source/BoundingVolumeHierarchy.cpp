@@ -0,0 +1,432 @@
+#include "BoundingVolumeHierarchy.hpp"
+#include "GeometryNode.hpp"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/vector_relational.hpp>
+using glm::fmat4;
+using std::vector;
+
+typedef BoundingVolumeHierarchy::Box Box;
+
+static const float MARGIN_SCALE = 0.1f;       // leaf margin relative to the leaf's size
+static const float PREDICTION_SCALE = 2.0f;   // extra margin in the direction of the last movement, in movements
+static const float REBUILD_COST_RATIO = 1.5f; // rebuild when the cost grew by this factor since the last build
+static const size_t REBUILD_INSERT_DIVISOR = 4; // rebuild instead of inserting when more than 1/4 of the leaves are new
+static const float INFINITE_DISTANCE = std::numeric_limits<float>::infinity();
+
+const int BoundingVolumeHierarchy::NO_LEAF;
+const int BoundingVolumeHierarchy::NO_NODE;
+const size_t BoundingVolumeHierarchy::MIN_REINSERTS;
+
+static Box merge(Box const& a, Box const& b) { return Box{glm::min(a.min, b.min), glm::max(a.max, b.max)}; }
+static bool contains(Box const& outer, Box const& inner) {
+    return glm::all(glm::lessThanEqual(outer.min, inner.min)) && glm::all(glm::lessThanEqual(inner.max, outer.max));
+}
+static float surfaceArea(Box const& box) {
+    fvec3 size = box.max - box.min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+// box around the model space bounding box after transformation (Arvo)
+static Box worldBox(bounding_volume const& bounds, fmat4 const& world) {
+    fvec3 center = fvec3{world * fvec4{(bounds.min + bounds.max) * 0.5f, 1.0f}};
+    fvec3 halfSize = (bounds.max - bounds.min) * 0.5f;
+    fvec3 extent = glm::abs(fvec3{world[0]}) * halfSize.x + glm::abs(fvec3{world[1]}) * halfSize.y + glm::abs(fvec3{world[2]}) * halfSize.z;
+    return Box{center - extent, center + extent};
+}
+
+static bool overlapsSphere(Box const& box, fvec3 const& center, float radius) {
+    fvec3 offset = glm::clamp(center, box.min, box.max) - center;
+    return glm::dot(offset, offset) <= radius * radius;
+}
+
+// distance at which the ray enters the box, infinite if it misses the box before maxDistance
+static float intersectRay(Box const& box, fvec3 const& origin, fvec3 const& inverseDirection, float maxDistance) {
+    fvec3 t0 = (box.min - origin) * inverseDirection;
+    fvec3 t1 = (box.max - origin) * inverseDirection;
+    fvec3 tNear = glm::min(t0, t1);
+    fvec3 tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+    return enter <= exit ? enter : INFINITE_DISTANCE;
+}
+
+// bit p of the result is set if the box is not completely inside plane p, 0 means inside the frustum.
+// Only planes in mask are tested, returns ~0u if the box is outside one of them
+static unsigned classifyFrustum(Box const& box, fvec4 const* planes, unsigned mask) {
+    unsigned intersected = 0;
+    for (unsigned p = 0; p < 6; ++p) {
+        if (!(mask & (1u << p))) { continue; }
+        fvec3 normal{planes[p]};
+        // corners furthest along and against the plane normal
+        fvec3 positive{normal.x >= 0.0f ? box.max.x : box.min.x, normal.y >= 0.0f ? box.max.y : box.min.y, normal.z >= 0.0f ? box.max.z : box.min.z};
+        fvec3 negative{normal.x >= 0.0f ? box.min.x : box.max.x, normal.y >= 0.0f ? box.min.y : box.max.y, normal.z >= 0.0f ? box.min.z : box.max.z};
+        if (glm::dot(normal, positive) + planes[p].w < 0.0f) { return ~0u; }
+        if (glm::dot(normal, negative) + planes[p].w < 0.0f) { intersected |= 1u << p; }
+    }
+    return intersected;
+}
+
+// per thread traversal stack, so const queries can run concurrently without allocating
+struct StackEntry {
+    int id;
+    unsigned planeMask;
+    float distance;
+};
+static vector<StackEntry>& traversalStack() {
+    static thread_local vector<StackEntry> stack;
+    stack.clear();
+    return stack;
+}
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy() :
+    _root(NO_NODE),
+    _innerArea(0.0),
+    _builtCost(0.0f),
+    _updateCount(0) {
+}
+
+int BoundingVolumeHierarchy::insert(GeometryNode* node) {
+    int leaf = allocateNode();
+    TreeNode& treeNode = _nodes[leaf];
+    treeNode.geometry = node;
+    treeNode.transform = node->getTransformHandle();
+    treeNode.isUnbounded = node->getBounds().radius < 0.0f;
+    vector<int>& list = treeNode.isUnbounded ? _unbounded : _leaves;
+    treeNode.listIndex = unsigned(list.size());
+    list.push_back(leaf);
+    if (!treeNode.isUnbounded) {
+        treeNode.isPending = true;
+        _pendingLeaves.push_back(leaf);
+        if (_leafOfTransform.size() <= treeNode.transform) { _leafOfTransform.resize(treeNode.transform + 1, NO_NODE); }
+        _leafOfTransform[treeNode.transform] = leaf;
+    }
+    return leaf;
+}
+
+void BoundingVolumeHierarchy::remove(int leaf, Node const* node) {
+    if (leaf < 0 || size_t(leaf) >= _nodes.size() || _nodes[leaf].geometry != node || !_nodes[leaf].isLeaf()) { return; }
+    if (_nodes[leaf].isLinked) { removeLeaf(leaf); }
+    if (!_nodes[leaf].isUnbounded) { _leafOfTransform[_nodes[leaf].transform] = NO_NODE; }
+    // the last leaf of the list takes the place of the removed one
+    vector<int>& list = _nodes[leaf].isUnbounded ? _unbounded : _leaves;
+    unsigned index = _nodes[leaf].listIndex;
+    list[index] = list.back();
+    list.pop_back();
+    if (index < list.size()) { _nodes[list[index]].listIndex = index; }
+    freeNode(leaf);
+}
+
+void BoundingVolumeHierarchy::clear() {
+    _nodes.clear();
+    _freeNodes.clear();
+    _leaves.clear();
+    _unbounded.clear();
+    _pendingLeaves.clear();
+    _leafOfTransform.clear();
+    _root = NO_NODE;
+    _innerArea = 0.0;
+    _builtCost = 0.0f;
+    _statistics = Statistics();
+}
+
+void BoundingVolumeHierarchy::update(TransformHierarchy const& transforms) {
+    _statistics.refits = 0;
+    _statistics.reinserts = 0;
+    _escapedLeaves.clear();
+    _newLeaves.clear();
+    ++_updateCount;
+
+    // 1. first box of new leaves, refit of leaves whose transform changed and which left their margin
+    for (int leaf : _pendingLeaves) {
+        TreeNode& node = _nodes[leaf];
+        if (!node.isPending) { continue; } // removed, or listed twice because its id was reused
+        node.isPending = false;
+        node.tightBox = worldBox(node.geometry->getBounds(), transforms.getWorldTransform(node.transform));
+        fvec3 margin = (node.tightBox.max - node.tightBox.min) * MARGIN_SCALE;
+        node.box = Box{node.tightBox.min - margin, node.tightBox.max + margin};
+        _newLeaves.push_back(leaf);
+    }
+    _pendingLeaves.clear();
+    _updatedTransforms.clear();
+    transforms.collectUpdated(_updatedTransforms);
+    for (TransformHierarchy::Handle transform : _updatedTransforms) {
+        int leaf = transform < _leafOfTransform.size() ? _leafOfTransform[transform] : NO_NODE;
+        if (leaf == NO_NODE || !_nodes[leaf].isLinked) { continue; }
+        TreeNode& node = _nodes[leaf];
+        Box tight = worldBox(node.geometry->getBounds(), transforms.getWorldTransform(transform));
+        fvec3 movement = ((tight.min + tight.max) - (node.tightBox.min + node.tightBox.max)) * (0.5f * PREDICTION_SCALE);
+        node.tightBox = tight;
+        if (contains(node.box, tight)) { continue; }
+        // new margin, stretched towards where the leaf is moving
+        fvec3 margin = (tight.max - tight.min) * MARGIN_SCALE;
+        node.box = Box{tight.min - margin + glm::min(movement, fvec3{0.0f}), tight.max + margin + glm::max(movement, fvec3{0.0f})};
+        refitAncestors(leaf);
+        _escapedLeaves.push_back(leaf);
+    }
+    _statistics.refits = _escapedLeaves.size();
+
+    if (_newLeaves.size() * REBUILD_INSERT_DIVISOR > _leaves.size()) {
+        for (int leaf : _newLeaves) { _nodes[leaf].isLinked = true; }
+        rebuild();
+        return;
+    }
+    for (int leaf : _newLeaves) { insertLeaf(leaf); }
+
+    // 2. reinsert some of the refit leaves, a different part of them in every update
+    size_t reinserts = std::min(_escapedLeaves.size(), std::max(MIN_REINSERTS, _leaves.size() / 64));
+    size_t offset = _escapedLeaves.empty() ? 0 : (_updateCount * reinserts) % _escapedLeaves.size();
+    for (size_t i = 0; i < reinserts; ++i) {
+        int leaf = _escapedLeaves[(offset + i) % _escapedLeaves.size()];
+        removeLeaf(leaf);
+        insertLeaf(leaf);
+    }
+    _statistics.reinserts = reinserts;
+
+    // 3. rebuild once the tree got too loose
+    _statistics.cost = computeCost();
+    if (_builtCost <= 0.0f) { _builtCost = _statistics.cost; }
+    if (_statistics.cost > _builtCost * REBUILD_COST_RATIO) { rebuild(); }
+    _statistics.leaves = _leaves.size();
+    _statistics.unboundedNodes = _unbounded.size();
+}
+
+void BoundingVolumeHierarchy::rebuild() {
+    // inner nodes are dropped, leaves keep their ids since the scenegraph refers to them
+    for (size_t id = 0; id < _nodes.size(); ++id) {
+        if (!_nodes[id].isLeaf()) { freeNode(int(id)); }
+    }
+    _innerArea = 0.0;
+    _buildLeaves.clear();
+    for (int leaf : _leaves) {
+        if (_nodes[leaf].isLinked) { _buildLeaves.push_back(leaf); }
+    }
+    _root = _buildLeaves.empty() ? NO_NODE : build(_buildLeaves.data(), _buildLeaves.data() + _buildLeaves.size());
+    _statistics.cost = computeCost();
+    _builtCost = _statistics.cost;
+    ++_statistics.rebuilds;
+    _statistics.leaves = _leaves.size();
+    _statistics.unboundedNodes = _unbounded.size();
+}
+
+void BoundingVolumeHierarchy::queryFrustum(fvec4 const planes[6], vector<GeometryNode*>& result) const {
+    for (int leaf : _unbounded) { result.push_back(_nodes[leaf].geometry); }
+    if (_root == NO_NODE) { return; }
+    // plane masking: planes a box is completely inside of are not tested again for its children
+    vector<StackEntry>& stack = traversalStack();
+    stack.push_back(StackEntry{_root, 0x3Fu, 0.0f});
+    while (!stack.empty()) {
+        StackEntry entry = stack.back();
+        stack.pop_back();
+        TreeNode const& node = _nodes[entry.id];
+        unsigned mask = entry.planeMask;
+        if (mask != 0) {
+            mask = classifyFrustum(node.isLeaf() ? node.tightBox : node.box, planes, mask);
+            if (mask == ~0u) { continue; }
+        }
+        if (node.isLeaf()) {
+            result.push_back(node.geometry);
+            continue;
+        }
+        stack.push_back(StackEntry{node.left, mask, 0.0f});
+        stack.push_back(StackEntry{node.right, mask, 0.0f});
+    }
+}
+
+void BoundingVolumeHierarchy::querySphere(fvec3 const& center, float radius, vector<GeometryNode*>& result) const {
+    if (_root == NO_NODE) { return; }
+    vector<StackEntry>& stack = traversalStack();
+    stack.push_back(StackEntry{_root, 0, 0.0f});
+    while (!stack.empty()) {
+        TreeNode const& node = _nodes[stack.back().id];
+        stack.pop_back();
+        if (!overlapsSphere(node.isLeaf() ? node.tightBox : node.box, center, radius)) { continue; }
+        if (node.isLeaf()) {
+            result.push_back(node.geometry);
+            continue;
+        }
+        stack.push_back(StackEntry{node.left, 0, 0.0f});
+        stack.push_back(StackEntry{node.right, 0, 0.0f});
+    }
+}
+
+BoundingVolumeHierarchy::RayHit BoundingVolumeHierarchy::queryRay(fvec3 const& origin, fvec3 const& direction, float maxDistance, TransformHierarchy const& transforms,
+                                                                  Filter const& filter) const {
+    RayHit hit;
+    if (_root == NO_NODE) { return hit; }
+    fvec3 inverseDirection = 1.0f / direction;
+    float nearest = maxDistance;
+    vector<StackEntry>& stack = traversalStack();
+    float rootDistance = intersectRay(_nodes[_root].box, origin, inverseDirection, nearest);
+    if (rootDistance != INFINITE_DISTANCE) { stack.push_back(StackEntry{_root, 0, rootDistance}); }
+    while (!stack.empty()) {
+        StackEntry entry = stack.back();
+        stack.pop_back();
+        if (entry.distance > nearest) { continue; } // a closer hit was found since this box was pushed
+        TreeNode const& node = _nodes[entry.id];
+        if (node.isLeaf()) {
+            if (filter && !filter(node.geometry)) { continue; }
+            // exact test against the world bounding sphere
+            bounding_volume const& bounds = node.geometry->getBounds();
+            fmat4 const& world = transforms.getWorldTransform(node.geometry->getTransformHandle());
+            fvec3 center = fvec3{world * fvec4{bounds.center, 1.0f}};
+            float scale = std::max(glm::length(fvec3{world[0]}), std::max(glm::length(fvec3{world[1]}), glm::length(fvec3{world[2]})));
+            float radius = bounds.radius * scale;
+            fvec3 offset = origin - center;
+            float b = glm::dot(offset, direction);
+            float discriminant = b * b - (glm::dot(offset, offset) - radius * radius);
+            if (discriminant < 0.0f) { continue; }
+            float root = std::sqrt(discriminant);
+            float distance = -b - root >= 0.0f ? -b - root : -b + root; // origin inside the sphere hits its back
+            if (distance >= 0.0f && distance <= nearest) {
+                nearest = distance;
+                hit.node = node.geometry;
+                hit.distance = distance;
+            }
+            continue;
+        }
+        // nearer child is pushed last, so it is visited first
+        float leftDistance = intersectRay(_nodes[node.left].box, origin, inverseDirection, nearest);
+        float rightDistance = intersectRay(_nodes[node.right].box, origin, inverseDirection, nearest);
+        StackEntry left{node.left, 0, leftDistance};
+        StackEntry right{node.right, 0, rightDistance};
+        if (leftDistance < rightDistance) { std::swap(left, right); }
+        if (left.distance != INFINITE_DISTANCE) { stack.push_back(left); }
+        if (right.distance != INFINITE_DISTANCE) { stack.push_back(right); }
+    }
+    return hit;
+}
+
+BoundingVolumeHierarchy::Statistics const& BoundingVolumeHierarchy::getStatistics() const { return _statistics; }
+
+int BoundingVolumeHierarchy::allocateNode() {
+    if (_freeNodes.empty()) {
+        _nodes.push_back(TreeNode());
+        return int(_nodes.size() - 1);
+    }
+    int id = _freeNodes.back();
+    _freeNodes.pop_back();
+    _nodes[id] = TreeNode();
+    return id;
+}
+
+void BoundingVolumeHierarchy::freeNode(int id) {
+    if (!_nodes[id].isLeaf()) { _innerArea -= surfaceArea(_nodes[id].box); }
+    _nodes[id] = TreeNode(); // a freed leaf holds no geometry, so remove() ignores stale leaf ids
+    _freeNodes.push_back(id);
+}
+
+void BoundingVolumeHierarchy::setBox(int id, Box const& box) {
+    _innerArea += surfaceArea(box) - surfaceArea(_nodes[id].box);
+    _nodes[id].box = box;
+}
+
+// Descend towards the child whose box grows least, stop where a new parent next to the current node is cheaper
+void BoundingVolumeHierarchy::insertLeaf(int leaf) {
+    _nodes[leaf].isLinked = true;
+    if (_root == NO_NODE) {
+        _root = leaf;
+        _nodes[leaf].parent = NO_NODE;
+        return;
+    }
+    Box leafBox = _nodes[leaf].box;
+    int sibling = _root;
+    while (!_nodes[sibling].isLeaf()) {
+        TreeNode const& node = _nodes[sibling];
+        float combinedArea = surfaceArea(merge(node.box, leafBox));
+        float parentCost = 2.0f * combinedArea;
+        float inheritedCost = 2.0f * (combinedArea - surfaceArea(node.box)); // growth of this node and its ancestors
+        auto descendCost = [this, &leafBox, inheritedCost](int child) {
+            float cost = surfaceArea(merge(_nodes[child].box, leafBox));
+            if (!_nodes[child].isLeaf()) { cost -= surfaceArea(_nodes[child].box); }
+            return cost + inheritedCost;
+        };
+        float leftCost = descendCost(node.left);
+        float rightCost = descendCost(node.right);
+        if (parentCost < leftCost && parentCost < rightCost) { break; }
+        sibling = leftCost < rightCost ? node.left : node.right;
+    }
+
+    int oldParent = _nodes[sibling].parent;
+    int parent = allocateNode(); // may reallocate _nodes
+    _nodes[parent].parent = oldParent;
+    _nodes[parent].left = sibling;
+    _nodes[parent].right = leaf;
+    setBox(parent, merge(_nodes[sibling].box, leafBox));
+    _nodes[sibling].parent = parent;
+    _nodes[leaf].parent = parent;
+    if (oldParent == NO_NODE) { _root = parent; }
+    else if (_nodes[oldParent].left == sibling) { _nodes[oldParent].left = parent; }
+    else { _nodes[oldParent].right = parent; }
+    refitAncestors(parent);
+}
+
+// The sibling takes the place of the leaf's parent
+void BoundingVolumeHierarchy::removeLeaf(int leaf) {
+    _nodes[leaf].isLinked = false;
+    if (leaf == _root) {
+        _root = NO_NODE;
+        return;
+    }
+    int parent = _nodes[leaf].parent;
+    int grandParent = _nodes[parent].parent;
+    int sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+    _nodes[sibling].parent = grandParent;
+    if (grandParent == NO_NODE) { _root = sibling; }
+    else {
+        if (_nodes[grandParent].left == parent) { _nodes[grandParent].left = sibling; }
+        else { _nodes[grandParent].right = sibling; }
+        refitAncestors(sibling);
+    }
+    freeNode(parent);
+    _nodes[leaf].parent = NO_NODE;
+}
+
+void BoundingVolumeHierarchy::refitAncestors(int id) {
+    for (int parent = _nodes[id].parent; parent != NO_NODE; parent = _nodes[parent].parent) {
+        Box box = merge(_nodes[_nodes[parent].left].box, _nodes[_nodes[parent].right].box);
+        if (glm::all(glm::equal(box.min, _nodes[parent].box.min)) && glm::all(glm::equal(box.max, _nodes[parent].box.max))) { return; }
+        setBox(parent, box);
+    }
+}
+
+// Median split along the axis in which the leaf centers are spread most
+int BoundingVolumeHierarchy::build(int* begin, int* end) {
+    if (end - begin == 1) {
+        _nodes[*begin].parent = NO_NODE;
+        return *begin;
+    }
+    auto center = [this](int leaf) { return _nodes[leaf].box.min + _nodes[leaf].box.max; };
+    Box centers{center(*begin), center(*begin)};
+    for (int* leaf = begin + 1; leaf != end; ++leaf) {
+        centers.min = glm::min(centers.min, center(*leaf));
+        centers.max = glm::max(centers.max, center(*leaf));
+    }
+    fvec3 spread = centers.max - centers.min;
+    int axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : (spread.y >= spread.z ? 1 : 2);
+    int* middle = begin + (end - begin) / 2;
+    std::nth_element(begin, middle, end, [this, axis](int a, int b) {
+        return _nodes[a].box.min[axis] + _nodes[a].box.max[axis] < _nodes[b].box.min[axis] + _nodes[b].box.max[axis];
+    });
+
+    int left = build(begin, middle);
+    int right = build(middle, end);
+    int id = allocateNode();
+    _nodes[id].left = left;
+    _nodes[id].right = right;
+    setBox(id, merge(_nodes[left].box, _nodes[right].box));
+    _nodes[left].parent = id;
+    _nodes[right].parent = id;
+    return id;
+}
+
+// Surface area heuristic: the chance that a random ray hits an inner box is proportional to its area
+float BoundingVolumeHierarchy::computeCost() const {
+    if (_root == NO_NODE || _nodes[_root].isLeaf()) { return 0.0f; }
+    float rootArea = surfaceArea(_nodes[_root].box);
+    return rootArea > 0.0f ? float(_innerArea / rootArea) : 0.0f;
+}
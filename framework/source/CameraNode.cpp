@@ -4,7 +4,7 @@
 using glm::mat4;
 
 CameraNode::CameraNode(string name) :
-    Node(name) {
+    Node(name, NodeType::Camera) {
 
 }
 
@@ -0,0 +1,314 @@
+#include "GeometryArena.hpp"
+#include "StreamBuffer.hpp"
+#include "utils.hpp"
+#include "vertex_packing.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// copies the used part of buffer into a new one of capacity bytes, the vertex array is updated by the caller
+static void growBuffer(GLuint& buffer, size_t usedBytes, size_t capacity) {
+    GLuint grown = 0;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(capacity), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, GLsizeiptr(usedBytes));
+    glDeleteBuffers(1, &buffer);
+    buffer = grown;
+}
+
+GeometryArena::GeometryArena(size_t vertexCapacity, size_t indexCapacity) :
+    _vertexArray(0),
+    _vertexBuffer(0),
+    _indexBuffer(0),
+    _instanceBuffer(0),
+    _instanceSource(0),
+    _indirectBuffer(0),
+    _vertexCapacity(std::max(vertexCapacity, size_t(1))),
+    _indexCapacity(std::max(indexCapacity, size_t(1))),
+    _vertexCount(0),
+    _indexCount(0),
+    _indexType(GL_UNSIGNED_SHORT),
+    _instanceStride(0),
+    _stream(nullptr),
+    _hasMultiDrawIndirect(false),
+    _hasBaseInstance(false) {
+    // commands of ARB_multi_draw_indirect ignore baseInstance unless base instance draws are supported as well
+    _hasBaseInstance = utils::has_gl_support(4, 2, "GL_ARB_base_instance");
+    _hasMultiDrawIndirect = _hasBaseInstance && utils::has_gl_support(4, 3, "GL_ARB_multi_draw_indirect");
+
+    glGenVertexArrays(1, &_vertexArray);
+    glGenBuffers(1, &_vertexBuffer);
+    glGenBuffers(1, &_indexBuffer);
+    glGenBuffers(1, &_instanceBuffer);
+    _instanceSource = _instanceBuffer;
+    glGenBuffers(1, &_indirectBuffer);
+    // upload through the copy target, binding the element array buffer would change the bound vertex array
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _vertexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(sizeof(ArenaPackedVertex) * _vertexCapacity), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _indexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(getIndexSize() * _indexCapacity), nullptr, GL_STATIC_DRAW);
+    setVertexBuffers();
+}
+
+GeometryArena::~GeometryArena() {
+    glDeleteVertexArrays(1, &_vertexArray);
+    GLuint buffers[] = { _vertexBuffer, _indexBuffer, _instanceBuffer, _indirectBuffer };
+    glDeleteBuffers(4, buffers);
+}
+
+static ArenaPackedVertex packedVertex(ArenaVertex const& vertex) {
+    glm::u16vec2 texcoord{ vertex_packing::half_float(vertex.texcoord.x), vertex_packing::half_float(vertex.texcoord.y) };
+    return ArenaPackedVertex{ vertex.position, vertex_packing::octahedral(vertex.normal), texcoord };
+}
+
+static vector<ArenaPackedVertex> packedVertices(vector<ArenaVertex> const& vertices) {
+    vector<ArenaPackedVertex> packed(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) { packed[i] = packedVertex(vertices[i]); }
+    return packed;
+}
+
+model_object GeometryArena::add(vector<ArenaVertex> const& vertices, vector<GLuint> const& indices, GLenum drawMode) {
+    return add(packedVertices(vertices), indices, drawMode);
+}
+
+model_object GeometryArena::add(vector<ArenaPackedVertex> const& vertices, vector<GLuint> const& indices, GLenum drawMode) {
+    // geometry without indices is drawn in vertex order
+    vector<GLuint> sequence;
+    if (indices.empty()) {
+        sequence.resize(vertices.size());
+        for (size_t i = 0; i < sequence.size(); ++i) { sequence[i] = GLuint(i); }
+    }
+    vector<GLuint> const& elements = indices.empty() ? sequence : indices;
+    return add(vertices.data(), vertices.size(), elements.data(), GL_UNSIGNED_INT, elements.size(), drawMode);
+}
+
+model_object GeometryArena::add(ArenaPackedVertex const* vertices, size_t vertexCount, void const* indices, GLenum indexType, size_t indexCount, GLenum drawMode) {
+    if (vertexCount > 65536 && _indexType == GL_UNSIGNED_SHORT) { widenIndices(); }
+    // indices in the type of the arena
+    vector<GLushort> shortIndices;
+    vector<GLuint> intIndices;
+    if (indexType != _indexType && _indexType == GL_UNSIGNED_SHORT) {
+        GLuint const* source = static_cast<GLuint const*>(indices);
+        shortIndices.assign(source, source + indexCount);
+        indices = shortIndices.data();
+    }
+    else if (indexType != _indexType) {
+        GLushort const* source = static_cast<GLushort const*>(indices);
+        intIndices.assign(source, source + indexCount);
+        indices = intIndices.data();
+    }
+    size_t indexSize = getIndexSize();
+    if (_vertexCount + vertexCount > _vertexCapacity || _indexCount + indexCount > _indexCapacity) {
+        if (_vertexCount + vertexCount > _vertexCapacity) {
+            _vertexCapacity = std::max(2 * _vertexCapacity, _vertexCount + vertexCount);
+            growBuffer(_vertexBuffer, sizeof(ArenaPackedVertex) * _vertexCount, sizeof(ArenaPackedVertex) * _vertexCapacity);
+        }
+        if (_indexCount + indexCount > _indexCapacity) {
+            _indexCapacity = std::max(2 * _indexCapacity, _indexCount + indexCount);
+            growBuffer(_indexBuffer, indexSize * _indexCount, indexSize * _indexCapacity);
+        }
+        setVertexBuffers();
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _vertexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(sizeof(ArenaPackedVertex) * _vertexCount), GLsizeiptr(sizeof(ArenaPackedVertex) * vertexCount), vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _indexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(indexSize * _indexCount), GLsizeiptr(indexSize * indexCount), indices);
+
+    model_object geometry;
+    geometry.vertex_AO = _vertexArray; // the buffers belong to the arena and change when it grows
+    geometry.draw_mode = drawMode;
+    geometry.num_elements = GLsizei(indexCount);
+    geometry.first_index = GLuint(_indexCount);
+    geometry.base_vertex = GLint(_vertexCount);
+    _vertexCount += vertexCount;
+    _indexCount += indexCount;
+    return geometry;
+}
+
+// interleaved vertices of any attribute layout and formats in the layout of the arena
+static vector<ArenaPackedVertex> arenaVertices(void const* data, size_t vertexCount, GLsizei vertexBytes, vector<model::attribute> const& formats) {
+    model::attribute const* position = nullptr;
+    model::attribute const* normal = nullptr;
+    model::attribute const* texcoord = nullptr;
+    for (auto const& format : formats) {
+        if (format.flag == model::POSITION.flag) { position = &format; }
+        else if (format.flag == model::NORMAL.flag) { normal = &format; }
+        else if (format.flag == model::TEXCOORD.flag) { texcoord = &format; }
+    }
+    vector<ArenaPackedVertex> vertices(vertexCount);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        void const* vertex = static_cast<unsigned char const*>(data) + i * size_t(vertexBytes);
+        ArenaVertex each{ glm::fvec3{0.0f}, glm::fvec3{0.0f}, glm::fvec2{0.0f} };
+        if (position) { glm::fvec4 value = vertex_packing::read(vertex, *position); each.position = glm::fvec3{ value.x, value.y, value.z }; }
+        if (normal) { glm::fvec4 value = vertex_packing::read(vertex, *normal); each.normal = glm::fvec3{ value.x, value.y, value.z }; }
+        if (texcoord) { glm::fvec4 value = vertex_packing::read(vertex, *texcoord); each.texcoord = glm::fvec2{ value.x, value.y }; }
+        vertices[i] = packedVertex(each);
+    }
+    return vertices;
+}
+
+static bool isSameFormat(model::attribute const& format, model::attribute const& other) {
+    return format.flag == other.flag && format.components == other.components && format.type == other.type
+           && format.normalized == other.normalized && format.offset == other.offset;
+}
+
+model_object GeometryArena::add(model const& mesh, GLenum drawMode) {
+    model_object geometry = add(arenaVertices(mesh.data.data(), mesh.vertex_num, mesh.vertex_bytes, vertex_packing::formats(mesh)), mesh.indices, drawMode);
+    geometry.bounds = mesh.bounds;
+    geometry.lod_error = mesh.lod_error;
+    return geometry;
+}
+
+model_object GeometryArena::add(mesh_data const& mesh, GLenum drawMode) {
+    vector<model::attribute> const& formats = vertexFormats();
+    bool isArenaLayout = mesh.vertex_bytes == GLsizei(sizeof(ArenaPackedVertex)) && mesh.formats.size() == formats.size()
+                         && std::equal(formats.begin(), formats.end(), mesh.formats.begin(), isSameFormat);
+    // the data goes to GL as it is, otherwise it is converted
+    vector<ArenaPackedVertex> converted;
+    if (!isArenaLayout) { converted = arenaVertices(mesh.vertices, mesh.vertex_num, mesh.vertex_bytes, mesh.formats); }
+    ArenaPackedVertex const* vertices = isArenaLayout ? static_cast<ArenaPackedVertex const*>(mesh.vertices) : converted.data();
+    model_object geometry;
+    if (mesh.index_num == 0) {
+        vector<GLuint> sequence(mesh.vertex_num);
+        for (size_t i = 0; i < sequence.size(); ++i) { sequence[i] = GLuint(i); }
+        geometry = add(vertices, mesh.vertex_num, sequence.data(), GL_UNSIGNED_INT, sequence.size(), drawMode);
+    }
+    else {
+        geometry = add(vertices, mesh.vertex_num, mesh.indices, mesh.index_type, mesh.index_num, drawMode);
+    }
+    geometry.bounds = mesh.bounds;
+    geometry.lod_error = mesh.lod_error;
+    return geometry;
+}
+
+void GeometryArena::setInstanceLayout(vector<InstanceAttribute> const& attributes, GLsizei stride) {
+    _instanceAttributes = attributes;
+    _instanceStride = stride;
+    glBindVertexArray(_vertexArray);
+    for (auto const& attribute : _instanceAttributes) {
+        glEnableVertexAttribArray(attribute.location);
+        glVertexAttribDivisorARB(attribute.location, 1); // advance once per instance, GL 3.3 core or ARB_instanced_arrays
+    }
+    setInstanceOffset(0);
+    glBindVertexArray(0);
+}
+
+void GeometryArena::setStreamBuffer(StreamBuffer* stream) {
+    _stream = stream;
+}
+
+GLuint GeometryArena::uploadInstances(void const* data, size_t count) {
+    size_t size = size_t(_instanceStride) * count;
+    if (_stream) {
+        // aligned to whole records, so the offset in the stream is a baseInstance
+        StreamBuffer::Allocation allocation = _stream->allocate(size, size_t(_instanceStride));
+        if (allocation.data) {
+            std::memcpy(allocation.data, data, size);
+            _stream->flush();
+            setInstanceSource(_stream->getHandle());
+            return GLuint(allocation.offset / size_t(_instanceStride));
+        }
+    }
+    // respecifying the whole buffer lets the driver hand out new storage while earlier draws may still read the old one
+    setInstanceSource(_instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(size), data, GL_STREAM_DRAW);
+    return 0;
+}
+
+void GeometryArena::draw(GLenum mode, vector<DrawElementsIndirectCommand> const& commands) {
+    if (commands.empty()) { return; }
+    if (_hasMultiDrawIndirect) {
+        size_t size = sizeof(DrawElementsIndirectCommand) * commands.size();
+        StreamBuffer::Allocation allocation = _stream ? _stream->allocate(size, sizeof(GLuint)) : StreamBuffer::Allocation{ nullptr, 0 };
+        if (allocation.data) {
+            std::memcpy(allocation.data, commands.data(), size);
+            _stream->flush();
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _stream->getHandle());
+        }
+        else {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBuffer);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, GLsizeiptr(size), commands.data(), GL_STREAM_DRAW);
+        }
+        glMultiDrawElementsIndirect(mode, _indexType, (void const*)allocation.offset, GLsizei(commands.size()), 0);
+        return;
+    }
+    for (auto const& command : commands) {
+        void const* indices = reinterpret_cast<void const*>(uintptr_t(command.firstIndex) * getIndexSize());
+        if (_hasBaseInstance) {
+            glDrawElementsInstancedBaseVertexBaseInstance(mode, GLsizei(command.count), _indexType, indices,
+                                                          GLsizei(command.instanceCount), command.baseVertex, command.baseInstance);
+        }
+        else {
+            setInstanceOffset(command.baseInstance);
+            glDrawElementsInstancedBaseVertex(mode, GLsizei(command.count), _indexType, indices, GLsizei(command.instanceCount), command.baseVertex);
+        }
+    }
+    if (!_hasBaseInstance) { setInstanceOffset(0); }
+}
+
+DrawElementsIndirectCommand GeometryArena::command(model_object const& geometry, GLuint instanceCount, GLuint baseInstance) {
+    return DrawElementsIndirectCommand{ GLuint(geometry.num_elements), instanceCount, geometry.first_index, geometry.base_vertex, baseInstance };
+}
+
+GLuint GeometryArena::getVertexArray() const { return _vertexArray; }
+size_t GeometryArena::getVertexCount() const { return _vertexCount; }
+size_t GeometryArena::getIndexCount() const { return _indexCount; }
+GLenum GeometryArena::getIndexType() const { return _indexType; }
+size_t GeometryArena::getIndexSize() const { return _indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint); }
+bool GeometryArena::hasMultiDrawIndirect() const { return _hasMultiDrawIndirect; }
+
+vector<model::attribute> const& GeometryArena::vertexFormats() {
+    // built on first use, the formats of model may not be initialized before main
+    static vector<model::attribute> const formats = [] {
+        vector<model::attribute> result{ model::POSITION, model::NORMAL_OCTAHEDRAL, model::TEXCOORD_HALF };
+        result[0].offset = (GLvoid*)offsetof(ArenaPackedVertex, position);
+        result[1].offset = (GLvoid*)offsetof(ArenaPackedVertex, normal);
+        result[2].offset = (GLvoid*)offsetof(ArenaPackedVertex, texcoord);
+        return result;
+    }();
+    return formats;
+}
+
+void GeometryArena::widenIndices() {
+    vector<GLushort> indices(_indexCount);
+    glBindBuffer(GL_COPY_READ_BUFFER, _indexBuffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, GLsizeiptr(sizeof(GLushort) * _indexCount), indices.data());
+    vector<GLuint> widened(indices.begin(), indices.end());
+    glBufferData(GL_COPY_READ_BUFFER, GLsizeiptr(sizeof(GLuint) * _indexCapacity), nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_COPY_READ_BUFFER, 0, GLsizeiptr(sizeof(GLuint) * _indexCount), widened.data());
+    _indexType = GL_UNSIGNED_INT;
+}
+
+void GeometryArena::setVertexBuffers() {
+    glBindVertexArray(_vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+    vector<model::attribute> const& formats = vertexFormats();
+    for (GLuint location = 0; location < GLuint(formats.size()); ++location) {
+        model::attribute const& format = formats[location];
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, format.components, format.type, format.normalized, sizeof(ArenaPackedVertex), format.offset);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+    glBindVertexArray(0);
+}
+
+// the vertex array has to be bound
+void GeometryArena::setInstanceSource(GLuint buffer) {
+    if (buffer == _instanceSource) { return; }
+    _instanceSource = buffer;
+    setInstanceOffset(0);
+}
+
+// the vertex array has to be bound
+void GeometryArena::setInstanceOffset(GLuint baseInstance) {
+    if (_instanceAttributes.empty()) { return; }
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceSource);
+    for (auto const& attribute : _instanceAttributes) {
+        size_t offset = attribute.offset + size_t(baseInstance) * size_t(_instanceStride);
+        glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE, _instanceStride, (void*)offset);
+    }
+}
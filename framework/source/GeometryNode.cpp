@@ -2,20 +2,63 @@
 #include "structs.hpp"
 #include "GeometryNode.hpp"
 #include <string>
+#include <vector>
+#include <limits>
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 using glm::fvec3;
 using std::string;
+using std::vector;
+
+const float GeometryNode::LOD_PIXEL_ERROR = 1.0f;
+const float GeometryNode::LOD_HYSTERESIS = 0.1f;
 
 GeometryNode::GeometryNode(string name, string shader, model_object geo, fvec3 geoColor, texture_object texture) :
-    Node(name),
+    Node(name, NodeType::Geometry),
     _shader(shader),
     _geometry(geo),
     _geoColor(geoColor),
-    _texture(texture)
+    _texture(texture),
+    _lod(0)
 { }
 
+GeometryNode::GeometryNode(string name, string shader, vector<model_object> const& lods, fvec3 geoColor, texture_object texture) :
+    GeometryNode(name, shader, lods.empty() ? model_object() : lods.front(), geoColor, texture)
+{
+    setLods(lods);
+}
+
 string GeometryNode::getShader() { return _shader; }
 fvec3 GeometryNode::getGeometryColor() { return _geoColor; }
-model_object GeometryNode::getGeometry() { return _geometry; }
+model_object GeometryNode::getGeometry() { return _lods.empty() ? _geometry : _lods[_lod]; }
 texture_object GeometryNode::getTexture() { return _texture; }
-void GeometryNode::setGeometry(model_object geoModel) { _geometry = geoModel; }
\ No newline at end of file
+bounding_volume const& GeometryNode::getBounds() const { return _geometry.bounds; }
+void GeometryNode::setGeometry(model_object geoModel) {
+    _geometry = geoModel;
+    _lods.clear();
+    _lod = 0;
+}
+
+void GeometryNode::setLods(vector<model_object> const& lods) {
+    _lods = lods.size() > 1 ? lods : vector<model_object>();
+    _lod = 0;
+    if (!lods.empty()) { _geometry = lods.front(); }
+}
+
+unsigned GeometryNode::getLod() const { return _lod; }
+unsigned GeometryNode::getLodCount() const { return _lods.empty() ? 1 : unsigned(_lods.size()); }
+
+float GeometryNode::lodLimit(unsigned lod) const {
+    // the error scales with the bounding sphere, lod_error / radius * screenRadius pixels. Unbounded geometry keeps the first level,
+    // as does geometry whose coarser levels have no valid error, a level is never assumed to be exact
+    float error = _lods[lod].lod_error;
+    if (lod == 0) { return std::numeric_limits<float>::infinity(); }
+    if (_geometry.bounds.radius < 0.0f || !(error > 0.0f) || std::isinf(error)) { return 0.0f; }
+    return LOD_PIXEL_ERROR * _geometry.bounds.radius / error;
+}
+
+void GeometryNode::selectLod(float screenRadius) {
+    if (_lods.empty()) { return; }
+    while (_lod > 0 && screenRadius > lodLimit(_lod) * (1.0f + LOD_HYSTERESIS)) { --_lod; }
+    while (_lod + 1 < _lods.size() && screenRadius < lodLimit(_lod + 1) * (1.0f - LOD_HYSTERESIS)) { ++_lod; }
+}
\ No newline at end of file
@@ -1,67 +1,130 @@
 #include "Node.hpp"
-#include <list>
+#include "SceneGraph.hpp"
+#include "TransformHierarchy.hpp"
 #include <string>
-#include <memory>
-#include <functional>
+#include <vector>
 #include <glm/gtc/matrix_transform.hpp>
 using glm::mat4;
-using std::list;
 using std::string;
-using std::shared_ptr;
-using std::function;
+using std::vector;
 
 Node::Node(string name) :
-    _name(name),
-    _depth(0),
-    _children() {
+    Node(name, NodeType::Transform) {
+}
+
+Node::Node(string name, NodeType type) :
+    _parent(nullptr),
+    _firstChild(nullptr),
+    _lastChild(nullptr),
+    _prevSibling(nullptr),
+    _nextSibling(nullptr),
+    _handle(),
+    _type(type),
+    _isInScene(false),
+    _hasIndexedChildren(false),
+    _childCount(0),
+    _listIndex(0),
+    _boundsLeaf(-1),
+    _nameId(SceneGraph::getInstance().internName(name)),
+    _transform(SceneGraph::getInstance().getTransforms().allocate()) {
+}
+
+// Links are not touched here, SceneGraph::destroyNode() detaches a node before its pool destroys it
+Node::~Node() {
+    SceneGraph::getInstance().unindexNode(this);
+    if (_isInScene) { SceneGraph::getInstance().removeFromLists(this); }
+    SceneGraph::getInstance().getTransforms().release(_transform);
 }
 
 // ------------- Get own attribute method -------------
-string Node::getName() { return _name; }
-int Node::getDepth() { return _depth; }
-void Node::setDepth(int newDepth) { _depth = newDepth; }
-string Node::getPath() { return _path; } // Not sure when/how we're going to use it, so leave the implement for now
+NodeType Node::getType() { return _type; }
+bool Node::isInScene() { return _isInScene; }
+NodeHandle Node::getHandle() { return _handle; }
+string Node::getName() { return SceneGraph::getInstance().getInternedName(_nameId); }
+string Node::getPath() {
+    // Built on demand from parent links, so moving a subtree doesn't rewrite any stored strings
+    vector<Node*> ancestors;
+    for (Node* node = this; node; node = node->_parent) { ancestors.push_back(node); }
+    string path;
+    for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it) {
+        if (!path.empty()) { path += '/'; }
+        path += (*it)->getName();
+    }
+    return path;
+}
+int Node::getDepth() {
+    // Depth is derived from parent links, so reparenting a subtree doesn't have to update its descendants
+    int depth = 0;
+    for (Node* node = _parent; node; node = node->_parent) { ++depth; }
+    return depth;
+}
 
 // ------------- Get transform methods -------------
-mat4 Node::getLocalTransform() { return _localTransform; }
-void Node::setLocalTransform(mat4 localTransform) { _localTransform = localTransform; }
-void Node::setWorldTransform(mat4 worldTransform) { _worldTransform = worldTransform; }
-mat4 Node::getWorldTransform() {
-    // Return world coordinate of this node by multiplying own transform with parent's transform
-    return _depth != 0 ? _parent->getWorldTransform() * _localTransform : _localTransform;
+// Matrices are stored in SceneGraph's flat transform storage, Node is only a handle into it
+mat4 Node::getLocalTransform() { return SceneGraph::getInstance().getTransforms().getLocalTransform(_transform); }
+void Node::setLocalTransform(mat4 localTransform) {
+    // world transform of this node and its subtree will be recomputed in next update pass
+    SceneGraph::getInstance().getTransforms().setLocalTransform(_transform, localTransform);
 }
+void Node::setWorldTransform(mat4 worldTransform) { SceneGraph::getInstance().getTransforms().setWorldTransform(_transform, worldTransform); }
+mat4 Node::getWorldTransform() { return SceneGraph::getInstance().getTransforms().getWorldTransform(_transform); }
+bool Node::isDirty() { return SceneGraph::getInstance().getTransforms().isDirty(_transform); }
+TransformHierarchy::Handle Node::getTransformHandle() { return _transform; }
 
 // ------------- Getter/Setter node methods -------------
-shared_ptr<Node> Node::getParent() { return _parent; }
-void Node::setParent(Node* parentNode) { _parent = shared_ptr<Node>(parentNode); }
-list<shared_ptr<Node>> Node::getChildrenList() { return _children; }
-shared_ptr<Node> Node::getChild(string childName) {
-    for (auto child : _children) {
-        if (child->getName() == childName) { return child; } // Return child node that has specific name
+Node* Node::getParent() { return _parent; }
+Node* Node::getFirstChild() { return _firstChild; }
+Node* Node::getNextSibling() { return _nextSibling; }
+
+void Node::setParent(Node* parentNode) {
+    if (_parent == parentNode) { return; }
+    SceneGraph& scene = SceneGraph::getInstance();
+    // the index is keyed by parent and name, so descendants keep their entries when a subtree moves
+    scene.unindexNode(this);
+    unlink();
+    _parent = parentNode;
+    if (_parent) { // append to new parent's sibling list
+        _prevSibling = _parent->_lastChild;
+        if (_prevSibling) { _prevSibling->_nextSibling = this; }
+        else { _parent->_firstChild = this; }
+        _parent->_lastChild = this;
+        ++_parent->_childCount;
     }
-    return nullptr;
+    // also marks world transform dirty, it depends on the new parent now
+    scene.getTransforms().setParent(_transform, _parent ? _parent->_transform : TransformHierarchy::INVALID_HANDLE);
+    scene.indexNode(this);
+    // typed lists only change when the subtree enters or leaves the scene, moves inside it are free
+    bool isInScene = _parent ? _parent->_isInScene : this == scene.getRoot();
+    if (isInScene != _isInScene) { scene.setInScene(this, isInScene); }
 }
-void Node::addChild(shared_ptr<Node> child) {
-    child->setDepth(_depth+1); // Set child's depth correctly
-    child->setParent(this);
-    _children.push_back(child); // Then we can add it to own children list
+
+void Node::unlink() {
+    if (!_parent) { return; }
+    if (_prevSibling) { _prevSibling->_nextSibling = _nextSibling; }
+    else { _parent->_firstChild = _nextSibling; }
+    if (_nextSibling) { _nextSibling->_prevSibling = _prevSibling; }
+    else { _parent->_lastChild = _prevSibling; }
+    --_parent->_childCount;
+    _prevSibling = nullptr;
+    _nextSibling = nullptr;
+    _parent = nullptr;
 }
-shared_ptr<Node> Node::removeChild(string childName) {
-    for (auto child : _children) {
-        if (child->getName() == childName) {
-            child->setDepth(0); // Reset child's depth because we remove the Node from scenegraph's hierarchy
-            child->setParent(nullptr); // Set null pointer to child's parent
-            _children.remove(child); // Then we can remove that node from own children list
-            return child;
-        }
-    }
-    return nullptr;
+
+Node* Node::getChild(string childName) {
+    auto& scene = SceneGraph::getInstance();
+    unsigned nameId = scene.findName(childName);
+    if (nameId == SceneGraph::NO_NAME) { return nullptr; } // no node was ever called like this
+    return scene.findChild(this, nameId); // Return child node that has specific name
 }
 
-// invoke specfic func for all child's node
-void Node::traverse(const function<void(shared_ptr<Node>)>& func) {
-    for (auto const& child : _children) {
-        func(child);
-        child->traverse(func);
-    }
-}
\ No newline at end of file
+void Node::addChild(Node* child) { child->setParent(this); }
+
+Node* Node::removeChild(string childName) {
+    Node* child = getChild(childName);
+    if (child) { removeChild(child); }
+    return child;
+}
+
+void Node::removeChild(Node* child) {
+    if (child->_parent == this) { child->setParent(nullptr); }
+}
@@ -6,7 +6,7 @@ using glm::fvec3;
 using std::string;
 
 PointLightNode::PointLightNode(string name, fvec3 lightColor, float lightIntensity) :
-    Node(name),
+    Node(name, NodeType::Light),
     _lightColor(lightColor),
     _lightIntensity(lightIntensity){
 }
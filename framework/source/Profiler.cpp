@@ -0,0 +1,260 @@
+#include "Profiler.hpp"
+#include "TaskPool.hpp"
+#include "utils.hpp"
+#include <glbinding/gl/gl.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+using namespace gl;
+
+static thread_local unsigned scopeDepth = 0; // open CPU scopes of the calling thread
+
+// names are literals from the code, escaping keeps the files valid for any literal
+static void writeEscaped(std::ostream& stream, char const* text, char quote, bool isJson) {
+    for (char const* c = text; *c; ++c) {
+        if (*c == quote) { stream << (isJson ? '\\' : quote); }
+        else if (isJson && *c == '\\') { stream << '\\'; }
+        stream << *c;
+    }
+}
+
+Profiler::CpuScope::CpuScope(char const* name) :
+    _name(name),
+    _begin(0.0),
+    _isRecording(Profiler::getInstance().isEnabled()) {
+    if (_isRecording) {
+        _begin = Profiler::getInstance().now();
+        ++scopeDepth;
+    }
+}
+
+Profiler::CpuScope::~CpuScope() {
+    if (_isRecording) {
+        --scopeDepth;
+        Profiler& profiler = Profiler::getInstance();
+        profiler.record(_name, _begin, profiler.now(), scopeDepth);
+    }
+}
+
+Profiler::GpuScope::GpuScope(char const* name) {
+    Profiler::getInstance().beginGpuScope(name);
+}
+
+Profiler::GpuScope::~GpuScope() {
+    Profiler::getInstance().endGpuScope();
+}
+
+Profiler::Profiler() :
+    _start(std::chrono::steady_clock::now()),
+    _frames(DEFAULT_FRAME_COUNT),
+    _frameIndex(0),
+    _isEnabled(true),
+    _activeGpuQuery(-1),
+    _timerQuerySupport(-1) {}
+
+// queries are not deleted, the GL context is already destroyed when the singleton is
+Profiler::~Profiler() {}
+
+Profiler& Profiler::getInstance() {
+    static Profiler instance;
+    return instance;
+}
+
+void Profiler::setEnabled(bool isEnabled) {
+    _isEnabled = isEnabled;
+}
+
+bool Profiler::isEnabled() const {
+    return _isEnabled;
+}
+
+void Profiler::setFrameCount(size_t frameCount) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _frames.assign(std::max(frameCount, size_t(2)), Frame()); // the recorded frame and at least one finished one
+    _frames[_frameIndex % _frames.size()].index = _frameIndex;
+    _frames[_frameIndex % _frames.size()].begin = now();
+}
+
+void Profiler::clear() {
+    setFrameCount(_frames.size());
+}
+
+void Profiler::beginFrame() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Frame& frame = currentFrame();
+    if (frame.scopes.empty()) { frame.begin = now(); } // otherwise the frame starts with the scopes recorded before it
+}
+
+void Profiler::endFrame() {
+    collectGpuQueries();
+    std::lock_guard<std::mutex> lock(_mutex);
+    double end = now();
+    currentFrame().duration = end - currentFrame().begin;
+    ++_frameIndex;
+    Frame& next = currentFrame(); // reuses the scope storage of the oldest frame
+    next.index = _frameIndex;
+    next.begin = end;
+    next.duration = 0.0;
+    next.scopes.clear();
+}
+
+void Profiler::beginGpuScope(char const* name) {
+    if (!_isEnabled || _activeGpuQuery >= 0 || !hasTimerQueries()) { return; }
+    size_t free = 0;
+    while (free < _gpuQueries.size() && _gpuQueries[free].isPending) { ++free; }
+    if (free == _gpuQueries.size()) {
+        if (_gpuQueries.size() == MAX_GPU_QUERIES) { return; } // results do not come back, e.g. GPU is far behind
+        GpuQuery query;
+        glGenQueries(1, &query.query);
+        _gpuQueries.push_back(query);
+    }
+    GpuQuery& query = _gpuQueries[free];
+    query.name = name;
+    query.frame = _frameIndex;
+    query.begin = now();
+    glBeginQuery(GL_TIME_ELAPSED, query.query);
+    _activeGpuQuery = int(free);
+}
+
+void Profiler::endGpuScope() {
+    if (_activeGpuQuery < 0) { return; }
+    glEndQuery(GL_TIME_ELAPSED);
+    _gpuQueries[size_t(_activeGpuQuery)].isPending = true;
+    _activeGpuQuery = -1;
+}
+
+void Profiler::record(char const* name, double begin, double end, unsigned depth) {
+    Scope scope{name, begin, end - begin, TaskPool::getThreadIndex(), depth};
+    std::lock_guard<std::mutex> lock(_mutex);
+    currentFrame().scopes.push_back(scope);
+}
+
+double Profiler::now() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _start).count();
+}
+
+vector<Profiler::Frame> Profiler::getFrames() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    vector<Frame> frames;
+    uint64_t finished = std::min(_frameIndex, uint64_t(_frames.size() - 1));
+    frames.reserve(size_t(finished));
+    for (uint64_t index = _frameIndex - finished; index < _frameIndex; ++index) {
+        frames.push_back(_frames[size_t(index % _frames.size())]);
+    }
+    return frames;
+}
+
+void Profiler::writeChromeTrace(std::ostream& stream) const {
+    // frames and GPU scopes get their own tracks next to the threads
+    static const unsigned FRAME_TRACK = 1000;
+    static const unsigned GPU_TRACK = 1001;
+    vector<Frame> frames = getFrames();
+    unsigned threadCount = 1;
+    for (auto const& frame : frames) {
+        for (auto const& scope : frame.scopes) {
+            if (scope.thread != GPU_THREAD) { threadCount = std::max(threadCount, scope.thread + 1); }
+        }
+    }
+
+    stream << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    auto trackName = [&stream](unsigned track, string const& name) {
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track << ",\"args\":{\"name\":\"" << name << "\"}},\n"
+               << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track << ",\"args\":{\"sort_index\":" << track << "}},\n";
+    };
+    trackName(FRAME_TRACK, "Frames");
+    trackName(GPU_TRACK, "GPU");
+    for (unsigned thread = 0; thread < threadCount; ++thread) {
+        trackName(thread, thread == 0 ? string("Main thread") : "Worker " + std::to_string(thread));
+    }
+    bool isFirst = true;
+    auto event = [&](char const* name, char const* category, double begin, double duration, unsigned track) {
+        stream << (isFirst ? "" : ",\n") << "{\"name\":\"";
+        writeEscaped(stream, name, '"', true);
+        stream << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"ts\":" << begin << ",\"dur\":" << duration
+               << ",\"pid\":1,\"tid\":" << track << "}";
+        isFirst = false;
+    };
+    for (auto const& frame : frames) {
+        string frameName = "Frame " + std::to_string(frame.index);
+        event(frameName.c_str(), "frame", frame.begin, frame.duration, FRAME_TRACK);
+        for (auto const& scope : frame.scopes) {
+            bool isGpu = scope.thread == GPU_THREAD;
+            event(scope.name, isGpu ? "gpu" : "cpu", scope.begin, scope.duration, isGpu ? GPU_TRACK : scope.thread);
+        }
+    }
+    stream << "\n]}\n";
+}
+
+void Profiler::writeCsv(std::ostream& stream) const {
+    vector<Frame> frames = getFrames();
+    // columns in order of first appearance, CPU and GPU scopes of one name are separate columns
+    vector<std::pair<char const*, bool>> columns;
+    auto column = [&columns](Scope const& scope) {
+        std::pair<char const*, bool> key{scope.name, scope.thread == GPU_THREAD};
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (columns[i].second == key.second && std::strcmp(columns[i].first, key.first) == 0) { return i; }
+        }
+        columns.push_back(key);
+        return columns.size() - 1;
+    };
+    for (auto const& frame : frames) {
+        for (auto const& scope : frame.scopes) { column(scope); }
+    }
+
+    stream << "frame,frame_ms";
+    for (auto const& each : columns) {
+        stream << ",\"" << (each.second ? "GPU " : "");
+        writeEscaped(stream, each.first, '"', false);
+        stream << " ms\"";
+    }
+    stream << "\n" << std::fixed << std::setprecision(4);
+    vector<double> milliseconds(columns.size());
+    for (auto const& frame : frames) {
+        std::fill(milliseconds.begin(), milliseconds.end(), 0.0);
+        for (auto const& scope : frame.scopes) { milliseconds[column(scope)] += scope.duration / 1000.0; }
+        stream << frame.index << "," << frame.duration / 1000.0;
+        for (double each : milliseconds) { stream << "," << each; }
+        stream << "\n";
+    }
+}
+
+bool Profiler::exportChromeTrace(string const& filePath) const {
+    std::ofstream file(filePath);
+    writeChromeTrace(file);
+    return bool(file);
+}
+
+bool Profiler::exportCsv(string const& filePath) const {
+    std::ofstream file(filePath);
+    writeCsv(file);
+    return bool(file);
+}
+
+Profiler::Frame& Profiler::currentFrame() {
+    return _frames[size_t(_frameIndex % _frames.size())];
+}
+
+void Profiler::collectGpuQueries() {
+    for (auto& query : _gpuQueries) {
+        if (!query.isPending) { continue; }
+        GLint isAvailable = 0;
+        glGetQueryObjectiv(query.query, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+        if (!isAvailable) { continue; } // results of one query arrive in order, but checking all is cheap
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(query.query, GL_QUERY_RESULT, &nanoseconds);
+        query.isPending = false;
+        std::lock_guard<std::mutex> lock(_mutex);
+        Frame& frame = _frames[size_t(query.frame % _frames.size())];
+        if (frame.index == query.frame) { // not yet overwritten by a newer frame
+            frame.scopes.push_back(Scope{query.name, query.begin, double(nanoseconds) / 1000.0, GPU_THREAD, 0});
+        }
+    }
+}
+
+bool Profiler::hasTimerQueries() {
+    if (_timerQuerySupport < 0) { // core since GL 3.3, the context may be older
+        _timerQuerySupport = utils::has_gl_support(3, 3, "GL_ARB_timer_query") ? 1 : 0;
+    }
+    return _timerQuerySupport == 1;
+}
@@ -0,0 +1,82 @@
+#include "RenderQueue.hpp"
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+using std::vector;
+
+static const unsigned PROGRAM_BITS = 12;
+static const unsigned TEXTURE_BITS = 16;
+static const unsigned VERTEX_ARRAY_BITS = 12;
+static const unsigned DEPTH_BITS = 20;
+static const unsigned RADIX_BITS = 8;
+static const unsigned RADIX_SIZE = 1u << RADIX_BITS;
+static const unsigned RADIX_PASSES = 64 / RADIX_BITS;
+
+void RenderQueue::clear() {
+    _items.clear();
+    _entries.clear();
+}
+
+// Ids are handed out in order of first use and saturate when the bits are used up,
+// which only makes the order less optimal, submission compares the real GL names
+unsigned RenderQueue::denseId(vector<unsigned>& ids, unsigned& count, GLuint name, unsigned bits) {
+    if (name >= ids.size()) { ids.resize(name + 1, 0); }
+    if (ids[name] == 0) { ids[name] = ++count; }
+    return std::min(ids[name], (1u << bits) - 1);
+}
+
+void RenderQueue::push(RenderPass pass, DrawState const& state, float depth, unsigned list, unsigned index) {
+    // bits of a positive float grow with its value, so the top bits are a valid depth order without knowing the depth range
+    float positiveDepth = std::max(depth, 0.0f);
+    uint32_t depthBits;
+    std::memcpy(&depthBits, &positiveDepth, sizeof(depthBits));
+
+    uint64_t key = uint64_t(pass) << (PROGRAM_BITS + TEXTURE_BITS + VERTEX_ARRAY_BITS + DEPTH_BITS);
+    key |= uint64_t(denseId(_programIds, _programCount, state.program, PROGRAM_BITS)) << (TEXTURE_BITS + VERTEX_ARRAY_BITS + DEPTH_BITS);
+    key |= uint64_t(denseId(_textureIds, _textureCount, state.texture, TEXTURE_BITS)) << (VERTEX_ARRAY_BITS + DEPTH_BITS);
+    key |= uint64_t(denseId(_vertexArrayIds, _vertexArrayCount, state.vertexArray, VERTEX_ARRAY_BITS)) << DEPTH_BITS;
+    key |= uint64_t(depthBits >> (32 - DEPTH_BITS));
+
+    SortEntry entry;
+    entry.key = key;
+    entry.item = unsigned(_items.size());
+    _entries.push_back(entry);
+    Item item;
+    item.state = state;
+    item.list = list;
+    item.index = index;
+    _items.push_back(item);
+}
+
+void RenderQueue::sort() {
+    // histograms of all digits in one pass over the keys
+    vector<unsigned>& counts = _radixCounts;
+    counts.assign(RADIX_PASSES * RADIX_SIZE, 0);
+    for (auto const& entry : _entries) {
+        for (unsigned pass = 0; pass < RADIX_PASSES; ++pass) {
+            ++counts[pass * RADIX_SIZE + ((entry.key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1))];
+        }
+    }
+
+    _sortBuffer.resize(_entries.size());
+    for (unsigned pass = 0; pass < RADIX_PASSES; ++pass) {
+        unsigned* count = &counts[pass * RADIX_SIZE];
+        unsigned shift = pass * RADIX_BITS;
+        // all keys share this digit (e.g. unused texture bits), the pass would not move anything
+        if (!_entries.empty() && count[(_entries.front().key >> shift) & (RADIX_SIZE - 1)] == _entries.size()) { continue; }
+        unsigned offset = 0;
+        for (unsigned digit = 0; digit < RADIX_SIZE; ++digit) {
+            unsigned digitCount = count[digit];
+            count[digit] = offset;
+            offset += digitCount;
+        }
+        for (auto const& entry : _entries) {
+            _sortBuffer[count[(entry.key >> shift) & (RADIX_SIZE - 1)]++] = entry;
+        }
+        _entries.swap(_sortBuffer);
+    }
+}
+
+size_t RenderQueue::size() const { return _entries.size(); }
+RenderQueue::Statistics const& RenderQueue::getStatistics() const { return _statistics; }
@@ -2,14 +2,26 @@
 #include "SceneGraph.hpp"
 #include "CameraNode.hpp"
 #include "PointLightNode.hpp"
+#include "GeometryNode.hpp"
+#include "Profiler.hpp"
 #include <string>
-#include <memory>
+#include <vector>
+#include <algorithm>
 #include <iostream>
 using std::string;
-using std::shared_ptr;
-using std::dynamic_pointer_cast;
+using std::vector;
 
-SceneGraph::SceneGraph() { }
+const unsigned SceneGraph::NO_NAME;
+const unsigned SceneGraph::INDEXED_CHILDREN;
+
+SceneGraph::SceneGraph() :
+    _indexedCount(0),
+    _root(nullptr),
+    _camera(nullptr),
+    _dirLight(nullptr) {
+}
+
+SceneGraph::~SceneGraph() { clear(); }
 
 SceneGraph& SceneGraph::getInstance() {
     static SceneGraph instance;
@@ -19,22 +31,243 @@ SceneGraph& SceneGraph::getInstance() {
 string SceneGraph::getName() { return _name; }
 void SceneGraph::setName(string name) { _name = name; }
 
-shared_ptr<Node> SceneGraph::getRoot() { return _root; }
-void SceneGraph::setRoot(shared_ptr<Node> rootNode) { _root = rootNode; }
+Node* SceneGraph::getRoot() { return _root; }
+void SceneGraph::setRoot(Node* rootNode) {
+    if (_root && _root->isInScene()) { setInScene(_root, false); }
+    _root = rootNode;
+    if (_root && !_root->isInScene()) { setInScene(_root, true); }
+}
+
+PointLightNode* SceneGraph::getDirectionalLight() { return _dirLight; }
+void SceneGraph::setDirectionalLight(PointLightNode* dirLight) { _dirLight = dirLight; }
+
+CameraNode* SceneGraph::getCamera() { return _camera; }
+void SceneGraph::setCamera(CameraNode* cameraNode) { _camera = cameraNode; }
 
-shared_ptr<PointLightNode> SceneGraph::getDirectionalLight() { return _dirLight; }
-void SceneGraph::setDirectionalLight(shared_ptr<PointLightNode> dirLight) { _dirLight = dirLight; }
+vector<GeometryNode*> const& SceneGraph::getGeometryNodes() const { return _geometryNodes; }
+vector<PointLightNode*> const& SceneGraph::getLights() const { return _lights; }
+vector<CameraNode*> const& SceneGraph::getCameras() const { return _cameras; }
+BoundingVolumeHierarchy const& SceneGraph::getBoundingVolumes() const { return _boundingVolumes; }
+
+void SceneGraph::setInScene(Node* subtree, bool isInScene) {
+    for (Node& node : subtree->preOrder()) {
+        node._isInScene = isInScene;
+        if (isInScene) { addToLists(&node); }
+        else { removeFromLists(&node); }
+    }
+}
+
+template<typename T>
+void SceneGraph::addToList(vector<T*>& list, Node* node) {
+    node->_listIndex = unsigned(list.size());
+    list.push_back(static_cast<T*>(node));
+}
+
+// O(1), last node takes the place of the removed one. Index is checked, clear() drops the lists before the nodes
+template<typename T>
+void SceneGraph::removeFromList(vector<T*>& list, Node* node) {
+    unsigned index = node->_listIndex;
+    if (index >= list.size() || list[index] != node) { return; }
+    list[index] = list.back();
+    list.pop_back();
+    if (index < list.size()) { static_cast<Node*>(list[index])->_listIndex = index; }
+}
 
-shared_ptr<CameraNode> SceneGraph::getCamera() { return _camera; }
-void SceneGraph::setCamera(shared_ptr<CameraNode> cameraNode) { _camera = cameraNode; }
+void SceneGraph::addToLists(Node* node) {
+    switch (node->_type) {
+        case NodeType::Geometry:
+            addToList(_geometryNodes, node);
+            node->_boundsLeaf = _boundingVolumes.insert(static_cast<GeometryNode*>(node));
+            break;
+        case NodeType::Light: addToList(_lights, node); break;
+        case NodeType::Camera: addToList(_cameras, node); break;
+        default: break; // plain transform nodes are not listed
+    }
+}
+
+void SceneGraph::removeFromLists(Node* node) {
+    switch (node->_type) {
+        case NodeType::Geometry:
+            removeFromList(_geometryNodes, node);
+            _boundingVolumes.remove(node->_boundsLeaf, node); // may run in ~Node, when node is no GeometryNode anymore
+            break;
+        case NodeType::Light: removeFromList(_lights, node); break;
+        case NodeType::Camera: removeFromList(_cameras, node); break;
+        default: break;
+    }
+}
+
+unsigned SceneGraph::nextPoolId() {
+    static unsigned count = 0;
+    return count++;
+}
+
+Node* SceneGraph::getNode(NodeHandle handle) {
+    if (!handle.isValid() || handle.pool >= _pools.size() || !_pools[handle.pool]) { return nullptr; }
+    return _pools[handle.pool]->resolve(handle);
+}
+
+void SceneGraph::destroyNode(Node* node) {
+    // post-order, so every node is destroyed after its children were detached and destroyed
+    node->visit([this](Node& each) {
+        Node* eachNode = &each;
+        if (eachNode == _root) { _root = nullptr; }
+        if (eachNode == _camera) { _camera = nullptr; }
+        if (eachNode == _dirLight) { _dirLight = nullptr; }
+        eachNode->setParent(nullptr);
+        NodeHandle handle = eachNode->getHandle();
+        if (handle.isValid()) { _pools[handle.pool]->destroy(handle); }
+    }, TraversalOrder::PostOrder);
+}
+
+void SceneGraph::clear() {
+    // links between nodes don't own anything, so pools can drop their nodes without unlinking them
+    // nodes find nothing to unindex anymore, the slots are kept for the next scene
+    if (_indexedCount > 0) { std::fill(_childSlots.begin(), _childSlots.end(), ChildSlot{0, nullptr}); }
+    _indexedCount = 0;
+    _geometryNodes.clear();
+    _boundingVolumes.clear();
+    _lights.clear();
+    _cameras.clear();
+    for (auto& pool : _pools) {
+        if (pool) { pool->clear(); }
+    }
+    _transforms.clear(); // all transforms were released by now, reset storage instead of waiting for next sort
+    _root = nullptr;
+    _camera = nullptr;
+    _dirLight = nullptr;
+}
+
+unsigned SceneGraph::internName(string const& name) {
+    auto it = _nameIds.find(name);
+    if (it != _nameIds.end()) { return it->second; }
+    unsigned nameId = unsigned(_names.size());
+    _names.push_back(name);
+    _nameIds.emplace(name, nameId);
+    return nameId;
+}
+
+unsigned SceneGraph::findName(string const& name) const {
+    auto it = _nameIds.find(name);
+    return it != _nameIds.end() ? it->second : NO_NAME;
+}
+
+string const& SceneGraph::getInternedName(unsigned nameId) const { return _names[nameId]; }
+
+void SceneGraph::reserveChildIndex(size_t count) {
+    size_t capacity = 16;
+    while (capacity < count * 2) { capacity *= 2; }
+    if (capacity <= _childSlots.size()) { return; }
+    vector<ChildSlot> slots(capacity, ChildSlot{0, nullptr});
+    _childSlots.swap(slots);
+    for (ChildSlot const& slot : slots) {
+        if (slot.node) { insertChildSlot(slot); }
+    }
+}
+
+// linear probing, children with the same parent and name end up in one run of slots
+void SceneGraph::insertChildSlot(ChildSlot slot) {
+    size_t mask = _childSlots.size() - 1;
+    size_t index = size_t(slot.hash) & mask;
+    while (_childSlots[index].node) { index = (index + 1) & mask; }
+    _childSlots[index] = slot;
+}
+
+void SceneGraph::eraseChildSlot(Node* node) {
+    size_t mask = _childSlots.size() - 1;
+    size_t index = size_t(hashChild(node->_parent, node->_nameId)) & mask;
+    while (_childSlots[index].node != node) {
+        if (!_childSlots[index].node) { return; }
+        index = (index + 1) & mask;
+    }
+    // backward shift instead of tombstones: later entries of the run move into the gap
+    // unless the gap lies before their home slot, so every run stays free of holes
+    for (size_t next = (index + 1) & mask; _childSlots[next].node; next = (next + 1) & mask) {
+        size_t home = size_t(_childSlots[next].hash) & mask;
+        if (((next - home) & mask) >= ((next - index) & mask)) {
+            _childSlots[index] = _childSlots[next];
+            index = next;
+        }
+    }
+    _childSlots[index] = ChildSlot{0, nullptr};
+    --_indexedCount;
+}
+
+// Only large families are indexed, attaching to a small one touches no memory beyond the nodes
+void SceneGraph::indexNode(Node* node) {
+    Node* parent = node->_parent;
+    if (!parent || (!parent->_hasIndexedChildren && parent->_childCount <= INDEXED_CHILDREN)) { return; }
+    if (!parent->_hasIndexedChildren) { // family just outgrew the scan, node is its last child
+        parent->_hasIndexedChildren = true;
+        for (Node* child = parent->_firstChild; child != node; child = child->_nextSibling) { indexNode(child); }
+    }
+    if ((_indexedCount + 1) * 2 > _childSlots.size()) { reserveChildIndex(_indexedCount + 1); }
+    insertChildSlot(ChildSlot{hashChild(parent, node->_nameId), node});
+    ++_indexedCount;
+}
+
+void SceneGraph::unindexNode(Node* node) {
+    // checked first, after clear() the parent may be gone already
+    if (_indexedCount == 0 || !node->_parent || !node->_parent->_hasIndexedChildren) { return; }
+    Node* parent = node->_parent;
+    if (parent->_childCount > INDEXED_CHILDREN / 2 + 1) {
+        eraseChildSlot(node);
+        return;
+    }
+    for (Node* child = parent->_firstChild; child; child = child->_nextSibling) { eraseChildSlot(child); }
+    parent->_hasIndexedChildren = false;
+}
+
+Node* SceneGraph::findChild(Node* parent, unsigned nameId) {
+    if (!parent->_hasIndexedChildren) {
+        for (Node* child = parent->_firstChild; child; child = child->_nextSibling) {
+            if (child->_nameId == nameId) { return child; }
+        }
+        return nullptr;
+    }
+    // different children may share a hash, so compare the actual parent and name
+    uint64_t hash = hashChild(parent, nameId);
+    size_t mask = _childSlots.size() - 1;
+    for (size_t index = size_t(hash) & mask; _childSlots[index].node; index = (index + 1) & mask) {
+        Node* node = _childSlots[index].node;
+        if (_childSlots[index].hash == hash && node->_parent == parent && node->_nameId == nameId) { return node; }
+    }
+    return nullptr;
+}
+
+Node* SceneGraph::findNode(string const& path) {
+    // first name has to be the root's, every following one is a single probe into the child index
+    Node* node = nullptr;
+    size_t begin = 0;
+    while (begin <= path.size()) {
+        size_t end = path.find('/', begin);
+        if (end == string::npos) { end = path.size(); }
+        auto it = _nameIds.find(path.substr(begin, end - begin));
+        if (it == _nameIds.end()) { return nullptr; }
+        node = node ? findChild(node, it->second) : (_root && _root->_nameId == it->second ? _root : nullptr);
+        if (!node) { return nullptr; }
+        begin = end + 1;
+    }
+    return node;
+}
+
+TransformHierarchy& SceneGraph::getTransforms() { return _transforms; }
+
+// One forward sweep over the flat transform arrays instead of a recursive walk through the nodes
+void SceneGraph::updateWorldTransforms(TaskPool* taskPool) {
+    {
+        PROFILE_SCOPE("World transforms");
+        _transforms.update(taskPool);
+    }
+    PROFILE_SCOPE("Bounding volumes");
+    _boundingVolumes.update(_transforms);
+}
 
 void SceneGraph::printGraph() {
     std::cout << "------------ SceneGraph ------------" << std::endl;
-    auto printName = [this](shared_ptr<Node> node) {
-        std::string empty_string(node->getDepth() * 2, '    ');
-        std::cout << empty_string << node->getName() << std::endl;
-    };
-    printName(_root);
-    _root->traverse(printName);
+    for (Node& node : _root->preOrder()) {
+        std::string empty_string(node.getDepth() * 2, ' ');
+        std::cout << empty_string << node.getName() << std::endl;
+    }
     std::cout << "------------------------------------" << std::endl;
 }
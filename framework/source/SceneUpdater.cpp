@@ -0,0 +1,211 @@
+#include "SceneUpdater.hpp"
+#include "SceneGraph.hpp"
+#include "CameraNode.hpp"
+#include "GeometryNode.hpp"
+#include "TaskPool.hpp"
+#include "simd_math.hpp"
+#include "Profiler.hpp"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+using glm::fmat4;
+using glm::fvec3;
+using glm::fvec4;
+using std::vector;
+
+static const int MAX_SPLIT_LEVELS = 4; // how deep below the root subtrees are split up to feed all threads
+static const unsigned TASKS_PER_THREAD = 8; // more tasks than threads, so stealing can balance uneven subtrees
+
+void DrawBuffer::clear() {
+    nodes.clear();
+    modelMatrices.clear();
+    normalMatrices.clear();
+}
+
+SceneUpdater::SceneUpdater(unsigned threadCount) :
+    _taskPool(threadCount),
+    _isSingleThreaded(false),
+    _cullMode(CullMode::Hierarchy),
+    _viewportHeight(1080),
+    _isLodEnabled(true),
+    _drawBuffers(_taskPool.getThreadCount()) {
+}
+
+void SceneUpdater::setAnimation(Animation animation) { _animation = animation; }
+void SceneUpdater::setSingleThreaded(bool isSingleThreaded) { _isSingleThreaded = isSingleThreaded; }
+bool SceneUpdater::isSingleThreaded() const { return _isSingleThreaded; }
+unsigned SceneUpdater::getThreadCount() const { return _isSingleThreaded ? 1 : _taskPool.getThreadCount(); }
+vector<DrawBuffer> const& SceneUpdater::getDrawBuffers() const { return _drawBuffers; }
+void SceneUpdater::setCullMode(CullMode mode) { _cullMode = mode; }
+SceneUpdater::CullMode SceneUpdater::getCullMode() const { return _cullMode; }
+SceneUpdater::CullStatistics SceneUpdater::getCullStatistics() const { return _cullStatistics; }
+void SceneUpdater::setViewportHeight(unsigned height) { _viewportHeight = height; }
+void SceneUpdater::setLodEnabled(bool isLodEnabled) { _isLodEnabled = isLodEnabled; }
+bool SceneUpdater::isLodEnabled() const { return _isLodEnabled; }
+
+void SceneUpdater::update() {
+    PROFILE_SCOPE("Scene update");
+    for (auto& buffer : _drawBuffers) { buffer.clear(); }
+    _cullStatistics = CullStatistics();
+    auto& scene = SceneGraph::getInstance();
+    Node* root = scene.getRoot();
+    if (!root) { return; }
+    bool isParallel = getThreadCount() > 1;
+
+    // 1. Animation changes local transforms only, so it runs before the world transforms are updated
+    if (_animation) {
+        PROFILE_SCOPE("Animation");
+        splitSubtrees(root);
+        forEachNode([this](Node& node, unsigned) { _animation(node); });
+    }
+
+    // 2. World transforms and bounds of dirty subtrees
+    scene.updateWorldTransforms(isParallel ? &_taskPool : nullptr);
+
+    // 3. Draw packets straight from the scenegraph's geometry list or the hierarchy's frustum query, no type checks.
+    //    Every task culls a chunk of nodes, appends the visible ones to the buffer of its thread, selects their levels of detail
+    //    and batch computes their normal matrices
+    fmat4 viewMatrix;
+    fvec4 frustumPlanes[6];
+    fvec3 cameraPosition;
+    float pixelScale = 0.0f;
+    bool isPerspective = true;
+    CullMode cullMode = scene.getCamera() ? _cullMode : CullMode::None;
+    if (scene.getCamera()) {
+        fmat4 cameraWorldTransform = scene.getCamera()->getWorldTransform();
+        fmat4 projectionMatrix = scene.getCamera()->getProjectionMatrix();
+        simd_math::affine_inverse(&cameraWorldTransform, &viewMatrix, 1);
+        simd_math::frustum_planes(projectionMatrix * viewMatrix, frustumPlanes);
+        cameraPosition = fvec3{cameraWorldTransform[3]};
+        pixelScale = 0.5f * float(_viewportHeight) * projectionMatrix[1][1];
+        isPerspective = projectionMatrix[2][3] != 0.0f;
+    }
+    // without a camera every node keeps its first level
+    bool isLod = _isLodEnabled && scene.getCamera();
+    _cullStatistics.tested = scene.getGeometryNodes().size();
+    if (cullMode == CullMode::Hierarchy) {
+        PROFILE_SCOPE("Frustum culling");
+        _visibleNodes.clear();
+        scene.getBoundingVolumes().queryFrustum(frustumPlanes, _visibleNodes);
+    }
+    auto const& geometryNodes = cullMode == CullMode::Hierarchy ? _visibleNodes : scene.getGeometryNodes();
+    bool isCulling = cullMode == CullMode::Linear;
+    auto collectDrawPackets = [this, &geometryNodes, &frustumPlanes, viewMatrix, isCulling, isLod, cameraPosition, pixelScale, isPerspective](size_t begin, size_t end) {
+        PROFILE_SCOPE("Draw packets");
+        DrawBuffer& buffer = _drawBuffers[TaskPool::getThreadIndex()];
+        size_t first = buffer.size();
+        if (isCulling) {
+            cullChunk(buffer, geometryNodes, begin, end, frustumPlanes);
+        }
+        for (size_t i = begin; i < end; ++i) {
+            if (isCulling && !buffer.isVisible[i - begin]) { continue; }
+            GeometryNode* node = geometryNodes[i];
+            buffer.nodes.push_back(node);
+            buffer.modelMatrices.push_back(node->getWorldTransform());
+            if (node->getLodCount() > 1) {
+                node->selectLod(isLod ? screenRadius(*node, buffer.modelMatrices.back(), cameraPosition, pixelScale, isPerspective)
+                                      : std::numeric_limits<float>::infinity());
+            }
+        }
+        buffer.normalMatrices.resize(buffer.size());
+        simd_math::normal_matrix(viewMatrix, buffer.modelMatrices.data() + first, buffer.normalMatrices.data() + first, buffer.size() - first);
+    };
+    if (!isParallel) {
+        collectDrawPackets(0, geometryNodes.size());
+    }
+    else {
+        size_t taskCount = std::min(geometryNodes.size(), size_t(getThreadCount()) * TASKS_PER_THREAD);
+        for (size_t task = 0; task < taskCount; ++task) {
+            size_t begin = geometryNodes.size() * task / taskCount;
+            size_t end = geometryNodes.size() * (task + 1) / taskCount;
+            _taskPool.push([&collectDrawPackets, begin, end]() { collectDrawPackets(begin, end); });
+        }
+        _taskPool.wait();
+    }
+    for (auto const& buffer : _drawBuffers) { _cullStatistics.visible += buffer.size(); }
+}
+
+void SceneUpdater::cullChunk(DrawBuffer& buffer, vector<GeometryNode*> const& nodes, size_t begin, size_t end, fvec4 const* frustumPlanes) {
+    size_t count = end - begin;
+    buffer.sphereX.resize(count);
+    buffer.sphereY.resize(count);
+    buffer.sphereZ.resize(count);
+    buffer.sphereRadius.resize(count);
+    buffer.isVisible.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        GeometryNode* node = nodes[begin + i];
+        bounding_volume const& bounds = node->getBounds();
+        fmat4 world = node->getWorldTransform();
+        fvec3 center = fvec3{world * fvec4{bounds.center, 1.0f}};
+        buffer.sphereX[i] = center.x;
+        buffer.sphereY[i] = center.y;
+        buffer.sphereZ[i] = center.z;
+        if (bounds.radius < 0.0f) {
+            buffer.sphereRadius[i] = std::numeric_limits<float>::infinity();
+            continue;
+        }
+        // the largest axis scale keeps the sphere conservative under non uniform scaling
+        float scale = std::max(glm::dot(fvec3{world[0]}, fvec3{world[0]}), std::max(glm::dot(fvec3{world[1]}, fvec3{world[1]}), glm::dot(fvec3{world[2]}, fvec3{world[2]})));
+        buffer.sphereRadius[i] = bounds.radius * std::sqrt(scale);
+    }
+    simd_math::cull_spheres(frustumPlanes, buffer.sphereX.data(), buffer.sphereY.data(), buffer.sphereZ.data(), buffer.sphereRadius.data(),
+                            buffer.isVisible.data(), count);
+}
+
+float SceneUpdater::screenRadius(GeometryNode& node, fmat4 const& world, fvec3 const& cameraPosition, float pixelScale, bool isPerspective) {
+    bounding_volume const& bounds = node.getBounds();
+    if (bounds.radius < 0.0f) { return std::numeric_limits<float>::infinity(); }
+    // the largest axis scale as in cullChunk
+    float scale = std::max(glm::dot(fvec3{world[0]}, fvec3{world[0]}), std::max(glm::dot(fvec3{world[1]}, fvec3{world[1]}), glm::dot(fvec3{world[2]}, fvec3{world[2]})));
+    float radius = bounds.radius * std::sqrt(scale);
+    if (!isPerspective) { return radius * pixelScale; }
+    float distance = glm::length(fvec3{world * fvec4{bounds.center, 1.0f}} - cameraPosition);
+    return distance > radius ? radius * pixelScale / distance : std::numeric_limits<float>::infinity();
+}
+
+template<typename Function>
+void SceneUpdater::forEachNode(Function const& function) {
+    for (Node* node : _splitNodes) { function(*node, 0); }
+    if (getThreadCount() < 2) {
+        for (Node* subtree : _subtrees) {
+            subtree->visit([&function](Node& node) { function(node, 0); });
+        }
+        return;
+    }
+
+    // consecutive subtrees are grouped, a task per subtree would cost more than the work in small ones
+    size_t taskCount = std::min(_subtrees.size(), size_t(getThreadCount()) * TASKS_PER_THREAD);
+    for (size_t task = 0; task < taskCount; ++task) {
+        size_t begin = _subtrees.size() * task / taskCount;
+        size_t end = _subtrees.size() * (task + 1) / taskCount;
+        _taskPool.push([this, &function, begin, end]() {
+            unsigned thread = TaskPool::getThreadIndex();
+            for (size_t i = begin; i < end; ++i) {
+                _subtrees[i]->visit([&function, thread](Node& node) { function(node, thread); });
+            }
+        });
+    }
+    _taskPool.wait();
+}
+
+void SceneUpdater::splitSubtrees(Node* root) {
+    _splitNodes.clear();
+    _subtrees.clear();
+    _subtrees.push_back(root);
+    // Descend while there are too few subtrees to keep every thread busy, e.g. a scene below a single holder node
+    size_t minSubtrees = size_t(getThreadCount()) * TASKS_PER_THREAD;
+    for (int level = 0; getThreadCount() > 1 && level < MAX_SPLIT_LEVELS && _subtrees.size() < minSubtrees; ++level) {
+        _nextSubtrees.clear();
+        for (Node* node : _subtrees) {
+            if (!node->getFirstChild()) {
+                _nextSubtrees.push_back(node);
+                continue;
+            }
+            _splitNodes.push_back(node);
+            for (Node* child = node->getFirstChild(); child; child = child->getNextSibling()) { _nextSubtrees.push_back(child); }
+        }
+        std::swap(_subtrees, _nextSubtrees);
+    }
+}
@@ -0,0 +1,135 @@
+#include "ShaderUniforms.hpp"
+#include <unordered_map>
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+
+UniformHandle ShaderUniforms::getHandle(string const& name) {
+    static std::unordered_map<string, UniformHandle> handles;
+    auto result = handles.emplace(name, UniformHandle(handles.size()));
+    return result.first->second;
+}
+
+static std::unordered_map<string, GLuint>& getBlockBindings() {
+    static std::unordered_map<string, GLuint> blockBindings;
+    return blockBindings;
+}
+
+void ShaderUniforms::setBlockBinding(string const& blockName, GLuint bindingPoint) {
+    getBlockBindings()[blockName] = bindingPoint;
+}
+
+void ShaderUniforms::reflect(GLuint program) {
+    _uniforms.clear();
+    _shadow.clear();
+    _statistics = Statistics();
+    if (program == 0) { return; }
+    bindBlocks(program);
+
+    GLint uniformCount = 0, maxNameLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+    vector<GLchar> nameBuffer(size_t(maxNameLength) + 1, 0);
+    for (GLint i = 0; i < uniformCount; ++i) {
+        GLsizei nameLength = 0;
+        GLint arraySize = 0;
+        GLenum type = GL_NONE;
+        glGetActiveUniform(program, GLuint(i), GLsizei(nameBuffer.size()), &nameLength, &arraySize, &type, nameBuffer.data());
+        string name(nameBuffer.data(), size_t(nameLength));
+        GLint location = glGetUniformLocation(program, name.c_str());
+        if (location == -1) { continue; } // member of a uniform block
+
+        // arrays are reported as "name[0]", they are set by their name
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) { name.resize(name.size() - 3); }
+        UniformHandle handle = getHandle(name);
+        if (handle >= _uniforms.size()) { _uniforms.resize(handle + 1); }
+        Uniform& uniform = _uniforms[handle];
+        uniform.location = location;
+        uniform.offset = unsigned(_shadow.size());
+        uniform.size = getValueSize(type); // arrays only shadow their first element
+        _shadow.resize(_shadow.size() + uniform.size);
+    }
+}
+
+bool ShaderUniforms::isActive(UniformHandle handle) const {
+    return handle < _uniforms.size() && _uniforms[handle].location != -1;
+}
+
+GLint ShaderUniforms::getLocation(UniformHandle handle) const {
+    return isActive(handle) ? _uniforms[handle].location : -1;
+}
+
+void ShaderUniforms::set(UniformHandle handle, GLint value) {
+    upload(handle, &value, sizeof(value), [value](GLint location) { glUniform1i(location, value); });
+}
+
+void ShaderUniforms::set(UniformHandle handle, bool value) {
+    set(handle, GLint(value ? 1 : 0));
+}
+
+void ShaderUniforms::set(UniformHandle handle, float value) {
+    upload(handle, &value, sizeof(value), [value](GLint location) { glUniform1f(location, value); });
+}
+
+void ShaderUniforms::set(UniformHandle handle, glm::fvec3 const& value) {
+    upload(handle, &value, sizeof(value), [&value](GLint location) { glUniform3fv(location, 1, glm::value_ptr(value)); });
+}
+
+void ShaderUniforms::set(UniformHandle handle, glm::fvec4 const& value) {
+    upload(handle, &value, sizeof(value), [&value](GLint location) { glUniform4fv(location, 1, glm::value_ptr(value)); });
+}
+
+void ShaderUniforms::set(UniformHandle handle, glm::fmat4 const& value) {
+    upload(handle, &value, sizeof(value), [&value](GLint location) { glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value)); });
+}
+
+ShaderUniforms::Statistics const& ShaderUniforms::getStatistics() const { return _statistics; }
+
+template<typename Upload>
+void ShaderUniforms::upload(UniformHandle handle, void const* value, unsigned size, Upload const& upload) {
+    if (!isActive(handle)) { return; }
+    Uniform& uniform = _uniforms[handle];
+    // a value of another size than the declared type is uploaded as is, GL reports the mismatch
+    bool isShadowed = size == uniform.size;
+    unsigned char* shadow = _shadow.data() + uniform.offset;
+    if (isShadowed && uniform.hasValue && std::memcmp(shadow, value, size) == 0) {
+        ++_statistics.skippedUploads;
+        return;
+    }
+    upload(uniform.location);
+    ++_statistics.uploads;
+    if (isShadowed) {
+        std::memcpy(shadow, value, size);
+        uniform.hasValue = true;
+    }
+}
+
+// GLSL 150 has no binding layout qualifier, blocks are bound after every link
+void ShaderUniforms::bindBlocks(GLuint program) {
+    GLint blockCount = 0, maxNameLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxNameLength);
+    vector<GLchar> nameBuffer(size_t(maxNameLength) + 1, 0);
+    for (GLint i = 0; i < blockCount; ++i) {
+        GLsizei nameLength = 0;
+        glGetActiveUniformBlockName(program, GLuint(i), GLsizei(nameBuffer.size()), &nameLength, nameBuffer.data());
+        auto binding = getBlockBindings().find(string(nameBuffer.data(), size_t(nameLength)));
+        if (binding != getBlockBindings().end()) {
+            glUniformBlockBinding(program, GLuint(i), binding->second);
+        }
+    }
+}
+
+unsigned ShaderUniforms::getValueSize(GLenum type) {
+    switch (type) {
+        case GL_FLOAT: return sizeof(float);
+        case GL_FLOAT_VEC2: return 2 * sizeof(float);
+        case GL_FLOAT_VEC3: return 3 * sizeof(float);
+        case GL_FLOAT_VEC4: return 4 * sizeof(float);
+        case GL_FLOAT_MAT3: return 9 * sizeof(float);
+        case GL_FLOAT_MAT4: return 16 * sizeof(float);
+        case GL_INT_VEC2: return 2 * sizeof(GLint);
+        case GL_INT_VEC3: return 3 * sizeof(GLint);
+        case GL_INT_VEC4: return 4 * sizeof(GLint);
+        default: return sizeof(GLint); // int, bool and samplers are set with glUniform1i
+    }
+}
@@ -0,0 +1,123 @@
+#include "StreamBuffer.hpp"
+#include "Profiler.hpp"
+#include "utils.hpp"
+#include <algorithm>
+
+StreamBuffer::StreamBuffer(size_t regionSize, unsigned regionCount) :
+    _handle(0),
+    _data(nullptr),
+    _fences(std::max(regionCount, 1u), nullptr),
+    _regionSize(0),
+    _region(0),
+    _frame(0),
+    _head(0),
+    _flushed(0),
+    _requiredSize(0),
+    _isPersistent(false),
+    _isRegionFree(true) {
+    _isPersistent = utils::has_gl_support(4, 4, "GL_ARB_buffer_storage");
+    create(std::max(regionSize, size_t(256)));
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (auto fence : _fences) { glDeleteSync(fence); }
+    glDeleteBuffers(1, &_handle);
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(size_t size, size_t alignment) {
+    // aligned in the whole buffer, not in the region: a baseInstance or a uniform block range is an absolute offset
+    size_t regionOffset = size_t(_region) * _regionSize;
+    size_t offset = (regionOffset + _head + alignment - 1) / alignment * alignment - regionOffset;
+    _requiredSize = std::max(_requiredSize, offset + size);
+    if (offset + size > _regionSize) {
+        ++_statistics.overflows;
+        return Allocation{ nullptr, 0 };
+    }
+    if (!_isRegionFree) { waitForRegion(); }
+    if (!_isPersistent && offset > _head) { // the padding is not uploaded
+        flush();
+        _flushed = offset;
+    }
+    _head = offset + size;
+    return Allocation{ _data + regionOffset + offset, regionOffset + offset };
+}
+
+void StreamBuffer::flush() {
+    if (_isPersistent || _flushed >= _head) { return; }
+    size_t regionOffset = size_t(_region) * _regionSize;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _handle);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(regionOffset + _flushed), GLsizeiptr(_head - _flushed), _data + regionOffset + _flushed);
+    _flushed = _head;
+}
+
+void StreamBuffer::nextFrame() {
+    flush();
+    if (_head > 0) {
+        _fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_UNUSED_BIT);
+    }
+    _statistics.peakBytes = std::max(_statistics.peakBytes, _head);
+    ++_statistics.frames;
+    ++_frame;
+    if (_requiredSize > _regionSize) {
+        // allocations of this frame failed, all regions are replaced by larger ones once the GPU is done with them
+        // the old buffer is deleted after the new one was created, users notice the growth by the new name
+        GLuint previous = _handle;
+        waitForAll();
+        create(std::max(2 * _regionSize, _requiredSize));
+        glDeleteBuffers(1, &previous);
+    }
+    _region = (_region + 1) % unsigned(_fences.size());
+    _head = 0;
+    _flushed = 0;
+    _requiredSize = 0;
+    _isRegionFree = _fences[_region] == nullptr;
+}
+
+GLuint StreamBuffer::getHandle() const { return _handle; }
+unsigned StreamBuffer::getFrame() const { return _frame; }
+size_t StreamBuffer::getRegionSize() const { return _regionSize; }
+bool StreamBuffer::isPersistent() const { return _isPersistent; }
+StreamBuffer::Statistics const& StreamBuffer::getStatistics() const { return _statistics; }
+
+void StreamBuffer::create(size_t regionSize) {
+    _regionSize = regionSize;
+    size_t size = _regionSize * _fences.size();
+    glGenBuffers(1, &_handle);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _handle);
+    if (_isPersistent) {
+        glBufferStorage(GL_COPY_WRITE_BUFFER, GLsizeiptr(size), nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+        _data = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, GLsizeiptr(size), GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+    }
+    else {
+        glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(size), nullptr, GL_DYNAMIC_DRAW);
+        _copy.assign(size, 0);
+        _data = _copy.data();
+    }
+}
+
+void StreamBuffer::waitForAll() {
+    for (auto& fence : _fences) {
+        if (!fence) { continue; }
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+void StreamBuffer::waitForRegion() {
+    GLsync& fence = _fences[_region];
+    if (glClientWaitSync(fence, GL_NONE_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+        // the GPU is more than regionCount - 1 frames behind, only now the CPU has to wait for it
+        PROFILE_SCOPE("Stream buffer stall");
+        double begin = Profiler::getInstance().now();
+        GLenum result = GL_TIMEOUT_EXPIRED;
+        while (result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+        }
+        ++_statistics.stalls;
+        _statistics.stallMicroseconds += Profiler::getInstance().now() - begin;
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+    _isRegionFree = true;
+}
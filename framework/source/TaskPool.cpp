@@ -0,0 +1,85 @@
+#include "TaskPool.hpp"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <utility>
+
+static thread_local unsigned threadIndex = 0;
+
+TaskPool::TaskPool(unsigned threadCount) :
+    _queuedTasks(0),
+    _pendingTasks(0),
+    _isStopping(false) {
+    if (threadCount == 0) { threadCount = std::thread::hardware_concurrency(); }
+    if (threadCount == 0) { threadCount = 1; } // hardware_concurrency() may not be computable
+    for (unsigned i = 0; i < threadCount; ++i) { _queues.emplace_back(new Queue()); }
+    for (unsigned i = 1; i < threadCount; ++i) { _workers.emplace_back(&TaskPool::workerLoop, this, i); }
+}
+
+TaskPool::~TaskPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(_wakeMutex);
+        _isStopping = true;
+    }
+    _wakeCondition.notify_all();
+    for (auto& worker : _workers) { worker.join(); }
+}
+
+unsigned TaskPool::getThreadCount() const { return unsigned(_queues.size()); }
+unsigned TaskPool::getThreadIndex() { return threadIndex; }
+
+void TaskPool::push(Task task) {
+    unsigned self = threadIndex < _queues.size() ? threadIndex : 0;
+    ++_pendingTasks;
+    ++_queuedTasks; // counted before it is visible to thieves, so the counter never drops below zero
+    {
+        std::lock_guard<std::mutex> lock(_queues[self]->mutex);
+        _queues[self]->tasks.push_back(std::move(task));
+    }
+    // lock once, so a worker between checking for tasks and going to sleep doesn't miss the notification
+    { std::lock_guard<std::mutex> lock(_wakeMutex); }
+    _wakeCondition.notify_one();
+}
+
+void TaskPool::wait() {
+    while (_pendingTasks > 0) {
+        if (!runTask(0)) { std::this_thread::yield(); } // remaining tasks are running on workers
+    }
+}
+
+bool TaskPool::runTask(unsigned self) {
+    Task task;
+    {
+        Queue& own = *_queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+    // steal the oldest task of the next non-empty queue, old tasks tend to be the big ones
+    for (size_t i = 1; !task && i < _queues.size(); ++i) {
+        Queue& victim = *_queues[(self + i) % _queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+    if (!task) { return false; }
+    --_queuedTasks;
+    task();
+    --_pendingTasks;
+    return true;
+}
+
+void TaskPool::workerLoop(unsigned self) {
+    threadIndex = self;
+    while (true) {
+        if (runTask(self)) { continue; }
+        std::unique_lock<std::mutex> lock(_wakeMutex);
+        _wakeCondition.wait(lock, [this]() { return _isStopping || _queuedTasks > 0; });
+        if (_isStopping) { return; }
+    }
+}
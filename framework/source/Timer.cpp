@@ -1,13 +1,22 @@
 #include "Timer.hpp"
 #include <GLFW/glfw3.h>
 
+static double fixedTimestep = 0.0; // reproducible animation, e.g. in headless benchmarks without glfw
+
 Timer::Timer() {
-    _lastTime = glfwGetTime();
+    _lastTime = fixedTimestep > 0.0 ? 0.0 : glfwGetTime();
 }
 
 double Timer::getElapsedTime() {
+    if (fixedTimestep > 0.0) {
+        return fixedTimestep;
+    }
     double currentTime = glfwGetTime();
     double elapsedTime = currentTime - _lastTime;
     _lastTime = currentTime;
     return elapsedTime;
+}
+
+void Timer::setFixedTimestep(double seconds) {
+    fixedTimestep = seconds;
 }
\ No newline at end of file
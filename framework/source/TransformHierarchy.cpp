@@ -0,0 +1,231 @@
+#include "TransformHierarchy.hpp"
+#include "simd_math.hpp"
+#include "TaskPool.hpp"
+#include <vector>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+using glm::mat4;
+using std::vector;
+
+static const unsigned INVALID_INDEX = ~0u;
+const TransformHierarchy::Handle TransformHierarchy::INVALID_HANDLE;
+const int TransformHierarchy::NO_PARENT;
+
+TransformHierarchy::TransformHierarchy() :
+    _isSorted(true) {
+}
+
+TransformHierarchy::Handle TransformHierarchy::allocate() {
+    Handle handle;
+    if (!_freeHandles.empty()) { // reuse released handle
+        handle = _freeHandles.back();
+        _freeHandles.pop_back();
+    }
+    else {
+        handle = Handle(_handleToIndex.size());
+        _handleToIndex.push_back(INVALID_INDEX);
+        _parentHandles.push_back(INVALID_HANDLE);
+    }
+
+    // A transform without parent is a root, so appending it keeps the depth-first order valid
+    _handleToIndex[handle] = unsigned(_localTransforms.size());
+    _parentHandles[handle] = INVALID_HANDLE;
+    _localTransforms.push_back(mat4{});
+    _worldTransforms.push_back(mat4{});
+    _parentIndices.push_back(NO_PARENT);
+    _dirtyFlags.push_back(1);
+    _subtreeEnds.push_back(_handleToIndex[handle] + 1);
+    _indexToHandle.push_back(handle);
+    return handle;
+}
+
+void TransformHierarchy::reserve(size_t count) {
+    _localTransforms.reserve(count);
+    _worldTransforms.reserve(count);
+    _parentIndices.reserve(count);
+    _dirtyFlags.reserve(count);
+    _subtreeEnds.reserve(count);
+    _indexToHandle.reserve(count);
+    _handleToIndex.reserve(count);
+    _parentHandles.reserve(count);
+}
+
+void TransformHierarchy::clear() {
+    _localTransforms.clear();
+    _worldTransforms.clear();
+    _parentIndices.clear();
+    _dirtyFlags.clear();
+    _updatedFlags.clear();
+    _subtreeEnds.clear();
+    _indexToHandle.clear();
+    _handleToIndex.clear();
+    _parentHandles.clear();
+    _freeHandles.clear();
+    _isSorted = true;
+}
+
+void TransformHierarchy::release(Handle handle) {
+    // Entry stays in the arrays as a detached root until the next sort drops it
+    unsigned index = _handleToIndex[handle];
+    _parentIndices[index] = NO_PARENT;
+    _dirtyFlags[index] = 0;
+    _indexToHandle[index] = INVALID_HANDLE;
+    _handleToIndex[handle] = INVALID_INDEX;
+    _parentHandles[handle] = INVALID_HANDLE;
+    _freeHandles.push_back(handle);
+    _isSorted = false;
+}
+
+void TransformHierarchy::setParent(Handle handle, Handle parentHandle) {
+    _parentHandles[handle] = parentHandle;
+    _dirtyFlags[_handleToIndex[handle]] = 1; // world transform depends on new parent now
+    _isSorted = false;
+}
+
+mat4 const& TransformHierarchy::getLocalTransform(Handle handle) const { return _localTransforms[_handleToIndex[handle]]; }
+void TransformHierarchy::setLocalTransform(Handle handle, mat4 const& localTransform) {
+    unsigned index = _handleToIndex[handle];
+    _localTransforms[index] = localTransform;
+    _dirtyFlags[index] = 1;
+}
+
+mat4 const& TransformHierarchy::getWorldTransform(Handle handle) const { return _worldTransforms[_handleToIndex[handle]]; }
+void TransformHierarchy::setWorldTransform(Handle handle, mat4 const& worldTransform) { _worldTransforms[_handleToIndex[handle]] = worldTransform; }
+
+bool TransformHierarchy::isDirty(Handle handle) const { return _dirtyFlags[_handleToIndex[handle]] != 0; }
+
+bool TransformHierarchy::wasUpdated(Handle handle) const {
+    // entries allocated after the last update are not swept yet
+    unsigned index = _handleToIndex[handle];
+    return index < _updatedFlags.size() && _updatedFlags[index] != 0;
+}
+
+void TransformHierarchy::collectUpdated(vector<Handle>& handles) const {
+    for (size_t index = 0; index < _updatedFlags.size(); ++index) {
+        if (_updatedFlags[index] && _indexToHandle[index] != INVALID_HANDLE) { handles.push_back(_indexToHandle[index]); }
+    }
+}
+
+size_t TransformHierarchy::size() const { return _localTransforms.size(); }
+
+void TransformHierarchy::update(TaskPool* taskPool) {
+    if (!_isSorted) { sortHierarchy(); }
+    _updatedFlags.resize(size());
+    if (!taskPool || taskPool->getThreadCount() < 2) {
+        sweep(0, size());
+        return;
+    }
+
+    // Subtrees are contiguous ranges, so every task sweeps its own slice of the arrays. Roots of
+    // subtrees too big for one task are swept here before their children are scheduled, and keep
+    // their dirty flag until all tasks are done, because the tasks still read it.
+    size_t grain = std::max(size() / (taskPool->getThreadCount() * 8), size_t(4096));
+    _splitIndices.clear();
+    scheduleSubtrees(0, size(), grain, *taskPool);
+    taskPool->wait();
+    for (size_t index : _splitIndices) {
+        _updatedFlags[index] = _dirtyFlags[index];
+        _dirtyFlags[index] = 0;
+    }
+}
+
+void TransformHierarchy::sweep(size_t begin, size_t end) {
+    // Parents precede their children, so a parent's world transform is final when a child reads it.
+    // A recomputed entry stays flagged during the sweep, which propagates the change down its subtree.
+    simd_math::multiply_hierarchy(_localTransforms.data(), _parentIndices.data(), _dirtyFlags.data(), _worldTransforms.data(), begin, end);
+    std::copy(_dirtyFlags.begin() + begin, _dirtyFlags.begin() + end, _updatedFlags.begin() + begin);
+    std::fill(_dirtyFlags.begin() + begin, _dirtyFlags.begin() + end, 0);
+}
+
+// Sibling subtrees in [begin, end) are batched into tasks of about grain entries
+void TransformHierarchy::scheduleSubtrees(size_t begin, size_t end, size_t grain, TaskPool& taskPool) {
+    size_t batchBegin = begin;
+    auto flush = [&](size_t batchEnd) {
+        if (batchBegin < batchEnd) { taskPool.push([this, batchBegin, batchEnd]() { sweep(batchBegin, batchEnd); }); }
+    };
+    for (size_t index = begin; index < end; index = _subtreeEnds[index]) {
+        size_t subtreeEnd = _subtreeEnds[index];
+        if (subtreeEnd - index > grain) {
+            flush(index);
+            simd_math::multiply_hierarchy(_localTransforms.data(), _parentIndices.data(), _dirtyFlags.data(), _worldTransforms.data(), index, index + 1);
+            _splitIndices.push_back(index);
+            scheduleSubtrees(index + 1, subtreeEnd, grain, taskPool);
+            batchBegin = subtreeEnd;
+        }
+        else if (subtreeEnd - batchBegin > grain) {
+            flush(index);
+            batchBegin = index;
+        }
+    }
+    flush(end);
+}
+
+// Rebuild arrays in depth-first order (children in handle order), dropping released entries
+void TransformHierarchy::sortHierarchy() {
+    size_t handleCount = _handleToIndex.size();
+    auto isAlive = [this](Handle handle) { return handle != INVALID_HANDLE && _handleToIndex[handle] != INVALID_INDEX; };
+
+    // Bucket children by parent handle (counting sort), so the traversal below is O(n)
+    vector<unsigned> childStart(handleCount + 1, 0);
+    for (Handle handle = 0; handle < handleCount; ++handle) {
+        if (isAlive(handle) && isAlive(_parentHandles[handle])) { ++childStart[_parentHandles[handle] + 1]; }
+    }
+    for (size_t i = 0; i < handleCount; ++i) { childStart[i + 1] += childStart[i]; }
+    vector<Handle> children(childStart[handleCount]);
+    vector<unsigned> fill(childStart.begin(), childStart.end() - 1);
+    for (Handle handle = 0; handle < handleCount; ++handle) {
+        if (isAlive(handle) && isAlive(_parentHandles[handle])) { children[fill[_parentHandles[handle]]++] = handle; }
+    }
+
+    size_t liveCount = handleCount - _freeHandles.size();
+    vector<mat4> locals; locals.reserve(liveCount);
+    vector<mat4> worlds; worlds.reserve(liveCount);
+    vector<int> parents; parents.reserve(liveCount);
+    vector<unsigned char> dirty; dirty.reserve(liveCount);
+    vector<Handle> indexToHandle; indexToHandle.reserve(liveCount);
+    vector<unsigned> handleToIndex(handleCount, INVALID_INDEX);
+
+    vector<Handle> stack;
+    auto visitSubtree = [&](Handle subtreeRoot) {
+        stack.push_back(subtreeRoot);
+        while (!stack.empty()) {
+            Handle handle = stack.back();
+            stack.pop_back();
+            if (handleToIndex[handle] != INVALID_INDEX) { continue; } // already placed (only happens inside a parent cycle)
+            unsigned oldIndex = _handleToIndex[handle];
+            Handle parentHandle = _parentHandles[handle];
+            bool hasParent = isAlive(parentHandle) && handleToIndex[parentHandle] != INVALID_INDEX;
+            handleToIndex[handle] = unsigned(locals.size());
+            locals.push_back(_localTransforms[oldIndex]);
+            worlds.push_back(_worldTransforms[oldIndex]);
+            parents.push_back(hasParent ? int(handleToIndex[parentHandle]) : NO_PARENT);
+            dirty.push_back(_dirtyFlags[oldIndex]);
+            indexToHandle.push_back(handle);
+            // push in reverse, so children are visited in handle order
+            for (unsigned c = childStart[handle + 1]; c > childStart[handle]; --c) { stack.push_back(children[c - 1]); }
+        }
+    };
+    for (Handle handle = 0; handle < handleCount; ++handle) {
+        if (isAlive(handle) && !isAlive(_parentHandles[handle])) { visitSubtree(handle); }
+    }
+    // Entries in a parent cycle are unreachable from any root, keep them as detached roots
+    for (Handle handle = 0; handle < handleCount; ++handle) {
+        if (isAlive(handle) && handleToIndex[handle] == INVALID_INDEX) { visitSubtree(handle); }
+    }
+
+    _localTransforms.swap(locals);
+    _worldTransforms.swap(worlds);
+    // subtree of an entry ends where the subtree of its last descendant ends, parents are visited after their children here
+    vector<unsigned> subtreeEnds(parents.size());
+    for (size_t index = parents.size(); index-- > 0; ) {
+        if (subtreeEnds[index] < index + 1) { subtreeEnds[index] = unsigned(index + 1); }
+        if (parents[index] != NO_PARENT) { subtreeEnds[parents[index]] = std::max(subtreeEnds[parents[index]], subtreeEnds[index]); }
+    }
+
+    _parentIndices.swap(parents);
+    _dirtyFlags.swap(dirty);
+    _subtreeEnds.swap(subtreeEnds);
+    _indexToHandle.swap(indexToHandle);
+    _handleToIndex.swap(handleToIndex);
+    _isSorted = true;
+}
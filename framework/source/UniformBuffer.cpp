@@ -0,0 +1,69 @@
+#include "UniformBuffer.hpp"
+#include "StreamBuffer.hpp"
+#include <cstring>
+
+UniformBuffer::UniformBuffer(GLuint bindingPoint, size_t size) :
+    _handle(0),
+    _bindingPoint(bindingPoint),
+    _shadow(size),
+    _hasData(false),
+    _updateCount(0),
+    _stream(nullptr),
+    _isStreamed(false),
+    _streamFrame(0),
+    _offsetAlignment(256) {
+    glGenBuffers(1, &_handle);
+    glBindBuffer(GL_UNIFORM_BUFFER, _handle);
+    glBufferData(GL_UNIFORM_BUFFER, GLsizeiptr(size), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, _bindingPoint, _handle); // stays attached, programs only select the binding point
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    _offsetAlignment = alignment > 0 ? size_t(alignment) : _offsetAlignment;
+}
+
+UniformBuffer::~UniformBuffer() {
+    glDeleteBuffers(1, &_handle);
+}
+
+void UniformBuffer::update(void const* data) {
+    bool isChanged = !_hasData || std::memcmp(_shadow.data(), data, _shadow.size()) != 0;
+    if (isChanged) {
+        std::memcpy(_shadow.data(), data, _shadow.size());
+        _hasData = true;
+        ++_updateCount;
+    }
+    if (_stream) {
+        if (!isChanged && _isStreamed && _streamFrame == _stream->getFrame()) { return; }
+        StreamBuffer::Allocation allocation = _stream->allocate(_shadow.size(), _offsetAlignment);
+        if (allocation.data) {
+            std::memcpy(allocation.data, _shadow.data(), _shadow.size());
+            _stream->flush();
+            glBindBufferRange(GL_UNIFORM_BUFFER, _bindingPoint, _stream->getHandle(), GLintptr(allocation.offset), GLsizeiptr(_shadow.size()));
+            _isStreamed = true;
+            _streamFrame = _stream->getFrame();
+            return;
+        }
+        if (_isStreamed) { // the region is full, the own storage was not updated while streaming
+            glBindBufferBase(GL_UNIFORM_BUFFER, _bindingPoint, _handle);
+            _isStreamed = false;
+            isChanged = true;
+        }
+    }
+    if (!isChanged) { return; }
+    glBindBuffer(GL_UNIFORM_BUFFER, _handle);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, GLsizeiptr(_shadow.size()), _shadow.data());
+}
+
+void UniformBuffer::setStreamBuffer(StreamBuffer* stream) {
+    if (_isStreamed && !stream) { // back to the own storage, which is behind
+        glBindBufferBase(GL_UNIFORM_BUFFER, _bindingPoint, _handle);
+        glBindBuffer(GL_UNIFORM_BUFFER, _handle);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, GLsizeiptr(_shadow.size()), _shadow.data());
+        _isStreamed = false;
+    }
+    _stream = stream;
+}
+
+GLuint UniformBuffer::getHandle() const { return _handle; }
+GLuint UniformBuffer::getBindingPoint() const { return _bindingPoint; }
+unsigned UniformBuffer::getUpdateCount() const { return _updateCount; }
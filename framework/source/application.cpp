@@ -12,6 +12,10 @@ using namespace gl;
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
 static void update_shader_programs(std::map<std::string, shader_program>& shaders, bool throwing);
 
 const glm::uvec2 Application::initial_resolution = {1280u, 768u};
@@ -30,6 +34,7 @@ Application::~Application() {
 }
 
 void Application::reloadShaders(bool throwing) {
+  PROFILE_SCOPE("Load shaders");
   // recompile shaders from source files
   update_shader_programs(m_shaders, throwing);
   // after shader programs are recompiled, uniform locations may change
@@ -41,9 +46,11 @@ void Application::reloadShaders(bool throwing) {
 // update shader uniform locations
 void Application::updateUniformLocations() {
   for (auto& pair : m_shaders) {
+    // query all active uniforms of the new program at once
+    pair.second.uniforms.reflect(pair.second.handle);
     for (auto& uniform : pair.second.u_locs) {
-      // store uniform location in map
-      uniform.second = utils::glGetUniformLocation(pair.second.handle, uniform.first.c_str());
+      // store uniform location in map, names which are not active in this program get -1
+      uniform.second = pair.second.uniforms.getLocation(ShaderUniforms::getHandle(uniform.first));
     }
   }
 }
@@ -58,6 +65,12 @@ void Application::key_callback(GLFWwindow* m_window, int key, int action, int mo
   else if (key == GLFW_KEY_R && action == GLFW_PRESS) {
     reloadShaders(false);
   }
+  else if (key == GLFW_KEY_V && action == GLFW_PRESS) {
+    // cycle GL error checking: none -> debug output -> full
+    auto level = window_handler::validation_level((unsigned(window_handler::get_validation_level()) + 1) % 3);
+    window_handler::set_validation_level(level);
+    std::cout << "GL validation: " << window_handler::to_string(level) << std::endl;
+  }
   // else pass input to derived class
   else {
     keyCallback(key, action, mods);
@@ -72,6 +85,25 @@ void Application::mouse_callback(GLFWwindow* window, double pos_x, double pos_y)
   glfwSetCursorPos(window, 0.0, 0.0);
 }
 
+void Application::print_timing_summary(std::vector<double> frame_times, double seconds) {
+  if (frame_times.empty()) {
+    return;
+  }
+  double sum = 0.0;
+  for (double time : frame_times) {
+    sum += time;
+  }
+  std::sort(frame_times.begin(), frame_times.end());
+  auto percentile = [&frame_times](double p) {
+    return frame_times[std::min(frame_times.size() - 1, std::size_t(p * double(frame_times.size())))];
+  };
+  std::cout << std::fixed << std::setprecision(3)
+            << "Frames: " << frame_times.size() << " in " << seconds << " s, " << double(frame_times.size()) / seconds << " fps\n"
+            << "Frame time ms: mean " << sum / double(frame_times.size()) << ", min " << frame_times.front()
+            << ", p50 " << percentile(0.5) << ", p95 " << percentile(0.95) << ", p99 " << percentile(0.99)
+            << ", max " << frame_times.back() << std::endl;
+}
+
 // handle window resizing
 void Application::resize_callback(unsigned width, unsigned height) {
   // resize framebuffer
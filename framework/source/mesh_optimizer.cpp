@@ -0,0 +1,586 @@
+#include "mesh_optimizer.hpp"
+#include "Profiler.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace mesh_optimizer {
+
+// false if an index is past the vertices, e.g. of a model whose stride does not match its data
+static bool has_valid_indices(std::vector<GLuint> const& indices, std::size_t vertex_num) {
+  return std::all_of(indices.begin(), indices.end(), [vertex_num](GLuint index) { return std::size_t(index) < vertex_num; });
+}
+
+cache_statistics analyze(std::vector<GLuint> const& indices, std::size_t vertex_num, std::size_t cache_size) {
+  cache_statistics result;
+  if (indices.empty() || !has_valid_indices(indices, vertex_num)) {
+    return result;
+  }
+  // a vertex is in the cache while fewer than cache_size misses followed its own
+  std::size_t const NEVER = std::numeric_limits<std::size_t>::max();
+  std::vector<std::size_t> miss_time(vertex_num, NEVER);
+  std::size_t misses = 0, referenced = 0;
+  for (GLuint index : indices) {
+    if (miss_time[index] == NEVER) {
+      ++referenced;
+    }
+    else if (misses - miss_time[index] <= cache_size) {
+      continue;
+    }
+    miss_time[index] = misses++;
+  }
+  result.acmr = float(misses) / float(indices.size() / 3);
+  result.atvr = float(misses) / float(referenced);
+  return result;
+}
+
+void weld(std::vector<GLfloat>& data, std::size_t stride, std::vector<GLuint>& indices) {
+  std::size_t vertex_num = stride == 0 ? 0 : data.size() / stride;
+  if (!has_valid_indices(indices, vertex_num)) {
+    return;
+  }
+  std::size_t size = 16;
+  while (size < vertex_num * 2) size *= 2;
+  // open addressing table of kept vertices, hashed by their bits
+  std::uint32_t const EMPTY = 0xffffffffu;
+  std::vector<std::uint32_t> table(size, EMPTY);
+  std::vector<GLuint> remap(vertex_num);
+  std::size_t kept = 0;
+  for (std::size_t vertex = 0; vertex < vertex_num; ++vertex) {
+    GLfloat const* values = data.data() + vertex * stride;
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < stride; ++i) {
+      std::uint32_t bits;
+      std::memcpy(&bits, values + i, sizeof(bits));
+      hash = (hash ^ bits) * 1099511628211ull;
+    }
+    for (std::size_t slot = std::size_t(hash ^ (hash >> 32)) & (size - 1);; slot = (slot + 1) & (size - 1)) {
+      if (table[slot] == EMPTY) {
+        // kept vertices move to the front, in their original order
+        std::memmove(data.data() + kept * stride, values, stride * sizeof(GLfloat));
+        table[slot] = std::uint32_t(kept);
+        remap[vertex] = GLuint(kept++);
+        break;
+      }
+      if (std::memcmp(data.data() + table[slot] * stride, values, stride * sizeof(GLfloat)) == 0) {
+        remap[vertex] = table[slot];
+        break;
+      }
+    }
+  }
+  data.resize(kept * stride);
+  for (GLuint& index : indices) {
+    index = remap[index];
+  }
+}
+
+// score of a vertex, higher for recently used vertices and for those with few remaining triangles
+static float vertex_score(int cache_position, std::uint32_t remaining, std::size_t cache_size) {
+  if (remaining == 0) {
+    return -1.0f; // no triangle left to draw
+  }
+  float score = 0.0f;
+  if (cache_position >= 0) {
+    if (cache_position < 3) {
+      // vertices of the last triangle, fixed score so the next triangle does not simply use the same edge
+      score = 0.75f;
+    }
+    else {
+      float scale = 1.0f / float(cache_size - 3);
+      score = std::pow(1.0f - float(cache_position - 3) * scale, 1.5f);
+    }
+  }
+  // boost vertices with few triangles left, so single ones are not left behind
+  score += 2.0f * std::pow(float(remaining), -0.5f);
+  return score;
+}
+
+void reorder_triangles(std::vector<GLuint>& indices, std::size_t vertex_num, std::size_t cache_size) {
+  std::size_t triangle_num = indices.size() / 3;
+  if (triangle_num < 2 || cache_size < 4) {
+    return;
+  }
+  // triangles of each vertex, the first remaining[vertex] ones are not drawn yet
+  std::vector<std::uint32_t> offsets(vertex_num + 1, 0);
+  for (GLuint index : indices) {
+    ++offsets[index + 1];
+  }
+  for (std::size_t vertex = 0; vertex < vertex_num; ++vertex) {
+    offsets[vertex + 1] += offsets[vertex];
+  }
+  std::vector<std::uint32_t> remaining(vertex_num, 0);
+  std::vector<std::uint32_t> vertex_triangles(indices.size());
+  for (std::size_t i = 0; i < indices.size(); ++i) {
+    GLuint vertex = indices[i];
+    vertex_triangles[offsets[vertex] + remaining[vertex]++] = std::uint32_t(i / 3);
+  }
+
+  std::vector<float> scores(vertex_num);
+  for (std::size_t vertex = 0; vertex < vertex_num; ++vertex) {
+    scores[vertex] = vertex_score(-1, remaining[vertex], cache_size);
+  }
+  auto triangle_score = [&indices, &scores](std::uint32_t triangle) {
+    return scores[indices[3 * triangle]] + scores[indices[3 * triangle + 1]] + scores[indices[3 * triangle + 2]];
+  };
+  std::vector<bool> is_drawn(triangle_num, false);
+  std::uint32_t best = 0;
+  float best_score = triangle_score(0);
+  for (std::uint32_t triangle = 1; triangle < triangle_num; ++triangle) {
+    float score = triangle_score(triangle);
+    if (score > best_score) {
+      best_score = score;
+      best = triangle;
+    }
+  }
+
+  // least recently used first, up to three more entries while a triangle is added
+  std::vector<GLuint> cache, next_cache;
+  cache.reserve(cache_size + 3);
+  next_cache.reserve(cache_size + 3);
+  std::vector<GLuint> ordered;
+  ordered.reserve(indices.size());
+  std::size_t next_undrawn = 0; // triangles before are all drawn
+  for (std::size_t drawn = 0; drawn < triangle_num; ++drawn) {
+    if (best == std::numeric_limits<std::uint32_t>::max()) {
+      // no cached vertex has triangles left, continue with the next triangle of the input
+      while (is_drawn[next_undrawn]) ++next_undrawn;
+      best = std::uint32_t(next_undrawn);
+    }
+    GLuint const* corners = indices.data() + 3 * best;
+    ordered.insert(ordered.end(), corners, corners + 3);
+    is_drawn[best] = true;
+
+    // the triangle's vertices move to the front of the cache
+    next_cache.assign(corners, corners + 3);
+    for (GLuint vertex : cache) {
+      if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2]) {
+        next_cache.push_back(vertex);
+      }
+    }
+    for (int corner = 0; corner < 3; ++corner) {
+      GLuint vertex = corners[corner];
+      std::uint32_t* triangles = vertex_triangles.data() + offsets[vertex];
+      std::uint32_t* found = std::find(triangles, triangles + remaining[vertex], best);
+      if (found != triangles + remaining[vertex]) {
+        std::swap(*found, triangles[--remaining[vertex]]);
+      }
+    }
+    std::swap(cache, next_cache);
+
+    // new scores of the cached and the evicted vertices, and of their remaining triangles
+    for (std::size_t position = 0; position < cache.size(); ++position) {
+      GLuint vertex = cache[position];
+      scores[vertex] = vertex_score(position < cache_size ? int(position) : -1, remaining[vertex], cache_size);
+    }
+    best = std::numeric_limits<std::uint32_t>::max();
+    best_score = -1.0f;
+    for (GLuint vertex : cache) {
+      std::uint32_t const* triangles = vertex_triangles.data() + offsets[vertex];
+      for (std::uint32_t i = 0; i < remaining[vertex]; ++i) {
+        std::uint32_t triangle = triangles[i];
+        float score = triangle_score(triangle);
+        if (score > best_score) {
+          best_score = score;
+          best = triangle;
+        }
+      }
+    }
+    if (cache.size() > cache_size) {
+      cache.resize(cache_size);
+    }
+  }
+  indices.swap(ordered);
+}
+
+void reorder_vertices(std::vector<GLfloat>& data, std::size_t stride, std::vector<GLuint>& indices) {
+  std::size_t vertex_num = data.size() / stride;
+  GLuint const UNUSED = std::numeric_limits<GLuint>::max();
+  std::vector<GLuint> remap(vertex_num, UNUSED);
+  std::vector<GLfloat> ordered;
+  ordered.reserve(data.size());
+  GLuint next = 0;
+  for (GLuint& index : indices) {
+    if (remap[index] == UNUSED) {
+      remap[index] = next++;
+      ordered.insert(ordered.end(), data.begin() + std::ptrdiff_t(index * stride), data.begin() + std::ptrdiff_t((index + 1) * stride));
+    }
+    index = remap[index];
+  }
+  data.swap(ordered);
+}
+
+statistics optimize(model& mesh) {
+  PROFILE_SCOPE("Optimize mesh");
+  statistics result;
+  result.vertex_num_before = mesh.vertex_num;
+  std::size_t stride = std::size_t(mesh.vertex_bytes) / sizeof(GLfloat);
+  if (stride == 0 || mesh.indices.size() < 3 || mesh.data.size() % stride != 0 || !has_valid_indices(mesh.indices, mesh.data.size() / stride)) {
+    result.vertex_num_after = mesh.vertex_num;
+    return result;
+  }
+  result.before = analyze(mesh.indices, mesh.vertex_num);
+  weld(mesh.data, stride, mesh.indices);
+  reorder_triangles(mesh.indices, mesh.data.size() / stride);
+  reorder_vertices(mesh.data, stride, mesh.indices);
+  mesh.vertex_num = mesh.data.size() / stride;
+  result.vertex_num_after = mesh.vertex_num;
+  result.after = analyze(mesh.indices, mesh.vertex_num);
+  return result;
+}
+
+// symmetric 4x4 matrix of the squared distances to a set of planes, weighted by triangle area
+struct quadric {
+  double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0, b2 = 0.0, bc = 0.0, bd = 0.0, c2 = 0.0, cd = 0.0, d2 = 0.0;
+  double weight = 0.0;
+
+  // plane of unit normal n through point
+  void add_plane(glm::dvec3 const& n, glm::dvec3 const& point, double plane_weight) {
+    double d = -glm::dot(n, point);
+    a2 += plane_weight * n.x * n.x; ab += plane_weight * n.x * n.y; ac += plane_weight * n.x * n.z; ad += plane_weight * n.x * d;
+    b2 += plane_weight * n.y * n.y; bc += plane_weight * n.y * n.z; bd += plane_weight * n.y * d;
+    c2 += plane_weight * n.z * n.z; cd += plane_weight * n.z * d;
+    d2 += plane_weight * d * d;
+    weight += plane_weight;
+  }
+
+  void add(quadric const& other) {
+    a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad; b2 += other.b2;
+    bc += other.bc; bd += other.bd; c2 += other.c2; cd += other.cd; d2 += other.d2;
+    weight += other.weight;
+  }
+
+  // weighted sum of squared distances of p
+  double evaluate(glm::dvec3 const& p) const {
+    return a2 * p.x * p.x + 2.0 * ab * p.x * p.y + 2.0 * ac * p.x * p.z + 2.0 * ad * p.x
+         + b2 * p.y * p.y + 2.0 * bc * p.y * p.z + 2.0 * bd * p.y
+         + c2 * p.z * p.z + 2.0 * cd * p.z + d2;
+  }
+};
+
+// a candidate collapse of group from onto group to, outdated once either group changed
+struct collapse {
+  double cost;
+  std::uint32_t from;
+  std::uint32_t to;
+  std::uint32_t from_version;
+  std::uint32_t to_version;
+
+  bool operator>(collapse const& other) const {
+    return cost > other.cost;
+  }
+};
+
+// constraint planes along open borders are weighted more than the surface, so borders do not shrink
+static double const BOUNDARY_WEIGHT = 10.0;
+
+// distance of p to triangle abc, by the region of the closest feature (Ericson, Real-Time Collision Detection 5.1.5)
+static double distance_to_triangle(glm::dvec3 const& p, glm::dvec3 const& a, glm::dvec3 const& b, glm::dvec3 const& c) {
+  glm::dvec3 ab = b - a, ac = c - a, ap = p - a;
+  double d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+  if (d1 <= 0.0 && d2 <= 0.0) return glm::length(ap);
+  glm::dvec3 bp = p - b;
+  double d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+  if (d3 >= 0.0 && d4 <= d3) return glm::length(bp);
+  double vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) return glm::length(p - (a + ab * (d1 / (d1 - d3))));
+  glm::dvec3 cp = p - c;
+  double d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+  if (d6 >= 0.0 && d5 <= d6) return glm::length(cp);
+  double vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) return glm::length(p - (a + ac * (d2 / (d2 - d6))));
+  double va = d3 * d6 - d5 * d4;
+  if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0) return glm::length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+  double denominator = va + vb + vc;
+  if (denominator <= 0.0) {
+    // collinear corners, the closest of the edges decided above
+    return std::min(glm::length(ap), std::min(glm::length(bp), glm::length(cp)));
+  }
+  return glm::length(p - (a + ab * (vb / denominator) + ac * (vc / denominator)));
+}
+
+float simplify(model& mesh, std::size_t triangle_budget) {
+  PROFILE_SCOPE("Simplify mesh");
+  std::size_t stride = std::size_t(mesh.vertex_bytes) / sizeof(GLfloat);
+  std::size_t vertex_num = stride == 0 ? 0 : mesh.data.size() / stride;
+  if (mesh.indices.size() / 3 <= triangle_budget || vertex_num == 0 || !has_valid_indices(mesh.indices, vertex_num)) {
+    return 0.0f;
+  }
+  auto position = [&mesh, stride](std::size_t vertex) {
+    GLfloat const* values = mesh.data.data() + vertex * stride;
+    return glm::dvec3{values[0], values[1], values[2]};
+  };
+
+  // vertices at the same position, which differ in other attributes, form one group and move together
+  std::vector<std::uint32_t> order(vertex_num);
+  for (std::size_t vertex = 0; vertex < vertex_num; ++vertex) {
+    order[vertex] = std::uint32_t(vertex);
+  }
+  auto less_position = [&mesh, stride](std::uint32_t a, std::uint32_t b) {
+    return std::lexicographical_compare(mesh.data.begin() + std::ptrdiff_t(a * stride), mesh.data.begin() + std::ptrdiff_t(a * stride + 3),
+                                        mesh.data.begin() + std::ptrdiff_t(b * stride), mesh.data.begin() + std::ptrdiff_t(b * stride + 3));
+  };
+  std::sort(order.begin(), order.end(), less_position);
+  std::vector<std::uint32_t> group(vertex_num);
+  std::vector<glm::dvec3> positions;
+  for (std::size_t i = 0; i < vertex_num; ++i) {
+    if (i == 0 || less_position(order[i - 1], order[i])) {
+      positions.push_back(position(order[i]));
+    }
+    group[order[i]] = std::uint32_t(positions.size() - 1);
+  }
+  std::size_t group_num = positions.size();
+
+  // triangles of each group, triangles with two corners at the same position are dropped
+  std::vector<GLuint> indices = mesh.indices;
+  std::size_t triangle_num = indices.size() / 3;
+  std::vector<bool> is_alive(triangle_num, false);
+  std::vector<std::vector<std::uint32_t>> group_triangles(group_num);
+  std::vector<quadric> quadrics(group_num);
+  std::vector<std::pair<std::uint64_t, std::uint32_t>> edges;
+  std::size_t live_num = 0;
+  for (std::size_t triangle = 0; triangle < triangle_num; ++triangle) {
+    std::uint32_t g[3] = {group[indices[3 * triangle]], group[indices[3 * triangle + 1]], group[indices[3 * triangle + 2]]};
+    if (g[0] == g[1] || g[1] == g[2] || g[2] == g[0]) {
+      continue;
+    }
+    is_alive[triangle] = true;
+    ++live_num;
+    glm::dvec3 normal = glm::cross(positions[g[1]] - positions[g[0]], positions[g[2]] - positions[g[0]]);
+    double length = glm::length(normal);
+    for (int corner = 0; corner < 3; ++corner) {
+      group_triangles[g[corner]].push_back(std::uint32_t(triangle));
+      if (length > 0.0) {
+        quadrics[g[corner]].add_plane(normal / length, positions[g[0]], length * 0.5);
+      }
+      std::uint32_t a = g[corner], b = g[(corner + 1) % 3];
+      edges.emplace_back(std::uint64_t(std::min(a, b)) << 32 | std::max(a, b), std::uint32_t(triangle));
+    }
+  }
+  // edges of a single triangle are open borders, held by a plane through the edge perpendicular to the triangle
+  std::sort(edges.begin(), edges.end());
+  for (std::size_t i = 0; i < edges.size(); ++i) {
+    bool is_single = (i == 0 || edges[i - 1].first != edges[i].first) && (i + 1 == edges.size() || edges[i + 1].first != edges[i].first);
+    if (!is_single) {
+      continue;
+    }
+    std::size_t triangle = edges[i].second;
+    glm::dvec3 a = positions[std::uint32_t(edges[i].first >> 32)], b = positions[std::uint32_t(edges[i].first)];
+    glm::dvec3 normal = glm::cross(positions[group[indices[3 * triangle + 1]]] - positions[group[indices[3 * triangle]]],
+                                   positions[group[indices[3 * triangle + 2]]] - positions[group[indices[3 * triangle]]]);
+    glm::dvec3 constraint = glm::cross(b - a, normal);
+    double length = glm::length(constraint);
+    if (length > 0.0) {
+      double edge_length = glm::length(b - a);
+      quadrics[std::uint32_t(edges[i].first >> 32)].add_plane(constraint / length, a, BOUNDARY_WEIGHT * edge_length * edge_length);
+      quadrics[std::uint32_t(edges[i].first)].add_plane(constraint / length, a, BOUNDARY_WEIGHT * edge_length * edge_length);
+    }
+  }
+  std::vector<std::pair<std::uint64_t, std::uint32_t>>().swap(edges);
+
+  std::vector<std::uint32_t> versions(group_num, 0);
+  std::vector<bool> is_removed(group_num, false);
+  // the group each removed one was collapsed onto, the others point to themselves
+  std::vector<std::uint32_t> collapsed_onto(group_num);
+  for (std::size_t g = 0; g < group_num; ++g) {
+    collapsed_onto[g] = std::uint32_t(g);
+  }
+  std::priority_queue<collapse, std::vector<collapse>, std::greater<collapse>> candidates;
+  auto push = [&](std::uint32_t from, std::uint32_t to) {
+    quadric merged = quadrics[from];
+    merged.add(quadrics[to]);
+    double cost = merged.weight > 0.0 ? std::max(merged.evaluate(positions[to]), 0.0) / merged.weight : 0.0;
+    candidates.push(collapse{cost, from, to, versions[from], versions[to]});
+  };
+  auto contains = [&indices, &group](std::uint32_t triangle, std::uint32_t g) {
+    return group[indices[3 * triangle]] == g || group[indices[3 * triangle + 1]] == g || group[indices[3 * triangle + 2]] == g;
+  };
+  // other groups sharing a live triangle with g, sorted
+  auto neighbours = [&](std::uint32_t g, std::vector<std::uint32_t>& result) {
+    result.clear();
+    for (std::uint32_t triangle : group_triangles[g]) {
+      if (is_alive[triangle]) {
+        for (int corner = 0; corner < 3; ++corner) {
+          if (group[indices[3 * triangle + corner]] != g) {
+            result.push_back(group[indices[3 * triangle + corner]]);
+          }
+        }
+      }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+  };
+  for (std::size_t triangle = 0; triangle < triangle_num; ++triangle) {
+    if (is_alive[triangle]) {
+      for (int corner = 0; corner < 3; ++corner) {
+        push(group[indices[3 * triangle + corner]], group[indices[3 * triangle + (corner + 1) % 3]]);
+        push(group[indices[3 * triangle + (corner + 1) % 3]], group[indices[3 * triangle + corner]]);
+      }
+    }
+  }
+
+  std::vector<std::pair<GLuint, GLuint>> wedges; // vertex of from and the vertex of to it becomes
+  std::vector<std::uint32_t> from_neighbours, to_neighbours, common;
+  while (live_num > triangle_budget && !candidates.empty()) {
+    collapse candidate = candidates.top();
+    candidates.pop();
+    std::uint32_t from = candidate.from, to = candidate.to;
+    if (is_removed[from] || is_removed[to] || versions[from] != candidate.from_version || versions[to] != candidate.to_version) {
+      continue;
+    }
+    // each vertex of from must continue as one vertex of to across a triangle of the edge and no two as the same,
+    // so attribute seams only move along themselves
+    wedges.clear();
+    std::size_t shared = 0;
+    bool is_valid = true;
+    for (std::uint32_t triangle : group_triangles[from]) {
+      if (!is_alive[triangle] || !contains(triangle, to)) {
+        continue;
+      }
+      ++shared;
+      GLuint from_vertex = 0, to_vertex = 0;
+      for (int corner = 0; corner < 3; ++corner) {
+        GLuint vertex = indices[3 * triangle + corner];
+        if (group[vertex] == from) from_vertex = vertex;
+        if (group[vertex] == to) to_vertex = vertex;
+      }
+      for (auto const& wedge : wedges) {
+        is_valid = is_valid && (wedge.first == from_vertex) == (wedge.second == to_vertex);
+      }
+      wedges.emplace_back(from_vertex, to_vertex);
+    }
+    for (std::uint32_t triangle : group_triangles[from]) {
+      if (!is_valid || shared == 0) {
+        break;
+      }
+      if (!is_alive[triangle] || contains(triangle, to)) {
+        continue;
+      }
+      for (int corner = 0; corner < 3 && is_valid; ++corner) {
+        GLuint vertex = indices[3 * triangle + corner];
+        is_valid = group[vertex] != from || std::find_if(wedges.begin(), wedges.end(),
+                   [vertex](std::pair<GLuint, GLuint> const& wedge) { return wedge.first == vertex; }) != wedges.end();
+      }
+      // no triangle may turn over
+      glm::dvec3 corners[3];
+      for (int corner = 0; corner < 3; ++corner) {
+        corners[corner] = positions[group[indices[3 * triangle + corner]]];
+      }
+      glm::dvec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+      for (int corner = 0; corner < 3; ++corner) {
+        if (group[indices[3 * triangle + corner]] == from) corners[corner] = positions[to];
+      }
+      glm::dvec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+      is_valid = is_valid && glm::dot(before, after) > 0.0;
+    }
+    if (!is_valid || shared == 0) {
+      continue;
+    }
+    // link condition: the edge's triangles are the only ones of both groups, else the surface would pinch
+    neighbours(from, from_neighbours);
+    neighbours(to, to_neighbours);
+    common.clear();
+    std::set_intersection(from_neighbours.begin(), from_neighbours.end(), to_neighbours.begin(), to_neighbours.end(), std::back_inserter(common));
+    if (common.size() != shared) {
+      continue;
+    }
+
+    for (std::uint32_t triangle : group_triangles[from]) {
+      if (!is_alive[triangle]) {
+        continue;
+      }
+      if (contains(triangle, to)) {
+        is_alive[triangle] = false;
+        --live_num;
+        continue;
+      }
+      for (int corner = 0; corner < 3; ++corner) {
+        GLuint& vertex = indices[3 * triangle + corner];
+        if (group[vertex] == from) {
+          vertex = std::find_if(wedges.begin(), wedges.end(), [vertex](std::pair<GLuint, GLuint> const& wedge) { return wedge.first == vertex; })->second;
+        }
+      }
+      group_triangles[to].push_back(triangle);
+    }
+    auto& to_triangles = group_triangles[to];
+    to_triangles.erase(std::remove_if(to_triangles.begin(), to_triangles.end(), [&is_alive](std::uint32_t triangle) { return !is_alive[triangle]; }), to_triangles.end());
+    std::vector<std::uint32_t>().swap(group_triangles[from]);
+    quadrics[to].add(quadrics[from]);
+    is_removed[from] = true;
+    collapsed_onto[from] = to;
+    ++versions[to];
+    neighbours(to, to_neighbours);
+    for (std::uint32_t neighbour : to_neighbours) {
+      push(neighbour, to);
+      push(to, neighbour);
+    }
+  }
+
+  // the error is measured rather than estimated by the quadrics: the distance of each vertex of the mesh to the
+  // remaining triangles near the group it ended in bounds its distance to the simplified surface
+  std::vector<bool> is_referenced(group_num, false);
+  for (GLuint index : mesh.indices) {
+    is_referenced[group[index]] = true;
+  }
+  auto corner = [&](std::uint32_t triangle, int i) { return positions[group[indices[3 * triangle + i]]]; };
+  double max_distance = 0.0;
+  for (std::size_t g = 0; g < group_num && live_num > 0; ++g) {
+    if (!is_referenced[g]) {
+      continue;
+    }
+    std::uint32_t end = std::uint32_t(g);
+    while (collapsed_onto[end] != end) {
+      end = collapsed_onto[end];
+    }
+    // the triangles of the group and of its neighbours, the surface a vertex was collapsed over is mostly among them
+    double closest = std::numeric_limits<double>::infinity();
+    neighbours(end, to_neighbours);
+    to_neighbours.push_back(end);
+    for (std::uint32_t around : to_neighbours) {
+      for (std::uint32_t triangle : group_triangles[around]) {
+        if (is_alive[triangle]) {
+          closest = std::min(closest, distance_to_triangle(positions[g], corner(triangle, 0), corner(triangle, 1), corner(triangle, 2)));
+        }
+      }
+    }
+    if (closest == std::numeric_limits<double>::infinity()) {
+      // the group lost all its triangles, any remaining one bounds the distance
+      for (std::size_t triangle = 0; triangle < triangle_num; ++triangle) {
+        if (is_alive[triangle]) {
+          closest = std::min(closest, distance_to_triangle(positions[g], corner(std::uint32_t(triangle), 0), corner(std::uint32_t(triangle), 1), corner(std::uint32_t(triangle), 2)));
+        }
+      }
+    }
+    max_distance = std::max(max_distance, closest);
+  }
+  if (live_num == 0) {
+    // nothing is left of the surface, e.g. of a mesh of degenerate triangles only
+    max_distance = std::numeric_limits<double>::infinity();
+  }
+
+  std::vector<GLuint> simplified;
+  simplified.reserve(3 * live_num);
+  for (std::size_t triangle = 0; triangle < triangle_num; ++triangle) {
+    if (is_alive[triangle]) {
+      simplified.insert(simplified.end(), indices.begin() + std::ptrdiff_t(3 * triangle), indices.begin() + std::ptrdiff_t(3 * triangle + 3));
+    }
+  }
+  mesh.indices.swap(simplified);
+  // unreferenced vertices are dropped by the vertex order
+  reorder_triangles(mesh.indices, vertex_num);
+  reorder_vertices(mesh.data, stride, mesh.indices);
+  mesh.vertex_num = mesh.data.size() / stride;
+  // rounded up, so the bound holds as a float
+  float result = float(max_distance);
+  return double(result) < max_distance ? std::nextafter(result, std::numeric_limits<float>::infinity()) : result;
+}
+
+}
@@ -19,6 +19,13 @@ model::attribute const& model::TEXCOORD = model::VERTEX_ATTRIBS[2];
 model::attribute const& model::TANGENT = model::VERTEX_ATTRIBS[3];
 model::attribute const& model::BITANGENT = model::VERTEX_ATTRIBS[4];
 model::attribute const  model::INDEX{1 << 5, sizeof(unsigned),  1, GL_UNSIGNED_INT};
+model::attribute const  model::NORMAL_OCTAHEDRAL{1 << 1, sizeof(std::int16_t), 2, GL_SHORT, GL_TRUE};
+model::attribute const  model::TEXCOORD_UNORM16{ 1 << 2, sizeof(std::uint16_t), 2, GL_UNSIGNED_SHORT, GL_TRUE};
+model::attribute const  model::TEXCOORD_HALF{    1 << 2, sizeof(std::uint16_t), 2, GL_HALF_FLOAT};
+// the size of a packed format is a whole vertex attribute, 4 bytes
+model::attribute const  model::TANGENT_PACKED{  1 << 3, 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE};
+model::attribute const  model::BITANGENT_PACKED{1 << 4, 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE};
+model::attribute const  model::INDEX_16{1 << 5, sizeof(std::uint16_t), 1, GL_UNSIGNED_SHORT};
 
 model::model()
  :data{}
@@ -26,6 +33,7 @@ model::model()
  ,offsets{}
  ,vertex_bytes{0}
  ,vertex_num{0}
+ ,lod_error{0.0f}
 {}
 
 model::model(std::vector<GLfloat> const& databuff, attrib_flag_t contained_attributes, std::vector<GLuint> const& trianglebuff)
@@ -34,6 +42,7 @@ model::model(std::vector<GLfloat> const& databuff, attrib_flag_t contained_attri
  ,offsets{}
  ,vertex_bytes{0}
  ,vertex_num{0}
+ ,lod_error{0.0f}
 {
   // number of components per vertex
   std::size_t component_num = 0;
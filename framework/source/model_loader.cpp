@@ -1,10 +1,33 @@
 #include "model_loader.hpp"
+#include "mesh_optimizer.hpp"
+#include "Profiler.hpp"
+#include "TaskPool.hpp"
+#include "vertex_packing.hpp"
 
 // use floats and med precision operations
 #include <glm/gtc/type_precision.hpp>
 #include <glm/geometric.hpp>
 
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 namespace model_loader {
 
@@ -12,11 +35,818 @@ void generate_normals(tinyobj::mesh_t& model);
 
 std::vector<glm::fvec3> generate_tangents(tinyobj::mesh_t const& model);
 
-model obj(std::string const& name, model::attrib_flag_t import_attribs){
+// layout of a mesh cache file, all values in the byte order of the machine which wrote it:
+// header, then the vertex block (vertex_num * vertex_bytes) and the index block (index_num of index_type), both 16 byte aligned
+struct mesh_cache_header {
+  std::uint32_t magic;
+  std::uint32_t version;
+  // source the cache was built from
+  std::uint64_t source_size;
+  std::int64_t source_mtime;
+  std::uint64_t source_hash;
+  std::int32_t import_attribs;
+  std::uint32_t is_optimized;
+  std::uint32_t is_packed;
+  // triangle budget of a simplified level of detail, 0 for the mesh itself
+  std::uint64_t lod_triangle_budget;
+  float lod_error;
+  // contained attributes, interleaved in the order of model::VERTEX_ATTRIBS
+  std::int32_t attributes;
+  std::uint32_t vertex_bytes;
+  std::uint32_t attribute_num;
+  struct {
+    std::int32_t flag;
+    std::int32_t size;
+    std::int32_t components;
+    std::uint32_t type;
+    std::uint32_t normalized;
+    std::uint32_t offset; // in bytes from the start of a vertex
+  } layout[8];
+  std::uint32_t index_type;
+  std::uint64_t vertex_num;
+  std::uint64_t index_num;
+  std::uint64_t vertex_offset; // in bytes from the start of the file
+  std::uint64_t index_offset;
+  float bounds_center[3];
+  float bounds_radius;
+  float bounds_min[3];
+  float bounds_max[3];
+};
+
+// "MESH" read in the writer's byte order, a cache from a machine with the other order does not match
+static std::uint32_t const MESH_CACHE_MAGIC = 0x4853454d;
+// increase when the layout above or the processing of obj changes
+static std::uint32_t const MESH_CACHE_VERSION = 5;
+
+struct source_info {
+  std::uint64_t size = 0;
+  std::int64_t mtime = 0; // nanoseconds where the platform has them, seconds otherwise
+};
+
+// false if the file does not exist
+static bool stat_source(std::string const& path, source_info& info) {
+  struct stat status;
+  if (stat(path.c_str(), &status) != 0) {
+    return false;
+  }
+  info.size = std::uint64_t(status.st_size);
+#if defined(__linux__)
+  info.mtime = std::int64_t(status.st_mtim.tv_sec) * 1000000000 + std::int64_t(status.st_mtim.tv_nsec);
+#else
+  info.mtime = std::int64_t(status.st_mtime);
+#endif
+  return true;
+}
+
+// 64 bit FNV-1a of the file content
+static std::uint64_t hash_file(std::string const& path) {
+  std::uint64_t hash = 14695981039346656037ull;
+  std::ifstream file(path, std::ios::binary);
+  char buffer[1 << 16];
+  while (file) {
+    file.read(buffer, sizeof(buffer));
+    for (std::streamsize i = 0; i < file.gcount(); ++i) {
+      hash = (hash ^ std::uint64_t(static_cast<unsigned char>(buffer[i]))) * 1099511628211ull;
+    }
+  }
+  return hash;
+}
+
+static std::uint64_t align_16(std::uint64_t offset) {
+  return (offset + 15) / 16 * 16;
+}
+
+static std::size_t index_bytes(GLenum index_type) {
+  return index_type == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(GLuint);
+}
+
+// read only view of the whole file, nullptr if it cannot be opened
+static std::shared_ptr<void const> map_file(std::string const& path, std::size_t& size) {
+#ifndef _WIN32
+  int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    return nullptr;
+  }
+  struct stat status;
+  void* data = MAP_FAILED;
+  if (fstat(file, &status) == 0 && status.st_size > 0) {
+    size = std::size_t(status.st_size);
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+  }
+  close(file); // the mapping stays valid
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  std::size_t mapped_size = size;
+  return std::shared_ptr<void const>(data, [mapped_size](void const* mapped) { munmap(const_cast<void*>(mapped), mapped_size); });
+#else
+  // no mmap, the file is read into memory instead
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    return nullptr;
+  }
+  size = std::size_t(file.tellg());
+  std::shared_ptr<std::vector<char>> content = std::make_shared<std::vector<char>>(size);
+  file.seekg(0);
+  if (size == 0 || !file.read(content->data(), std::streamsize(size))) {
+    return nullptr;
+  }
+  return std::shared_ptr<void const>(content, content->data());
+#endif
+}
+
+// writes the cache into a temporary file which replaces the old cache, readers never see a partial one
+static bool write_cache(std::string const& cache_path, mesh_data const& mesh, source_info const& source, std::uint64_t source_hash,
+                        model::attrib_flag_t import_attribs, bool optimize, bool pack, std::size_t lod_triangle_budget) {
+  mesh_cache_header header;
+  std::memset(&header, 0, sizeof(header));
+  header.magic = MESH_CACHE_MAGIC;
+  header.version = MESH_CACHE_VERSION;
+  header.source_size = source.size;
+  header.source_mtime = source.mtime;
+  header.source_hash = source_hash;
+  header.import_attribs = import_attribs;
+  header.is_optimized = optimize ? 1u : 0u;
+  header.is_packed = pack ? 1u : 0u;
+  header.lod_triangle_budget = lod_triangle_budget;
+  header.lod_error = mesh.lod_error;
+  header.vertex_bytes = std::uint32_t(mesh.vertex_bytes);
+  for (auto const& format : mesh.formats) {
+    header.attributes |= format.flag;
+    auto& entry = header.layout[header.attribute_num++];
+    entry.flag = format.flag;
+    entry.size = format.size;
+    entry.components = format.components;
+    entry.type = std::uint32_t(format.type);
+    entry.normalized = format.normalized == GL_TRUE ? 1u : 0u;
+    entry.offset = std::uint32_t(uintptr_t(format.offset));
+  }
+  header.index_type = std::uint32_t(mesh.index_type);
+  header.vertex_num = mesh.vertex_num;
+  header.index_num = mesh.index_num;
+  header.vertex_offset = align_16(sizeof(header));
+  header.index_offset = align_16(header.vertex_offset + header.vertex_num * header.vertex_bytes);
+  for (int i = 0; i < 3; ++i) {
+    header.bounds_center[i] = mesh.bounds.center[i];
+    header.bounds_min[i] = mesh.bounds.min[i];
+    header.bounds_max[i] = mesh.bounds.max[i];
+  }
+  header.bounds_radius = mesh.bounds.radius;
+
+  std::string temporary_path = cache_path + ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    char const padding[16] = {};
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    file.write(padding, std::streamsize(header.vertex_offset - sizeof(header)));
+    file.write(static_cast<char const*>(mesh.vertices), std::streamsize(header.vertex_num * header.vertex_bytes));
+    file.write(padding, std::streamsize(header.index_offset - header.vertex_offset - header.vertex_num * header.vertex_bytes));
+    file.write(static_cast<char const*>(mesh.indices), std::streamsize(mesh.index_num * index_bytes(mesh.index_type)));
+    if (!file.flush()) {
+      std::remove(temporary_path.c_str());
+      return false;
+    }
+  }
+#ifdef _WIN32
+  std::remove(cache_path.c_str()); // rename does not replace existing files
+#endif
+  if (std::rename(temporary_path.c_str(), cache_path.c_str()) != 0) {
+    std::remove(temporary_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// mesh in a mapped cache file, false if the file is no complete cache of this version
+static bool read_cache(std::shared_ptr<void const> const& mapping, std::size_t size, mesh_data& mesh) {
+  if (size < sizeof(mesh_cache_header)) {
+    return false;
+  }
+  auto const& header = *static_cast<mesh_cache_header const*>(mapping.get());
+  if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION
+      || header.attribute_num > sizeof(header.layout) / sizeof(header.layout[0])
+      || (header.index_type != std::uint32_t(GL_UNSIGNED_INT) && header.index_type != std::uint32_t(GL_UNSIGNED_SHORT))
+      || header.vertex_offset < sizeof(header) || header.vertex_offset % 16 != 0 || header.index_offset % 16 != 0
+      || header.vertex_offset + header.vertex_num * header.vertex_bytes > header.index_offset
+      || header.index_offset + header.index_num * index_bytes(GLenum(header.index_type)) > size) {
+    return false;
+  }
+  unsigned char const* bytes = static_cast<unsigned char const*>(mapping.get());
+  mesh.vertices = bytes + header.vertex_offset;
+  mesh.indices = bytes + header.index_offset;
+  mesh.vertex_num = std::size_t(header.vertex_num);
+  mesh.index_num = std::size_t(header.index_num);
+  mesh.attributes = header.attributes;
+  mesh.vertex_bytes = GLsizei(header.vertex_bytes);
+  mesh.index_type = GLenum(header.index_type);
+  mesh.offsets.clear();
+  mesh.formats.clear();
+  for (std::uint32_t i = 0; i < header.attribute_num; ++i) {
+    auto const& entry = header.layout[i];
+    mesh.offsets[entry.flag] = (GLvoid*)uintptr_t(entry.offset);
+    mesh.formats.emplace_back(entry.flag, entry.size, entry.components, GLenum(entry.type), entry.normalized ? GL_TRUE : GL_FALSE);
+    mesh.formats.back().offset = (GLvoid*)uintptr_t(entry.offset);
+  }
+  mesh.bounds.center = glm::fvec3{header.bounds_center[0], header.bounds_center[1], header.bounds_center[2]};
+  mesh.bounds.radius = header.bounds_radius;
+  mesh.bounds.min = glm::fvec3{header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]};
+  mesh.bounds.max = glm::fvec3{header.bounds_max[0], header.bounds_max[1], header.bounds_max[2]};
+  mesh.lod_error = header.lod_error;
+  mesh.storage = mapping;
+  return true;
+}
+
+// view of a model kept alive by the view
+static mesh_data view_model(model&& parsed) {
+  std::shared_ptr<model> owned = std::make_shared<model>(std::move(parsed));
+  mesh_data mesh;
+  mesh.vertices = owned->data.data();
+  mesh.indices = owned->indices.data();
+  mesh.vertex_num = owned->vertex_num;
+  mesh.index_num = owned->indices.size();
+  for (auto const& offset : owned->offsets) {
+    mesh.attributes |= offset.first;
+  }
+  mesh.offsets = owned->offsets;
+  mesh.formats = vertex_packing::formats(*owned);
+  mesh.vertex_bytes = owned->vertex_bytes;
+  mesh.bounds = owned->bounds;
+  mesh.lod_error = owned->lod_error;
+  mesh.storage = owned;
+  return mesh;
+}
+
+// storage of a packed mesh
+struct packed_mesh {
+  std::vector<unsigned char> vertices;
+  std::vector<std::uint16_t> indices_16;
+  std::vector<GLuint> indices;
+};
+
+// ------------- parallel obj parser -------------
+// Mirrors tinyobj::LoadObj line by line, including its float parsing and its quirks, so shapes are
+// identical. Chunks of lines are parsed independently with indices relative to the chunk, a short
+// sequential pass over the group, object and material lines then forms the shapes, whose vertices
+// are deduplicated per chunk in parallel before the unique ones are merged in order.
+
+// tinyobjloader reads lines into a buffer of this size, a longer line ends the file
+static std::size_t const OBJ_LINE_LIMIT = 8192 - 1;
+// files below are parsed on the calling thread if no task pool is given
+static std::size_t const OBJ_PARALLEL_SIZE = 4 << 20;
+static std::size_t const OBJ_CHUNK_SIZE = 256 << 10;
+// triangle corners deduplicated by one task
+static std::size_t const OBJ_DEDUP_SIZE = 1 << 16;
+
+// vertex_index of tinyobjloader, relative flags mark negative indices counted from the chunk's start
+struct obj_corner {
+  int v, vt, vn;
+  unsigned relative; // 1: v, 2: vt, 4: vn
+};
+
+// line starting a new shape or loading materials, after face_num faces and corner_num corners of its chunk
+struct obj_event {
+  enum kind_t { GROUP, OBJECT, USE_MATERIAL, MATERIAL_LIBRARY } kind;
+  std::size_t face_num;
+  std::size_t corner_num;
+  std::string name;
+};
+
+struct obj_chunk {
+  char const* begin;
+  char const* end;
+  std::vector<float> v, vn, vt;
+  std::vector<obj_corner> corners; // triangulated like tinyobjloader, 3 per triangle
+  std::size_t face_num = 0;
+  std::vector<obj_event> events;
+  bool is_truncated = false; // a line over the limit ended the file
+  bool is_valid = true;      // after fix up, false if an index is out of range
+};
+
+// faces of one shape, ranges of chunk corners in file order
+struct obj_shape {
+  struct range {
+    std::size_t chunk, begin, end;
+  };
+  std::vector<range> ranges;
+  std::size_t corner_num = 0;
+  int material = -1;
+  std::string name;
+};
+
+static inline bool is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static inline bool is_blank(char c) {
+  return c == ' ' || c == '\t';
+}
+
+// strspn(token, " \t") and strcspn(token, " \t\r")
+static inline char const* skip_blanks(char const* token) {
+  while (is_blank(*token)) ++token;
+  return token;
+}
+
+static inline char const* skip_word(char const* token) {
+  while (*token != '\0' && *token != ' ' && *token != '\t' && *token != '\r') ++token;
+  return token;
+}
+
+// pow(10, -n) and pow(5, n) of tinyobjloader's float parser, the same libm results without the calls
+static double power_of_10(int n) {
+  static std::vector<double> const table = [] {
+    std::vector<double> powers(64);
+    for (int i = 0; i < 64; ++i) powers[std::size_t(i)] = std::pow(10.0, -i);
+    return powers;
+  }();
+  return n < 64 ? table[std::size_t(n)] : std::pow(10.0, -n);
+}
+
+static double power_of_5(int n) {
+  static std::vector<double> const table = [] {
+    std::vector<double> powers(129);
+    for (int i = -64; i <= 64; ++i) powers[std::size_t(i + 64)] = std::pow(5.0, i);
+    return powers;
+  }();
+  return n >= -64 && n <= 64 ? table[std::size_t(n + 64)] : std::pow(5.0, n);
+}
+
+// tinyobj's tryParseDouble, same arithmetic in the same order so every float rounds the same
+static bool parse_double(char const* s, char const* s_end, double* result) {
+  if (s >= s_end) {
+    return false;
+  }
+  double mantissa = 0.0;
+  int exponent = 0;
+  char sign = '+';
+  char exp_sign = '+';
+  char const* curr = s;
+  int read = 0;
+  bool end_not_reached = false;
+
+  if (*curr == '+' || *curr == '-') {
+    sign = *curr;
+    curr++;
+  }
+  else if (!is_digit(*curr)) {
+    return false;
+  }
+  while ((end_not_reached = (curr != s_end)) && is_digit(*curr)) {
+    mantissa *= 10;
+    mantissa += static_cast<int>(*curr - 0x30);
+    curr++;
+    read++;
+  }
+  if (read == 0) {
+    return false;
+  }
+  if (end_not_reached) {
+    bool has_exponent = true;
+    if (*curr == '.') {
+      curr++;
+      read = 1;
+      while ((end_not_reached = (curr != s_end)) && is_digit(*curr)) {
+        mantissa += static_cast<int>(*curr - 0x30) * power_of_10(read);
+        read++;
+        curr++;
+      }
+    }
+    else if (*curr != 'e' && *curr != 'E') {
+      has_exponent = false;
+    }
+    if (has_exponent && end_not_reached && (*curr == 'e' || *curr == 'E')) {
+      curr++;
+      if ((end_not_reached = (curr != s_end)) && (*curr == '+' || *curr == '-')) {
+        exp_sign = *curr;
+        curr++;
+      }
+      else if (!is_digit(*curr)) {
+        return false;
+      }
+      read = 0;
+      while ((end_not_reached = (curr != s_end)) && is_digit(*curr)) {
+        exponent *= 10;
+        exponent += static_cast<int>(*curr - 0x30);
+        curr++;
+        read++;
+      }
+      exponent *= (exp_sign == '+' ? 1 : -1);
+      if (read == 0) {
+        return false;
+      }
+    }
+  }
+  *result = (sign == '+' ? 1 : -1) * std::ldexp(mantissa * power_of_5(exponent), exponent);
+  return true;
+}
+
+static inline float parse_float(char const*& token) {
+  token = skip_blanks(token);
+  char const* end = skip_word(token);
+  double value = 0.0;
+  parse_double(token, end, &value);
+  token = end;
+  return static_cast<float>(value);
+}
+
+// atoi, which skips all white space before the number
+static inline int parse_int(char const* token) {
+  while (*token == ' ' || (*token >= '\t' && *token <= '\r')) ++token;
+  bool is_negative = *token == '-';
+  if (*token == '-' || *token == '+') ++token;
+  long long value = 0;
+  while (is_digit(*token) && value < (1ll << 40)) {
+    value = value * 10 + (*token++ - '0');
+  }
+  return int(is_negative ? -value : value);
+}
+
+// tinyobj's fixIndex, negative indices count back from the vertices read so far in this chunk
+static inline int fix_index(int index, std::size_t count, unsigned flag, unsigned& relative) {
+  if (index > 0) return index - 1;
+  if (index == 0) return 0;
+  relative |= flag;
+  return int(count) + index;
+}
+
+// tinyobj's parseTriple: i, i/j/k, i//k, i/j
+static obj_corner parse_corner(char const*& token, obj_chunk const& chunk) {
+  obj_corner corner{-1, -1, -1, 0u};
+  auto skip_index = [&token]() {
+    while (*token != '\0' && *token != '/' && *token != ' ' && *token != '\t' && *token != '\r') ++token;
+  };
+  corner.v = fix_index(parse_int(token), chunk.v.size() / 3, 1u, corner.relative);
+  skip_index();
+  if (token[0] != '/') {
+    return corner;
+  }
+  token++;
+  if (token[0] == '/') {
+    token++;
+    corner.vn = fix_index(parse_int(token), chunk.vn.size() / 3, 4u, corner.relative);
+    skip_index();
+    return corner;
+  }
+  corner.vt = fix_index(parse_int(token), chunk.vt.size() / 2, 2u, corner.relative);
+  skip_index();
+  if (token[0] != '/') {
+    return corner;
+  }
+  token++;
+  corner.vn = fix_index(parse_int(token), chunk.vn.size() / 3, 4u, corner.relative);
+  skip_index();
+  return corner;
+}
+
+// first word after token like sscanf("%s"), empty if there is none
+static std::string scan_word(char const* token) {
+  while (*token == ' ' || (*token >= '\t' && *token <= '\r')) ++token;
+  char const* end = token;
+  while (*end != '\0' && *end != ' ' && !(*end >= '\t' && *end <= '\r')) ++end;
+  return std::string(token, end);
+}
+
+// one line without line break, null terminated
+static void parse_line(char const* token, obj_chunk& chunk, std::vector<obj_corner>& face) {
+  token = skip_blanks(token);
+  if (token[0] == '\0' || token[0] == '#') {
+    return;
+  }
+  if (token[0] == 'v' && is_blank(token[1])) {
+    token += 2;
+    for (int i = 0; i < 3; ++i) chunk.v.push_back(parse_float(token));
+    return;
+  }
+  if (token[0] == 'v' && token[1] == 'n' && is_blank(token[2])) {
+    token += 3;
+    for (int i = 0; i < 3; ++i) chunk.vn.push_back(parse_float(token));
+    return;
+  }
+  if (token[0] == 'v' && token[1] == 't' && is_blank(token[2])) {
+    token += 3;
+    for (int i = 0; i < 2; ++i) chunk.vt.push_back(parse_float(token));
+    return;
+  }
+  if (token[0] == 'f' && is_blank(token[1])) {
+    token = skip_blanks(token + 2);
+    face.clear();
+    while (token[0] != '\0' && token[0] != '\r' && token[0] != '\n') {
+      face.push_back(parse_corner(token, chunk));
+      while (*token == ' ' || *token == '\t' || *token == '\r') ++token;
+    }
+    // polygon to triangle fan
+    for (std::size_t k = 2; k < face.size(); ++k) {
+      chunk.corners.push_back(face[0]);
+      chunk.corners.push_back(face[k - 1]);
+      chunk.corners.push_back(face[k]);
+    }
+    ++chunk.face_num;
+    return;
+  }
+  obj_event event{obj_event::GROUP, chunk.face_num, chunk.corners.size(), std::string{}};
+  if (std::strncmp(token, "usemtl", 6) == 0 && is_blank(token[6])) {
+    event.kind = obj_event::USE_MATERIAL;
+    event.name = scan_word(token + 7);
+  }
+  else if (std::strncmp(token, "mtllib", 6) == 0 && is_blank(token[6])) {
+    event.kind = obj_event::MATERIAL_LIBRARY;
+    event.name = scan_word(token + 7);
+  }
+  else if (token[0] == 'g' && is_blank(token[1])) {
+    // the second word is the name, the first one is the g
+    event.kind = obj_event::GROUP;
+    token = skip_word(skip_blanks(token));
+    token += std::strspn(token, " \t\r");
+    if (token[0] != '\0' && token[0] != '\n') {
+      token = skip_blanks(token);
+      event.name = std::string(token, skip_word(token));
+    }
+  }
+  else if (token[0] == 'o' && is_blank(token[1])) {
+    event.kind = obj_event::OBJECT;
+    event.name = scan_word(token + 2);
+  }
+  else {
+    return; // unknown command
+  }
+  chunk.events.push_back(event);
+}
+
+static void parse_chunk(obj_chunk& chunk) {
+  std::vector<char> line;
+  std::vector<obj_corner> face;
+  char const* next = chunk.begin;
+  while (next < chunk.end) {
+    char const* line_end = static_cast<char const*>(std::memchr(next, '\n', std::size_t(chunk.end - next)));
+    if (!line_end) line_end = chunk.end;
+    std::size_t length = std::size_t(line_end - next);
+    bool is_truncated = length > OBJ_LINE_LIMIT;
+    if (is_truncated) {
+      length = OBJ_LINE_LIMIT;
+    }
+    if (length > 0 && next[length - 1] == '\r') {
+      --length;
+    }
+    line.assign(next, next + length);
+    line.push_back('\0');
+    parse_line(line.data(), chunk, face);
+    if (is_truncated) {
+      chunk.is_truncated = true;
+      return;
+    }
+    next = line_end + 1;
+  }
+}
+
+// runs function(0 .. count - 1) on the pool, or on the calling thread without one
+template<typename Function>
+static void for_each_task(TaskPool* task_pool, std::size_t count, Function const& function) {
+  if (!task_pool || count < 2) {
+    for (std::size_t i = 0; i < count; ++i) function(i);
+    return;
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    task_pool->push([&function, i]() { function(i); });
+  }
+  task_pool->wait();
+}
+
+// open addressing table of corners, ids are given in order of insertion
+class corner_table {
+ public:
+  explicit corner_table(std::size_t capacity) {
+    std::size_t size = 16;
+    while (size < capacity * 2) size *= 2;
+    _slots.assign(size, slot{obj_corner{0, 0, 0, 0u}, EMPTY});
+  }
+  // id of the corner, inserted is set if it is new
+  std::uint32_t find_or_insert(obj_corner const& corner, std::uint32_t new_id, bool& inserted) {
+    std::size_t mask = _slots.size() - 1;
+    std::uint64_t hash = (std::uint64_t(std::uint32_t(corner.v)) * 0x9E3779B97F4A7C15ull)
+                         ^ (std::uint64_t(std::uint32_t(corner.vt)) * 0xC2B2AE3D27D4EB4Full)
+                         ^ (std::uint64_t(std::uint32_t(corner.vn)) * 0x165667B19E3779F9ull);
+    for (std::size_t index = std::size_t(hash >> 20) & mask;; index = (index + 1) & mask) {
+      slot& each = _slots[index];
+      if (each.id == EMPTY) {
+        each = slot{corner, new_id};
+        inserted = true;
+        return new_id;
+      }
+      if (each.corner.v == corner.v && each.corner.vt == corner.vt && each.corner.vn == corner.vn) {
+        inserted = false;
+        return each.id;
+      }
+    }
+  }
+
+ private:
+  static std::uint32_t const EMPTY = 0xffffffffu;
+  struct slot {
+    obj_corner corner;
+    std::uint32_t id;
+  };
+  std::vector<slot> _slots;
+};
+
+// tinyobj's exportFaceGroupToShape: vertices are unique per shape, in order of first use
+static void build_shape(obj_shape const& faces, std::vector<obj_chunk> const& chunks, std::vector<float> const& v,
+                        std::vector<float> const& vn, std::vector<float> const& vt, tinyobj::shape_t& shape, TaskPool* task_pool) {
+  // pieces of at most OBJ_DEDUP_SIZE corners, each deduplicated on its own
+  struct piece {
+    obj_corner const* corners;
+    std::size_t size, offset;
+    std::vector<obj_corner> unique;
+    std::vector<std::uint32_t> local_ids;
+  };
+  std::vector<piece> pieces;
+  std::size_t offset = 0;
+  for (auto const& range : faces.ranges) {
+    for (std::size_t begin = range.begin; begin < range.end; begin += OBJ_DEDUP_SIZE) {
+      std::size_t size = std::min(OBJ_DEDUP_SIZE, range.end - begin);
+      pieces.push_back(piece{chunks[range.chunk].corners.data() + begin, size, offset, {}, {}});
+      offset += size;
+    }
+  }
+  for_each_task(task_pool, pieces.size(), [&pieces](std::size_t i) {
+    piece& each = pieces[i];
+    corner_table table{each.size};
+    each.local_ids.resize(each.size);
+    for (std::size_t c = 0; c < each.size; ++c) {
+      bool inserted = false;
+      each.local_ids[c] = table.find_or_insert(each.corners[c], std::uint32_t(each.unique.size()), inserted);
+      if (inserted) each.unique.push_back(each.corners[c]);
+    }
+  });
+
+  std::size_t unique_num = 0;
+  for (auto const& each : pieces) unique_num += each.unique.size();
+  corner_table table{unique_num};
+  std::vector<std::vector<std::uint32_t>> global_ids(pieces.size());
+  tinyobj::mesh_t& mesh = shape.mesh;
+  for (std::size_t i = 0; i < pieces.size(); ++i) {
+    global_ids[i].resize(pieces[i].unique.size());
+    for (std::size_t u = 0; u < pieces[i].unique.size(); ++u) {
+      obj_corner const& corner = pieces[i].unique[u];
+      bool inserted = false;
+      global_ids[i][u] = table.find_or_insert(corner, std::uint32_t(mesh.positions.size() / 3), inserted);
+      if (!inserted) continue;
+      mesh.positions.insert(mesh.positions.end(), v.begin() + 3 * corner.v, v.begin() + 3 * corner.v + 3);
+      if (corner.vn >= 0) mesh.normals.insert(mesh.normals.end(), vn.begin() + 3 * corner.vn, vn.begin() + 3 * corner.vn + 3);
+      if (corner.vt >= 0) mesh.texcoords.insert(mesh.texcoords.end(), vt.begin() + 2 * corner.vt, vt.begin() + 2 * corner.vt + 2);
+    }
+  }
+  mesh.indices.resize(faces.corner_num);
+  for_each_task(task_pool, pieces.size(), [&](std::size_t i) {
+    piece const& each = pieces[i];
+    for (std::size_t c = 0; c < each.size; ++c) {
+      mesh.indices[each.offset + c] = global_ids[i][each.local_ids[c]];
+    }
+  });
+  mesh.material_ids.assign(faces.corner_num / 3, faces.material);
+  shape.name = faces.name;
+}
+
+std::string parse_obj(std::vector<tinyobj::shape_t>& shapes, std::vector<tinyobj::material_t>& materials, std::string const& path, TaskPool* task_pool) {
+  PROFILE_SCOPE("Parse obj");
+  shapes.clear();
+  std::size_t size = 0;
+  std::shared_ptr<void const> mapping = map_file(path, size);
+  if (!mapping) {
+    if (std::ifstream(path)) {
+      return ""; // empty file
+    }
+    return "Cannot open file [" + path + "]\n";
+  }
+  std::unique_ptr<TaskPool> own_pool;
+  if (!task_pool && size >= OBJ_PARALLEL_SIZE) {
+    own_pool.reset(new TaskPool{});
+    task_pool = own_pool.get();
+  }
+
+  // 1. chunks end at line breaks, every one is parsed on its own
+  char const* data = static_cast<char const*>(mapping.get());
+  std::size_t chunk_num = 1;
+  if (task_pool && task_pool->getThreadCount() > 1) {
+    chunk_num = std::max(std::size_t(1), std::min(std::size_t(task_pool->getThreadCount()) * 4, size / OBJ_CHUNK_SIZE));
+  }
+  std::vector<obj_chunk> chunks(chunk_num);
+  char const* begin = data;
+  for (std::size_t i = 0; i < chunk_num; ++i) {
+    char const* end = i + 1 == chunk_num ? data + size : data + size * (i + 1) / chunk_num;
+    if (end < begin) end = begin;
+    char const* line_end = end < data + size ? static_cast<char const*>(std::memchr(end, '\n', std::size_t(data + size - end))) : nullptr;
+    end = line_end ? line_end + 1 : data + size;
+    chunks[i].begin = begin;
+    chunks[i].end = end;
+    begin = end;
+  }
+  for_each_task(task_pool, chunks.size(), [&chunks](std::size_t i) { parse_chunk(chunks[i]); });
+
+  // a line over the limit ends the file, later chunks are dropped
+  for (std::size_t i = 0; i < chunks.size(); ++i) {
+    if (chunks[i].is_truncated) {
+      chunks.resize(i + 1);
+      break;
+    }
+  }
+
+  // 2. attributes of all chunks in one array each, indices of the chunks' faces made absolute
+  std::vector<std::size_t> v_offsets(chunks.size() + 1, 0), vn_offsets(chunks.size() + 1, 0), vt_offsets(chunks.size() + 1, 0);
+  for (std::size_t i = 0; i < chunks.size(); ++i) {
+    v_offsets[i + 1] = v_offsets[i] + chunks[i].v.size();
+    vn_offsets[i + 1] = vn_offsets[i] + chunks[i].vn.size();
+    vt_offsets[i + 1] = vt_offsets[i] + chunks[i].vt.size();
+  }
+  std::vector<float> v(v_offsets.back()), vn(vn_offsets.back()), vt(vt_offsets.back());
+  for_each_task(task_pool, chunks.size(), [&](std::size_t i) {
+    obj_chunk& chunk = chunks[i];
+    std::copy(chunk.v.begin(), chunk.v.end(), v.begin() + std::ptrdiff_t(v_offsets[i]));
+    std::copy(chunk.vn.begin(), chunk.vn.end(), vn.begin() + std::ptrdiff_t(vn_offsets[i]));
+    std::copy(chunk.vt.begin(), chunk.vt.end(), vt.begin() + std::ptrdiff_t(vt_offsets[i]));
+    int v_base = int(v_offsets[i] / 3), vn_base = int(vn_offsets[i] / 3), vt_base = int(vt_offsets[i] / 2);
+    int v_num = int(v.size() / 3), vn_num = int(vn.size() / 3), vt_num = int(vt.size() / 2);
+    for (auto& corner : chunk.corners) {
+      if (corner.relative & 1u) corner.v += v_base;
+      if (corner.relative & 2u) corner.vt += vt_base;
+      if (corner.relative & 4u) corner.vn += vn_base;
+      // tinyobjloader reads out of bounds here
+      chunk.is_valid = chunk.is_valid && corner.v >= 0 && corner.v < v_num && corner.vt < vt_num && corner.vn < vn_num;
+    }
+  });
+
+  // 3. shapes like tinyobjloader forms them, which ends a shape at each group, object and material line
+  std::vector<obj_shape> shape_faces;
+  std::map<std::string, int> material_map;
+  tinyobj::MaterialFileReader material_reader{""};
+  obj_shape current;
+  std::size_t current_faces = 0;
+  auto add_faces = [&current, &current_faces](std::size_t chunk, std::size_t face_begin, std::size_t face_end, std::size_t begin, std::size_t end) {
+    current_faces += face_end - face_begin;
+    if (begin < end) {
+      current.ranges.push_back(obj_shape::range{chunk, begin, end});
+      current.corner_num += end - begin;
+    }
+  };
+  auto export_shape = [&]() {
+    if (current_faces > 0) {
+      shape_faces.push_back(current);
+    }
+    current.ranges.clear();
+    current.corner_num = 0;
+    current_faces = 0;
+  };
+  std::string error;
+  for (std::size_t i = 0; i < chunks.size() && error.empty(); ++i) {
+    obj_chunk const& chunk = chunks[i];
+    if (!chunk.is_valid) {
+      error = "Face index out of range in [" + path + "]\n";
+      break;
+    }
+    std::size_t face = 0, corner = 0;
+    for (auto const& event : chunk.events) {
+      add_faces(i, face, event.face_num, corner, event.corner_num);
+      face = event.face_num;
+      corner = event.corner_num;
+      if (event.kind == obj_event::MATERIAL_LIBRARY) {
+        error = material_reader(event.name, materials, material_map);
+        if (!error.empty()) break; // tinyobjloader returns without the open shape
+        continue;
+      }
+      // the shape ends with the name and material it had before this line
+      export_shape();
+      if (event.kind == obj_event::USE_MATERIAL) {
+        auto found = material_map.find(event.name);
+        current.material = found != material_map.end() ? found->second : -1;
+      }
+      else {
+        current.name = event.name;
+      }
+    }
+    if (error.empty()) {
+      add_faces(i, face, chunk.face_num, corner, chunk.corners.size());
+    }
+  }
+  if (error.empty()) {
+    export_shape();
+  }
+  if (!error.empty() && error.compare(0, 3, "WAR") != 0) {
+    return error;
+  }
+
+  // 4. vertices of each shape
+  shapes.resize(shape_faces.size());
+  for (std::size_t i = 0; i < shape_faces.size(); ++i) {
+    build_shape(shape_faces[i], chunks, v, vn, vt, shapes[i], task_pool);
+  }
+  return error;
+}
+
+model obj(std::string const& name, model::attrib_flag_t import_attribs, bool optimize){
+  PROFILE_SCOPE("Load model");
   std::vector<tinyobj::shape_t> shapes;
   std::vector<tinyobj::material_t> materials;
 
-  std::string err = tinyobj::LoadObj(shapes, materials, name.c_str());
+  std::string err = parse_obj(shapes, materials, name);
 
   if (!err.empty()) {
     if (err[0] == 'W' && err[1] == 'A' && err[2] == 'R') {
@@ -31,6 +861,14 @@ model obj(std::string const& name, model::attrib_flag_t import_attribs){
 
   std::vector<float> vertex_data;
   std::vector<unsigned> triangles;
+  std::size_t position_num = 0, index_num = 0;
+  for (auto const& shape : shapes) {
+    position_num += shape.mesh.positions.size() / 3;
+    index_num += shape.mesh.indices.size();
+  }
+  // at most position, normal, texcoord and tangent per vertex
+  vertex_data.reserve(position_num * 11);
+  triangles.reserve(index_num);
 
   unsigned vertex_offset = 0;
 
@@ -49,7 +887,7 @@ model obj(std::string const& name, model::attrib_flag_t import_attribs){
     if(has_uvs) {
       if (curr_mesh.texcoords.empty()) {
         has_uvs = false;
-        attributes ^= model::TEXCOORD;
+        attributes &= ~model::TEXCOORD; // cleared, not toggled, as later shapes may lack them too
         std::cerr << "Shape has no texcoords" << std::endl;
       }
     }
@@ -59,7 +897,7 @@ model obj(std::string const& name, model::attrib_flag_t import_attribs){
     if (has_tangents) {
       if (!has_uvs) {
         has_tangents = false;
-        attributes ^= model::TANGENT;
+        attributes &= ~model::TANGENT;
         std::cerr << "Shape has no texcoords" << std::endl;
       }
       else {
@@ -99,7 +937,231 @@ model obj(std::string const& name, model::attrib_flag_t import_attribs){
     vertex_offset += unsigned(curr_mesh.positions.size() / 3);
   }
 
-  return model{vertex_data, attributes, triangles};
+  model result{vertex_data, attributes, triangles};
+  if (optimize) {
+    mesh_optimizer::optimize(result);
+  }
+  result.bounds = bounds(result.data, result.data.size() / std::max(result.vertex_num, std::size_t(1)));
+  return result;
+}
+
+mesh_data pack(model const& mesh) {
+  PROFILE_SCOPE("Pack mesh");
+  std::vector<model::attribute> sources = vertex_packing::formats(mesh);
+  std::size_t stride = std::size_t(mesh.vertex_bytes) / sizeof(GLfloat);
+  auto source_offset = [&mesh](model::attribute const& attribute) {
+    auto offset = mesh.offsets.find(attribute);
+    return offset == mesh.offsets.end() ? std::size_t(0) : std::size_t(uintptr_t(offset->second) / sizeof(GLfloat));
+  };
+  bool is_unit_range = true;
+  if (mesh.offsets.count(model::TEXCOORD) != 0) {
+    std::size_t texcoord = source_offset(model::TEXCOORD);
+    for (std::size_t i = texcoord; i + 1 < mesh.data.size(); i += stride) {
+      is_unit_range = is_unit_range && mesh.data[i] >= 0.0f && mesh.data[i] <= 1.0f && mesh.data[i + 1] >= 0.0f && mesh.data[i + 1] <= 1.0f;
+    }
+  }
+
+  mesh_data packed;
+  for (auto const& source : sources) {
+    model::attribute format = source;
+    if (source.flag == model::NORMAL.flag) {
+      format = model::NORMAL_OCTAHEDRAL;
+    }
+    else if (source.flag == model::TEXCOORD.flag) {
+      format = is_unit_range ? model::TEXCOORD_UNORM16 : model::TEXCOORD_HALF;
+    }
+    else if (source.flag == model::TANGENT.flag) {
+      format = model::TANGENT_PACKED;
+    }
+    else if (source.flag == model::BITANGENT.flag) {
+      format = model::BITANGENT_PACKED;
+    }
+    format.offset = (GLvoid*)uintptr_t(packed.vertex_bytes);
+    packed.vertex_bytes += format.size * format.components;
+    packed.offsets.insert(std::pair<model::attrib_flag_t, GLvoid*>{format.flag, format.offset});
+    packed.attributes |= format.flag;
+    packed.formats.push_back(format);
+  }
+
+  std::shared_ptr<packed_mesh> owned = std::make_shared<packed_mesh>();
+  owned->vertices.resize(mesh.vertex_num * std::size_t(packed.vertex_bytes));
+  for (std::size_t vertex = 0; vertex < mesh.vertex_num; ++vertex) {
+    GLfloat const* source_vertex = mesh.data.data() + vertex * stride;
+    unsigned char* target = owned->vertices.data() + vertex * std::size_t(packed.vertex_bytes);
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+      model::attribute const& format = packed.formats[i];
+      unsigned char* destination = target + uintptr_t(format.offset);
+      glm::fvec4 value = vertex_packing::read(source_vertex, sources[i]);
+      if (format.type == GL_FLOAT) {
+        std::memcpy(destination, &value[0], sizeof(GLfloat) * std::size_t(format.components));
+      }
+      else if (format.flag == model::NORMAL.flag) {
+        glm::i16vec2 encoded = vertex_packing::octahedral(glm::fvec3{value.x, value.y, value.z});
+        std::memcpy(destination, &encoded[0], sizeof(encoded));
+      }
+      else if (format.flag == model::TEXCOORD.flag) {
+        std::uint16_t encoded[2];
+        for (int c = 0; c < 2; ++c) {
+          encoded[c] = is_unit_range ? vertex_packing::unorm16(value[c]) : vertex_packing::half_float(value[c]);
+        }
+        std::memcpy(destination, encoded, sizeof(encoded));
+      }
+      else {
+        if (format.flag == model::TANGENT.flag) {
+          // bitangent = cross(normal, tangent) * w
+          value.w = 1.0f;
+          if (mesh.offsets.count(model::NORMAL) != 0 && mesh.offsets.count(model::BITANGENT) != 0) {
+            GLfloat const* normal = source_vertex + source_offset(model::NORMAL);
+            GLfloat const* bitangent = source_vertex + source_offset(model::BITANGENT);
+            glm::fvec3 frame = glm::cross(glm::fvec3{normal[0], normal[1], normal[2]}, glm::fvec3{value.x, value.y, value.z});
+            value.w = glm::dot(frame, glm::fvec3{bitangent[0], bitangent[1], bitangent[2]}) < 0.0f ? -1.0f : 1.0f;
+          }
+        }
+        std::uint32_t encoded = vertex_packing::snorm_10_10_10_2(value);
+        std::memcpy(destination, &encoded, sizeof(encoded));
+      }
+    }
+  }
+  // indices are mesh relative, so 16 bits are enough for up to 65536 vertices
+  if (mesh.vertex_num <= 65536) {
+    owned->indices_16.assign(mesh.indices.begin(), mesh.indices.end());
+    packed.indices = owned->indices_16.data();
+    packed.index_type = GL_UNSIGNED_SHORT;
+  }
+  else {
+    owned->indices = mesh.indices;
+    packed.indices = owned->indices.data();
+  }
+  packed.vertices = owned->vertices.data();
+  packed.vertex_num = mesh.vertex_num;
+  packed.index_num = mesh.indices.size();
+  packed.bounds = mesh.bounds;
+  packed.lod_error = mesh.lod_error;
+  packed.storage = owned;
+  return packed;
+}
+
+// mesh of the source at path through the cache at cache_path, see cached_obj. build returns the model to cache,
+// the mesh itself or one of its levels of detail, packed if requested
+template<typename Build>
+static mesh_data through_cache(std::string const& path, std::string const& cache_path, model::attrib_flag_t import_attribs,
+                               bool optimize, bool packed, std::size_t lod_triangle_budget, Build const& build) {
+  source_info source;
+  if (!stat_source(path, source)) {
+    model parsed = build(); // reports the missing file
+    return packed ? pack(parsed) : view_model(std::move(parsed));
+  }
+  {
+    PROFILE_SCOPE("Map mesh cache");
+    std::size_t size = 0;
+    std::shared_ptr<void const> mapping = map_file(cache_path, size);
+    mesh_data mesh;
+    if (mapping && read_cache(mapping, size, mesh)) {
+      auto const& header = *static_cast<mesh_cache_header const*>(mapping.get());
+      if (header.import_attribs == import_attribs && header.is_optimized == (optimize ? 1u : 0u) && header.is_packed == (packed ? 1u : 0u)
+          && header.lod_triangle_budget == lod_triangle_budget && header.source_size == source.size) {
+        if (header.source_mtime == source.mtime) {
+          return mesh;
+        }
+        // touched but maybe unchanged, e.g. by a checkout, the content decides and the new time is stored
+        if (header.source_hash == hash_file(path)) {
+          std::fstream file(cache_path, std::ios::binary | std::ios::in | std::ios::out);
+          file.seekp(std::streamoff(offsetof(mesh_cache_header, source_mtime)));
+          file.write(reinterpret_cast<char const*>(&source.mtime), sizeof(source.mtime));
+          return mesh;
+        }
+      }
+    }
+  }
+  model parsed = build();
+  mesh_data built = packed ? pack(parsed) : view_model(std::move(parsed));
+  if (write_cache(cache_path, built, source, hash_file(path), import_attribs, optimize, packed, lod_triangle_budget)) {
+    std::size_t size = 0;
+    std::shared_ptr<void const> mapping = map_file(cache_path, size);
+    mesh_data mesh;
+    if (mapping && read_cache(mapping, size, mesh)) {
+      return mesh;
+    }
+  }
+  std::cerr << "Could not write mesh cache " << cache_path << std::endl;
+  return built;
+}
+
+mesh_data cached_obj(std::string const& path, model::attrib_flag_t import_attribs, bool optimize, bool packed) {
+  return through_cache(path, path + ".mesh", import_attribs, optimize, packed, 0, [&] { return obj(path, import_attribs, optimize); });
+}
+
+// budgets below the triangle count of the mesh, largest first
+static std::vector<std::size_t> lod_budgets(std::vector<std::size_t> triangle_budgets, std::size_t triangle_num) {
+  std::sort(triangle_budgets.begin(), triangle_budgets.end(), std::greater<std::size_t>());
+  triangle_budgets.erase(std::unique(triangle_budgets.begin(), triangle_budgets.end()), triangle_budgets.end());
+  triangle_budgets.erase(std::remove_if(triangle_budgets.begin(), triangle_budgets.end(),
+                         [triangle_num](std::size_t budget) { return budget >= triangle_num; }), triangle_budgets.end());
+  return triangle_budgets;
+}
+
+// level of detail of mesh with at most triangle_budget triangles where the simplification allows
+static model simplified(model const& mesh, std::size_t triangle_budget) {
+  model level = mesh;
+  level.lod_error = mesh_optimizer::simplify(level, triangle_budget);
+  // the remaining vertices are a subset of the mesh's, its bounds still hold and are the same for all levels
+  level.bounds = mesh.bounds;
+  return level;
+}
+
+std::vector<model> lod_chain(model const& mesh, std::vector<std::size_t> const& triangle_budgets) {
+  PROFILE_SCOPE("Build LOD chain");
+  std::vector<model> levels{mesh};
+  for (std::size_t budget : lod_budgets(triangle_budgets, mesh.indices.size() / 3)) {
+    model level = simplified(mesh, budget);
+    // a simplification which got stuck above the previous level adds nothing
+    if (level.indices.size() < levels.back().indices.size() && std::isfinite(level.lod_error)) {
+      levels.push_back(std::move(level));
+    }
+  }
+  return levels;
+}
+
+std::vector<mesh_data> cached_lod_chain(std::string const& path, model::attrib_flag_t import_attribs,
+                                        std::vector<std::size_t> const& triangle_budgets, bool packed) {
+  std::vector<mesh_data> levels{cached_obj(path, import_attribs, true, packed)};
+  // parsed once if any level has to be rebuilt
+  std::unique_ptr<model> parsed;
+  for (std::size_t budget : lod_budgets(triangle_budgets, levels.front().index_num / 3)) {
+    mesh_data level = through_cache(path, path + ".lod" + std::to_string(budget) + ".mesh", import_attribs, true, packed, budget, [&] {
+      if (!parsed) {
+        parsed.reset(new model{obj(path, import_attribs, true)});
+      }
+      return simplified(*parsed, budget);
+    });
+    if (level.index_num < levels.back().index_num && std::isfinite(level.lod_error)) {
+      levels.push_back(level);
+    }
+  }
+  return levels;
+}
+
+bounding_volume bounds(std::vector<float> const& vertex_data, std::size_t stride) {
+  bounding_volume volume;
+  if (vertex_data.size() < 3 || stride < 3) {
+    return volume;
+  }
+  volume.min = glm::fvec3{vertex_data[0], vertex_data[1], vertex_data[2]};
+  volume.max = volume.min;
+  for (std::size_t i = stride; i + 2 < vertex_data.size(); i += stride) {
+    glm::fvec3 position{vertex_data[i], vertex_data[i + 1], vertex_data[i + 2]};
+    volume.min = glm::min(volume.min, position);
+    volume.max = glm::max(volume.max, position);
+  }
+  // sphere around the box center, a little larger than the minimal one but found in one more pass
+  volume.center = (volume.min + volume.max) * 0.5f;
+  float radius_squared = 0.0f;
+  for (std::size_t i = 0; i + 2 < vertex_data.size(); i += stride) {
+    glm::fvec3 offset = glm::fvec3{vertex_data[i], vertex_data[i + 1], vertex_data[i + 2]} - volume.center;
+    radius_squared = std::max(radius_squared, glm::dot(offset, offset));
+  }
+  volume.radius = std::sqrt(radius_squared);
+  return volume;
 }
 
 void generate_normals(tinyobj::mesh_t& model) {
@@ -0,0 +1,491 @@
+#include "simd_math.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+
+#include <cstddef>
+
+// x86-64 always provides SSE2, AVX kernels are compiled for AVX and only called after runtime detection
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+  #define SIMD_MATH_X86
+  #include <immintrin.h>
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+    #define SIMD_MATH_AVX_TARGET
+  #else
+    #define SIMD_MATH_AVX_TARGET __attribute__((target("avx")))
+  #endif
+#endif
+
+namespace simd_math {
+
+///////////////////////////// scalar kernels //////////////////////////////////
+namespace scalar {
+  // columns hold the rows of the inverse upper 3x3 part, w holds -dot(row, translation)
+  // this is the normal matrix, transposed it is the affine inverse
+  static glm::fmat4 inverse_rows(glm::fmat4 const& m) {
+    glm::fvec3 c0{m[0]};
+    glm::fvec3 c1{m[1]};
+    glm::fvec3 c2{m[2]};
+    glm::fvec3 t{m[3]};
+    glm::fvec3 r0 = glm::cross(c1, c2);
+    glm::fvec3 r1 = glm::cross(c2, c0);
+    glm::fvec3 r2 = glm::cross(c0, c1);
+    glm::fvec3 inv_det{1.0f / glm::dot(c0, r0)};
+    r0 *= inv_det;
+    r1 *= inv_det;
+    r2 *= inv_det;
+    return glm::fmat4{glm::fvec4{r0, -glm::dot(r0, t)},
+                      glm::fvec4{r1, -glm::dot(r1, t)},
+                      glm::fvec4{r2, -glm::dot(r2, t)},
+                      glm::fvec4{0.0f, 0.0f, 0.0f, 1.0f}};
+  }
+
+  static void multiply(glm::fmat4 const* lhs, glm::fmat4 const* rhs, glm::fmat4* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      out[i] = lhs[i] * rhs[i];
+    }
+  }
+
+  static void multiply(glm::fmat4 const& lhs, glm::fmat4 const* rhs, glm::fmat4* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      out[i] = lhs * rhs[i];
+    }
+  }
+
+  static void multiply_hierarchy(glm::fmat4 const* locals, int const* parents, unsigned char* dirty, glm::fmat4* worlds, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      int parent = parents[i];
+      if (parent < 0) {
+        if (dirty[i]) { worlds[i] = locals[i]; }
+      }
+      else if (dirty[i] || dirty[parent]) {
+        worlds[i] = worlds[parent] * locals[i];
+        dirty[i] = 1;
+      }
+    }
+  }
+
+  static void affine_inverse(glm::fmat4 const* in, glm::fmat4* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      out[i] = glm::transpose(inverse_rows(in[i]));
+    }
+  }
+
+  static void normal_matrix(glm::fmat4 const& view, glm::fmat4 const* models, glm::fmat4* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      out[i] = inverse_rows(view * models[i]);
+    }
+  }
+
+  static void cull_spheres(glm::fvec4 const* planes, float const* x, float const* y, float const* z, float const* radius,
+                           unsigned char* visible, std::size_t count, std::size_t& visible_count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      bool is_inside = true;
+      for (int p = 0; p < 6; ++p) {
+        float distance = planes[p].x * x[i] + planes[p].y * y[i] + planes[p].z * z[i] + planes[p].w;
+        is_inside = is_inside && distance >= -radius[i];
+      }
+      visible[i] = is_inside ? 1 : 0;
+      visible_count += is_inside ? 1 : 0;
+    }
+  }
+}
+
+#ifdef SIMD_MATH_X86
+///////////////////////////// sse kernels /////////////////////////////////////
+namespace sse {
+  static inline __m128 load(glm::fmat4 const& m, int column) {
+    return _mm_loadu_ps(&m[column][0]);
+  }
+
+  // same summation order as glm, so results match the scalar path
+  static inline void multiply(glm::fmat4 const& a, glm::fmat4 const& b, glm::fmat4& out) {
+    __m128 a0 = load(a, 0);
+    __m128 a1 = load(a, 1);
+    __m128 a2 = load(a, 2);
+    __m128 a3 = load(a, 3);
+    for (int j = 0; j < 4; ++j) {
+      __m128 bj = load(b, j);
+      __m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(bj, bj, 0x00));
+      r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(bj, bj, 0x55)));
+      r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(bj, bj, 0xAA)));
+      r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(bj, bj, 0xFF)));
+      _mm_storeu_ps(&out[j][0], r);
+    }
+  }
+
+  static inline __m128 cross(__m128 a, __m128 b) {
+    __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+    return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+  }
+
+  // dot product of all four lanes, broadcast to every lane
+  static inline __m128 dot(__m128 a, __m128 b) {
+    __m128 p = _mm_mul_ps(a, b);
+    __m128 s = _mm_add_ps(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+  }
+
+  // see scalar::inverse_rows
+  static inline void inverse_rows(glm::fmat4 const& m, __m128& r0, __m128& r1, __m128& r2) {
+    __m128 xyz_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    __m128 w_mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+    __m128 c0 = _mm_and_ps(load(m, 0), xyz_mask);
+    __m128 c1 = _mm_and_ps(load(m, 1), xyz_mask);
+    __m128 c2 = _mm_and_ps(load(m, 2), xyz_mask);
+    __m128 t = load(m, 3);
+    r0 = cross(c1, c2);
+    r1 = cross(c2, c0);
+    r2 = cross(c0, c1);
+    __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), dot(c0, r0));
+    r0 = _mm_mul_ps(r0, inv_det);
+    r1 = _mm_mul_ps(r1, inv_det);
+    r2 = _mm_mul_ps(r2, inv_det);
+    // w lanes are zero, so adding the masked translation term sets them
+    __m128 zero = _mm_setzero_ps();
+    r0 = _mm_add_ps(r0, _mm_and_ps(w_mask, _mm_sub_ps(zero, dot(r0, t))));
+    r1 = _mm_add_ps(r1, _mm_and_ps(w_mask, _mm_sub_ps(zero, dot(r1, t))));
+    r2 = _mm_add_ps(r2, _mm_and_ps(w_mask, _mm_sub_ps(zero, dot(r2, t))));
+  }
+
+  static inline void affine_inverse(glm::fmat4 const& m, glm::fmat4& out) {
+    __m128 r0, r1, r2;
+    inverse_rows(m, r0, r1, r2);
+    __m128 r3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(&out[0][0], r0);
+    _mm_storeu_ps(&out[1][0], r1);
+    _mm_storeu_ps(&out[2][0], r2);
+    _mm_storeu_ps(&out[3][0], r3);
+  }
+
+  static inline void normal_matrix(glm::fmat4 const& m, glm::fmat4& out) {
+    __m128 r0, r1, r2;
+    inverse_rows(m, r0, r1, r2);
+    _mm_storeu_ps(&out[0][0], r0);
+    _mm_storeu_ps(&out[1][0], r1);
+    _mm_storeu_ps(&out[2][0], r2);
+    _mm_storeu_ps(&out[3][0], _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f));
+  }
+
+  static void multiply(glm::fmat4 const* lhs, glm::fmat4 const* rhs, glm::fmat4* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      multiply(lhs[i], rhs[i], out[i]);
+    }
+  }
+
+  static void multiply(glm::fmat4 const& lhs, glm::fmat4 const* rhs, glm::fmat4* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      multiply(lhs, rhs[i], out[i]);
+    }
+  }
+
+  static void multiply_hierarchy(glm::fmat4 const* locals, int const* parents, unsigned char* dirty, glm::fmat4* worlds, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      int parent = parents[i];
+      if (parent < 0) {
+        if (dirty[i]) { worlds[i] = locals[i]; }
+      }
+      else if (dirty[i] || dirty[parent]) {
+        multiply(worlds[parent], locals[i], worlds[i]);
+        dirty[i] = 1;
+      }
+    }
+  }
+
+  static void affine_inverse(glm::fmat4 const* in, glm::fmat4* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      affine_inverse(in[i], out[i]);
+    }
+  }
+
+  static void normal_matrix(glm::fmat4 const& view, glm::fmat4 const* models, glm::fmat4* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      glm::fmat4 view_model;
+      multiply(view, models[i], view_model);
+      normal_matrix(view_model, out[i]);
+    }
+  }
+
+  // four spheres per iteration, same summation order as the scalar kernel
+  static void cull_spheres(glm::fvec4 const* planes, float const* x, float const* y, float const* z, float const* radius,
+                           unsigned char* visible, std::size_t count, std::size_t& visible_count) {
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      __m128 px = _mm_loadu_ps(x + i);
+      __m128 py = _mm_loadu_ps(y + i);
+      __m128 pz = _mm_loadu_ps(z + i);
+      __m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+      __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+      for (int p = 0; p < 6; ++p) {
+        __m128 distance = _mm_mul_ps(_mm_set1_ps(planes[p].x), px);
+        distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].y), py));
+        distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].z), pz));
+        distance = _mm_add_ps(distance, _mm_set1_ps(planes[p].w));
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negative_radius));
+      }
+      int mask = _mm_movemask_ps(inside);
+      for (int lane = 0; lane < 4; ++lane) {
+        visible[i + std::size_t(lane)] = (unsigned char)((mask >> lane) & 1);
+        visible_count += std::size_t((mask >> lane) & 1);
+      }
+    }
+    scalar::cull_spheres(planes, x + i, y + i, z + i, radius + i, visible + i, count - i, visible_count);
+  }
+}
+
+///////////////////////////// avx kernels /////////////////////////////////////
+namespace avx {
+  // two columns per register, every 128 bit lane is processed like in the sse kernel
+  SIMD_MATH_AVX_TARGET static inline __m256 broadcast(__m128 v) {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(v), v, 1);
+  }
+
+  // same column of two matrices in the lower and upper lane
+  SIMD_MATH_AVX_TARGET static inline __m256 load_pair(glm::fmat4 const& m0, glm::fmat4 const& m1, int column) {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&m0[column][0])), _mm_loadu_ps(&m1[column][0]), 1);
+  }
+
+  SIMD_MATH_AVX_TARGET static inline void store_pair(__m256 v, glm::fmat4& m0, glm::fmat4& m1, int column) {
+    _mm_storeu_ps(&m0[column][0], _mm256_castps256_ps128(v));
+    _mm_storeu_ps(&m1[column][0], _mm256_extractf128_ps(v, 1));
+  }
+
+  // computes columns (0, 1) and (2, 3) of the result in one register each
+  SIMD_MATH_AVX_TARGET static inline void multiply(glm::fmat4 const& a, glm::fmat4 const& b, glm::fmat4& out) {
+    __m256 a0 = broadcast(_mm_loadu_ps(&a[0][0]));
+    __m256 a1 = broadcast(_mm_loadu_ps(&a[1][0]));
+    __m256 a2 = broadcast(_mm_loadu_ps(&a[2][0]));
+    __m256 a3 = broadcast(_mm_loadu_ps(&a[3][0]));
+    for (int j = 0; j < 4; j += 2) {
+      __m256 bj = _mm256_loadu_ps(&b[j][0]);
+      __m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(bj, bj, 0x00));
+      r = _mm256_add_ps(r, _mm256_mul_ps(a1, _mm256_shuffle_ps(bj, bj, 0x55)));
+      r = _mm256_add_ps(r, _mm256_mul_ps(a2, _mm256_shuffle_ps(bj, bj, 0xAA)));
+      r = _mm256_add_ps(r, _mm256_mul_ps(a3, _mm256_shuffle_ps(bj, bj, 0xFF)));
+      _mm256_storeu_ps(&out[j][0], r);
+    }
+  }
+
+  SIMD_MATH_AVX_TARGET static inline __m256 cross(__m256 a, __m256 b) {
+    __m256 a_yzx = _mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m256 b_yzx = _mm256_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    __m256 c = _mm256_sub_ps(_mm256_mul_ps(a, b_yzx), _mm256_mul_ps(a_yzx, b));
+    return _mm256_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+  }
+
+  SIMD_MATH_AVX_TARGET static inline __m256 dot(__m256 a, __m256 b) {
+    __m256 p = _mm256_mul_ps(a, b);
+    __m256 s = _mm256_add_ps(p, _mm256_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm256_add_ps(s, _mm256_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+  }
+
+  // see scalar::inverse_rows, for two matrices at once
+  SIMD_MATH_AVX_TARGET static inline void inverse_rows(glm::fmat4 const& m0, glm::fmat4 const& m1, __m256& r0, __m256& r1, __m256& r2) {
+    __m256 xyz_mask = _mm256_castsi256_ps(_mm256_set_epi32(0, -1, -1, -1, 0, -1, -1, -1));
+    __m256 w_mask = _mm256_castsi256_ps(_mm256_set_epi32(-1, 0, 0, 0, -1, 0, 0, 0));
+    __m256 c0 = _mm256_and_ps(load_pair(m0, m1, 0), xyz_mask);
+    __m256 c1 = _mm256_and_ps(load_pair(m0, m1, 1), xyz_mask);
+    __m256 c2 = _mm256_and_ps(load_pair(m0, m1, 2), xyz_mask);
+    __m256 t = load_pair(m0, m1, 3);
+    r0 = cross(c1, c2);
+    r1 = cross(c2, c0);
+    r2 = cross(c0, c1);
+    __m256 inv_det = _mm256_div_ps(_mm256_set1_ps(1.0f), dot(c0, r0));
+    r0 = _mm256_mul_ps(r0, inv_det);
+    r1 = _mm256_mul_ps(r1, inv_det);
+    r2 = _mm256_mul_ps(r2, inv_det);
+    __m256 zero = _mm256_setzero_ps();
+    r0 = _mm256_add_ps(r0, _mm256_and_ps(w_mask, _mm256_sub_ps(zero, dot(r0, t))));
+    r1 = _mm256_add_ps(r1, _mm256_and_ps(w_mask, _mm256_sub_ps(zero, dot(r1, t))));
+    r2 = _mm256_add_ps(r2, _mm256_and_ps(w_mask, _mm256_sub_ps(zero, dot(r2, t))));
+  }
+
+  SIMD_MATH_AVX_TARGET static void multiply(glm::fmat4 const* lhs, glm::fmat4 const* rhs, glm::fmat4* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      multiply(lhs[i], rhs[i], out[i]);
+    }
+  }
+
+  SIMD_MATH_AVX_TARGET static void multiply(glm::fmat4 const& lhs, glm::fmat4 const* rhs, glm::fmat4* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+      multiply(lhs, rhs[i], out[i]);
+    }
+  }
+
+  SIMD_MATH_AVX_TARGET static void multiply_hierarchy(glm::fmat4 const* locals, int const* parents, unsigned char* dirty, glm::fmat4* worlds, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      int parent = parents[i];
+      if (parent < 0) {
+        if (dirty[i]) { worlds[i] = locals[i]; }
+      }
+      else if (dirty[i] || dirty[parent]) {
+        multiply(worlds[parent], locals[i], worlds[i]);
+        dirty[i] = 1;
+      }
+    }
+  }
+
+  SIMD_MATH_AVX_TARGET static void affine_inverse(glm::fmat4 const* in, glm::fmat4* out, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 1 < count; i += 2) {
+      __m256 r0, r1, r2;
+      inverse_rows(in[i], in[i + 1], r0, r1, r2);
+      __m256 r3 = _mm256_set_ps(1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+      // transpose 4x4 blocks in both lanes
+      __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+      __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+      __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+      __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+      store_pair(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), out[i], out[i + 1], 0);
+      store_pair(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)), out[i], out[i + 1], 1);
+      store_pair(_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), out[i], out[i + 1], 2);
+      store_pair(_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)), out[i], out[i + 1], 3);
+    }
+    if (i < count) { sse::affine_inverse(in[i], out[i]); }
+  }
+
+  SIMD_MATH_AVX_TARGET static void normal_matrix(glm::fmat4 const& view, glm::fmat4 const* models, glm::fmat4* out, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 1 < count; i += 2) {
+      glm::fmat4 view_model[2];
+      multiply(view, models[i], view_model[0]);
+      multiply(view, models[i + 1], view_model[1]);
+      __m256 r0, r1, r2;
+      inverse_rows(view_model[0], view_model[1], r0, r1, r2);
+      store_pair(r0, out[i], out[i + 1], 0);
+      store_pair(r1, out[i], out[i + 1], 1);
+      store_pair(r2, out[i], out[i + 1], 2);
+      store_pair(_mm256_set_ps(1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f), out[i], out[i + 1], 3);
+    }
+    if (i < count) {
+      glm::fmat4 view_model;
+      multiply(view, models[i], view_model);
+      sse::normal_matrix(view_model, out[i]);
+    }
+  }
+
+  // eight spheres per iteration, ordered compare so that NaN positions count as outside like in the scalar kernel
+  SIMD_MATH_AVX_TARGET static void cull_spheres(glm::fvec4 const* planes, float const* x, float const* y, float const* z, float const* radius,
+                                                unsigned char* visible, std::size_t count, std::size_t& visible_count) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      __m256 px = _mm256_loadu_ps(x + i);
+      __m256 py = _mm256_loadu_ps(y + i);
+      __m256 pz = _mm256_loadu_ps(z + i);
+      __m256 negative_radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+      __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+      for (int p = 0; p < 6; ++p) {
+        __m256 distance = _mm256_mul_ps(_mm256_set1_ps(planes[p].x), px);
+        distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[p].y), py));
+        distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[p].z), pz));
+        distance = _mm256_add_ps(distance, _mm256_set1_ps(planes[p].w));
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negative_radius, _CMP_GE_OQ));
+      }
+      int mask = _mm256_movemask_ps(inside);
+      for (int lane = 0; lane < 8; ++lane) {
+        visible[i + std::size_t(lane)] = (unsigned char)((mask >> lane) & 1);
+        visible_count += std::size_t((mask >> lane) & 1);
+      }
+    }
+    sse::cull_spheres(planes, x + i, y + i, z + i, radius + i, visible + i, count - i, visible_count);
+  }
+}
+#endif
+
+///////////////////////////// dispatch ////////////////////////////////////////
+static instruction_set& active_set() {
+  static instruction_set set = detect();
+  return set;
+}
+
+instruction_set detect() {
+#if defined(SIMD_MATH_X86) && defined(_MSC_VER)
+  // avx needs cpu support and os support for saving ymm registers
+  int info[4];
+  __cpuid(info, 1);
+  bool has_avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+  return has_avx ? instruction_set::avx : instruction_set::sse;
+#elif defined(SIMD_MATH_X86)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx") ? instruction_set::avx : instruction_set::sse;
+#else
+  return instruction_set::scalar;
+#endif
+}
+
+instruction_set active() {
+  return active_set();
+}
+
+void force(instruction_set set) {
+  active_set() = int(set) <= int(detect()) ? set : detect();
+}
+
+char const* name(instruction_set set) {
+  switch (set) {
+    case instruction_set::avx: return "avx";
+    case instruction_set::sse: return "sse";
+    default: return "scalar";
+  }
+}
+
+#ifdef SIMD_MATH_X86
+  #define SIMD_MATH_DISPATCH(function, ...) \
+    switch (active_set()) { \
+      case instruction_set::avx: avx::function(__VA_ARGS__); break; \
+      case instruction_set::sse: sse::function(__VA_ARGS__); break; \
+      default: scalar::function(__VA_ARGS__); break; \
+    }
+#else
+  #define SIMD_MATH_DISPATCH(function, ...) scalar::function(__VA_ARGS__);
+#endif
+
+void multiply(glm::fmat4 const* lhs, glm::fmat4 const* rhs, glm::fmat4* out, std::size_t count) {
+  SIMD_MATH_DISPATCH(multiply, lhs, rhs, out, count)
+}
+
+void multiply(glm::fmat4 const& lhs, glm::fmat4 const* rhs, glm::fmat4* out, std::size_t count) {
+  SIMD_MATH_DISPATCH(multiply, lhs, rhs, out, count)
+}
+
+void multiply_hierarchy(glm::fmat4 const* locals, int const* parents, unsigned char* dirty, glm::fmat4* worlds, std::size_t begin, std::size_t end) {
+  SIMD_MATH_DISPATCH(multiply_hierarchy, locals, parents, dirty, worlds, begin, end)
+}
+
+void affine_inverse(glm::fmat4 const* in, glm::fmat4* out, std::size_t count) {
+  SIMD_MATH_DISPATCH(affine_inverse, in, out, count)
+}
+
+void normal_matrix(glm::fmat4 const& view, glm::fmat4 const* models, glm::fmat4* out, std::size_t count) {
+  SIMD_MATH_DISPATCH(normal_matrix, view, models, out, count)
+}
+
+void frustum_planes(glm::fmat4 const& view_projection, glm::fvec4 planes[6]) {
+  // Gribb/Hartmann: the planes are sums and differences of the matrix rows, glm stores columns
+  glm::fvec4 rows[4];
+  for (int r = 0; r < 4; ++r) {
+    rows[r] = glm::fvec4{view_projection[0][r], view_projection[1][r], view_projection[2][r], view_projection[3][r]};
+  }
+  for (int axis = 0; axis < 3; ++axis) {
+    planes[axis * 2] = rows[3] + rows[axis];
+    planes[axis * 2 + 1] = rows[3] - rows[axis];
+  }
+  for (int p = 0; p < 6; ++p) {
+    float length = glm::length(glm::fvec3{planes[p]});
+    planes[p] = length > 0.0f ? planes[p] / length : planes[p];
+  }
+}
+
+std::size_t cull_spheres(glm::fvec4 const planes[6], float const* x, float const* y, float const* z, float const* radius,
+                         unsigned char* visible, std::size_t count) {
+  std::size_t visible_count = 0;
+  SIMD_MATH_DISPATCH(cull_spheres, planes, x, y, z, radius, visible, count, visible_count)
+  return visible_count;
+}
+
+}
@@ -1,4 +1,5 @@
 #include "texture_loader.hpp"
+#include "Profiler.hpp"
 
 // request supported types
 #define STBI_ONLY_JPEG
@@ -13,10 +14,12 @@
  
 #include <cstdint> 
 #include <cstring> 
+#include <algorithm> 
 #include <stdexcept> 
 
 namespace texture_loader {
 pixel_data file(std::string const& file_name) {
+  PROFILE_SCOPE("Load texture");
   // match to opengl representation
   stbi_set_flip_vertically_on_load(true);
 
@@ -61,4 +64,44 @@ pixel_data file(std::string const& file_name) {
   return pixel_data{texture_data, pixel_format, GL_UNSIGNED_BYTE, std::size_t(width), std::size_t(height)};
 }
 
-}
\ No newline at end of file
+pixel_data resize_rgba(pixel_data const& image, std::size_t width, std::size_t height) {
+  if (image.channel_type != GL_UNSIGNED_BYTE) {
+    throw std::logic_error("resize_rgba: only 8 bit channels are supported");
+  }
+  std::size_t num_components = 0;
+  if (image.channels == GL_RED) num_components = 1;
+  else if (image.channels == GL_RG) num_components = 2;
+  else if (image.channels == GL_RGB) num_components = 3;
+  else if (image.channels == GL_RGBA) num_components = 4;
+  else throw std::logic_error("resize_rgba: unsupported channel format");
+
+  std::vector<uint8_t> texture_data(width * height * 4);
+  for (std::size_t y = 0; y < height; ++y) {
+    // sample at texel centers, clamped to the edge like GL_CLAMP_TO_EDGE
+    float source_y = std::min(std::max((float(y) + 0.5f) * float(image.height) / float(height) - 0.5f, 0.0f), float(image.height - 1));
+    std::size_t y0 = std::size_t(source_y);
+    std::size_t y1 = std::min(y0 + 1, image.height - 1);
+    float weight_y = source_y - float(y0);
+    for (std::size_t x = 0; x < width; ++x) {
+      float source_x = std::min(std::max((float(x) + 0.5f) * float(image.width) / float(width) - 0.5f, 0.0f), float(image.width - 1));
+      std::size_t x0 = std::size_t(source_x);
+      std::size_t x1 = std::min(x0 + 1, image.width - 1);
+      float weight_x = source_x - float(x0);
+      uint8_t* texel = &texture_data[(y * width + x) * 4];
+      for (std::size_t c = 0; c < 4; ++c) {
+        if (c >= num_components) {
+          texel[c] = c == 3 ? 255 : 0;
+          continue;
+        }
+        float top = float(image.pixels[(y0 * image.width + x0) * num_components + c]) * (1.0f - weight_x)
+                  + float(image.pixels[(y0 * image.width + x1) * num_components + c]) * weight_x;
+        float bottom = float(image.pixels[(y1 * image.width + x0) * num_components + c]) * (1.0f - weight_x)
+                     + float(image.pixels[(y1 * image.width + x1) * num_components + c]) * weight_x;
+        texel[c] = uint8_t(top * (1.0f - weight_y) + bottom * weight_y + 0.5f);
+      }
+    }
+  }
+  return pixel_data{texture_data, GL_RGBA, GL_UNSIGNED_BYTE, width, height};
+}
+
+}
@@ -10,6 +10,9 @@ using namespace gl;
 #include <glm/gtc/type_precision.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -93,6 +96,20 @@ namespace utils {
       return array;
     }
 
+    bool has_gl_support(int major, int minor, char const* extension) {
+      GLint context_major = 0, context_minor = 0;
+      glGetIntegerv(GL_MAJOR_VERSION, &context_major);
+      glGetIntegerv(GL_MINOR_VERSION, &context_minor);
+      if (context_major > major || (context_major == major && context_minor >= minor)) { return true; }
+      GLint extension_count = 0;
+      glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+      for (GLint i = 0; i < extension_count; ++i) {
+        char const* name = reinterpret_cast<char const*>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+        if (name && std::strcmp(name, extension) == 0) { return true; }
+      }
+      return false;
+    }
+
     std::string file_name(std::string const& file_path) {
       return file_path.substr(file_path.find_last_of("/\\") + 1);
     }
@@ -120,12 +137,14 @@ namespace utils {
 
     std::string read_resource_path(int argc, char* argv[]) {
       std::string resource_path{};
-      //first argument is resource path
-      if (argc > 1) {
-        resource_path = argv[1];
+      //first argument which is no option is resource path
+      for (int i = 1; i < argc && resource_path.empty(); ++i) {
+        if (std::string{argv[i]}.compare(0, 2, "--") != 0) {
+          resource_path = argv[i];
+        }
       }
       // no resource path specified, use default
-      else {
+      if (resource_path.empty()) {
         std::string exe_path{argv[0]};
         resource_path = exe_path.substr(0, exe_path.find_last_of("/\\"));
         resource_path += "/../../resources/";
@@ -134,6 +153,53 @@ namespace utils {
       return resource_path;
     }
 
+    run_options read_run_options(int argc, char* argv[]) {
+      run_options options{};
+      for (int i = 1; i < argc; ++i) {
+        std::string argument{argv[i]};
+        if (argument.compare(0, 2, "--") != 0) {
+          continue;
+        }
+        std::size_t separator = argument.find('=');
+        std::string name = argument.substr(2, separator == std::string::npos ? std::string::npos : separator - 2);
+        std::string value = separator == std::string::npos ? std::string{} : argument.substr(separator + 1);
+        bool is_valid = true;
+        if (name == "headless" && value.empty()) {
+          options.headless = true;
+        }
+        else if (name == "frames") {
+          is_valid = std::sscanf(value.c_str(), "%u", &options.frames) == 1;
+        }
+        else if (name == "timestep") {
+          is_valid = std::sscanf(value.c_str(), "%lf", &options.timestep) == 1 && options.timestep >= 0.0;
+        }
+        else if (name == "size") {
+          is_valid = std::sscanf(value.c_str(), "%ux%u", &options.resolution.x, &options.resolution.y) == 2
+                     && options.resolution.x > 0 && options.resolution.y > 0;
+        }
+        else if (name == "trace") {
+          options.trace_path = value;
+          is_valid = !value.empty();
+        }
+        else {
+          is_valid = false;
+        }
+        if (!is_valid) {
+          std::cerr << "Invalid option " << argument << "\n"
+                    << "usage: " << argv[0] << " [resource path] [--headless] [--frames=N] [--timestep=S] [--size=WxH] [--trace=FILE]" << std::endl;
+          std::exit(EXIT_FAILURE);
+        }
+      }
+      // without glfw there is no real time, headless runs are reproducible anyway
+      if (options.headless && options.frames == 0) {
+        options.frames = 300;
+      }
+      if (options.headless && options.timestep == 0.0) {
+        options.timestep = 1.0 / 60.0;
+      }
+      return options;
+    }
+
     glm::fmat4 calculate_projection_matrix(float aspect) {
       // float aspect = float(width) / float(height);
       // base fov does not change
@@ -0,0 +1,150 @@
+#include "vertex_packing.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace vertex_packing {
+
+// -1 for negative values, 1 otherwise, so points on the fold keep their side
+static float sign_not_zero(float value) {
+  return value < 0.0f ? -1.0f : 1.0f;
+}
+
+glm::i16vec2 octahedral(glm::fvec3 const& normal) {
+  float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+  if (length == 0.0f) {
+    return glm::i16vec2{0};
+  }
+  glm::fvec2 projected{normal.x / length, normal.y / length};
+  if (normal.z < 0.0f) {
+    projected = glm::fvec2{(1.0f - std::abs(projected.y)) * sign_not_zero(projected.x),
+                           (1.0f - std::abs(projected.x)) * sign_not_zero(projected.y)};
+  }
+  return glm::i16vec2{snorm16(projected.x), snorm16(projected.y)};
+}
+
+glm::fvec3 from_octahedral(glm::fvec2 const& encoded) {
+  glm::fvec3 normal{encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y)};
+  if (normal.z < 0.0f) {
+    normal.x = (1.0f - std::abs(encoded.y)) * sign_not_zero(encoded.x);
+    normal.y = (1.0f - std::abs(encoded.x)) * sign_not_zero(encoded.y);
+  }
+  return glm::normalize(normal);
+}
+
+std::uint16_t unorm16(float value) {
+  return std::uint16_t(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+std::int16_t snorm16(float value) {
+  return std::int16_t(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+}
+
+std::uint16_t half_float(float value) {
+  std::uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  std::uint32_t sign = (bits >> 16) & 0x8000u;
+  std::uint32_t magnitude = bits & 0x7fffffffu;
+  if (magnitude >= 0x7f800000u) {
+    // infinity stays infinity, NaN stays NaN
+    return std::uint16_t(sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x200u : 0u));
+  }
+  if (magnitude >= 0x477ff000u) {
+    // 65520 and above round to infinity
+    return std::uint16_t(sign | 0x7c00u);
+  }
+  if (magnitude < 0x38800000u) {
+    // below the smallest normal half, a multiple of 2^-24. The scaling is exact, the rounding is to nearest even
+    float absolute;
+    std::memcpy(&absolute, &magnitude, sizeof(absolute));
+    return std::uint16_t(sign | std::uint32_t(std::nearbyint(absolute * 16777216.0f)));
+  }
+  // exponent bias 127 to 15, 23 to 10 mantissa bits, a carry into the exponent is correct
+  std::uint32_t half = (magnitude - 0x38000000u) >> 13;
+  std::uint32_t rest = magnitude & 0x1fffu;
+  if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+    ++half;
+  }
+  return std::uint16_t(sign | half);
+}
+
+float from_half_float(std::uint16_t half) {
+  std::uint32_t sign = std::uint32_t(half & 0x8000u) << 16;
+  std::uint32_t exponent = (half >> 10) & 0x1fu;
+  std::uint32_t mantissa = half & 0x3ffu;
+  if (exponent == 0) {
+    float value = std::ldexp(float(mantissa), -24);
+    return sign ? -value : value;
+  }
+  std::uint32_t bits = sign | (exponent == 31 ? 0x7f800000u : (exponent + 112) << 23) | (mantissa << 13);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+std::uint32_t snorm_10_10_10_2(glm::fvec4 const& value) {
+  auto quantize = [](float component, float scale, std::uint32_t mask) {
+    return std::uint32_t(std::lround(std::min(std::max(component, -1.0f), 1.0f) * scale)) & mask;
+  };
+  return quantize(value.x, 511.0f, 0x3ffu) | quantize(value.y, 511.0f, 0x3ffu) << 10
+       | quantize(value.z, 511.0f, 0x3ffu) << 20 | quantize(value.w, 1.0f, 0x3u) << 30;
+}
+
+glm::fvec4 read(void const* vertex, model::attribute const& format) {
+  unsigned char const* bytes = static_cast<unsigned char const*>(vertex) + uintptr_t(format.offset);
+  glm::fvec4 result{0.0f, 0.0f, 0.0f, 1.0f};
+  GLint components = std::min(format.components, 4);
+  if (format.type == GL_FLOAT) {
+    std::memcpy(&result[0], bytes, sizeof(float) * std::size_t(components));
+  }
+  else if (format.type == GL_HALF_FLOAT || format.type == GL_UNSIGNED_SHORT) {
+    std::uint16_t values[4];
+    std::memcpy(values, bytes, sizeof(std::uint16_t) * std::size_t(components));
+    for (GLint i = 0; i < components; ++i) {
+      if (format.type == GL_HALF_FLOAT) {
+        result[i] = from_half_float(values[i]);
+      }
+      else {
+        result[i] = format.normalized == GL_TRUE ? float(values[i]) / 65535.0f : float(values[i]);
+      }
+    }
+  }
+  else if (format.type == GL_SHORT) {
+    std::int16_t values[4];
+    std::memcpy(values, bytes, sizeof(std::int16_t) * std::size_t(components));
+    for (GLint i = 0; i < components; ++i) {
+      result[i] = format.normalized == GL_TRUE ? std::max(float(values[i]) / 32767.0f, -1.0f) : float(values[i]);
+    }
+  }
+  else if (format.type == GL_INT_2_10_10_10_REV) {
+    std::uint32_t bits;
+    std::memcpy(&bits, bytes, sizeof(bits));
+    // sign extended by the arithmetic shift back
+    std::int32_t values[4] = {std::int32_t(bits << 22) >> 22, std::int32_t(bits << 12) >> 22, std::int32_t(bits << 2) >> 22, std::int32_t(bits) >> 30};
+    for (GLint i = 0; i < 4; ++i) {
+      float scale = i < 3 ? 511.0f : 1.0f;
+      result[i] = format.normalized == GL_TRUE ? std::max(float(values[i]) / scale, -1.0f) : float(values[i]);
+    }
+  }
+  if (format.flag == model::NORMAL.flag && format.components == 2) {
+    return glm::fvec4{from_octahedral(glm::fvec2{result.x, result.y}), 0.0f};
+  }
+  return result;
+}
+
+std::vector<model::attribute> formats(model const& mesh) {
+  std::vector<model::attribute> result;
+  for (auto const& attribute : model::VERTEX_ATTRIBS) {
+    auto offset = mesh.offsets.find(attribute);
+    if (offset != mesh.offsets.end()) {
+      result.push_back(attribute);
+      result.back().offset = offset->second;
+    }
+  }
+  return result;
+}
+
+}
@@ -19,6 +19,7 @@
 #include "shader_loader.hpp"
 
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <iostream>
 
@@ -26,6 +27,19 @@
 // use gl definitions from glbinding 
 using namespace gl;
 
+#ifdef WITH_EGL
+// only the platform independent EGL types, no X11 headers and their macros
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// build default of the validation level, set by cmake from GL_VALIDATION and the build type
+#ifndef GL_VALIDATION_LEVEL
+#define GL_VALIDATION_LEVEL full
+#endif
+
 // helper functions
 static void glsl_error(int error, const char* description);
 static void watch_gl_errors(bool activate = true);
@@ -41,6 +55,8 @@ static void APIENTRY openglCallbackFunction(
 
 namespace window_handler {
 
+static validation_level current_validation_level = validation_level::none;
+
 bool isCore()
 {
     // if (version<glbinding::Version(3,2))
@@ -66,8 +82,9 @@ GLFWwindow* initialize(glm::uvec2 const& resolution, unsigned ver_major, unsigne
   // set OGL version explicitly 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, ver_major);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, ver_minor);
-  // enable deug support
-  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+  // enable debug support, drivers may run debug contexts slower, so only when errors are checked
+  validation_level level = default_validation_level();
+  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, level != validation_level::none);
 
   //MacOS requires forward compat core profile
   #ifdef __APPLE__
@@ -102,19 +119,67 @@ GLFWwindow* initialize(glm::uvec2 const& resolution, unsigned ver_major, unsigne
   else {
     std::cout << " compat" << std::endl;
   }
-  // activate error checking after each gl function call
-  watch_gl_errors();
-
-  // Enable the debug callback
-  glEnable(GL_DEBUG_OUTPUT);
-  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-  glDebugMessageCallback(openglCallbackFunction, nullptr);
-  glDebugMessageControl(
-    GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, true
-  );
+  // activate debug messages and error checking after each gl function call, depending on the level
+  set_validation_level(level);
+  std::cout << "GL validation: " << to_string(level) << std::endl;
 
   return window;
 }
+
+validation_level default_validation_level() {
+  char const* name = std::getenv("GL_VALIDATION");
+  if (name) {
+    for (validation_level level : {validation_level::none, validation_level::debug_output, validation_level::full}) {
+      if (std::strcmp(name, to_string(level)) == 0) {
+        return level;
+      }
+    }
+    std::cerr << "Unknown GL_VALIDATION " << name << ", expected none, debug_output or full" << std::endl;
+  }
+  return validation_level::GL_VALIDATION_LEVEL;
+}
+
+void set_validation_level(validation_level level) {
+  // remove the per call callback first, so switching does not check the calls below
+  watch_gl_errors(false);
+  // contexts without KHR_debug do not resolve the function
+  if (glbinding::Binding::DebugMessageCallback.isResolved()) {
+    if (level == validation_level::none) {
+      glDisable(GL_DEBUG_OUTPUT);
+    }
+    else {
+      glEnable(GL_DEBUG_OUTPUT);
+      // synchronous messages are reported inside the failing call, so a breakpoint shows the caller
+      if (level == validation_level::full) {
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+      }
+      else {
+        glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+      }
+      glDebugMessageCallback(openglCallbackFunction, nullptr);
+      glDebugMessageControl(
+        GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, true
+      );
+    }
+  }
+  if (level == validation_level::full) {
+    watch_gl_errors(true);
+  }
+  current_validation_level = level;
+}
+
+validation_level get_validation_level() {
+  return current_validation_level;
+}
+
+char const* to_string(validation_level level) {
+  switch (level) {
+    case validation_level::none: return "none";
+    case validation_level::debug_output: return "debug_output";
+    case validation_level::full: return "full";
+  }
+  return "";
+}
  
 void set_callback_object(GLFWwindow* window, Application* app) {
   // set user pointer to access this instance statically
@@ -157,6 +222,93 @@ void show_fps(GLFWwindow* window) {
   }
 }
 
+struct headless_context {
+#ifdef WITH_EGL
+  EGLDisplay display = EGL_NO_DISPLAY;
+  EGLSurface surface = EGL_NO_SURFACE;
+  EGLContext context = EGL_NO_CONTEXT;
+#endif
+};
+
+headless_context* initialize_headless(glm::uvec2 const& resolution, unsigned ver_major, unsigned ver_minor) {
+#ifdef WITH_EGL
+  headless_context* headless = new headless_context{};
+  // prefer Mesa's surfaceless platform, it needs neither X nor a gpu
+  char const* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (client_extensions && std::strstr(client_extensions, "EGL_MESA_platform_surfaceless") && get_platform_display) {
+    headless->display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+  }
+  if (headless->display == EGL_NO_DISPLAY) {
+    headless->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+  EGLint egl_major = 0;
+  EGLint egl_minor = 0;
+  if (headless->display == EGL_NO_DISPLAY || !eglInitialize(headless->display, &egl_major, &egl_minor)) {
+    std::cerr << "Could not initialize an EGL display" << std::endl;
+    delete headless;
+    return nullptr;
+  }
+
+  validation_level level = default_validation_level();
+  EGLint const config_attributes[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8, EGL_DEPTH_SIZE, 24, EGL_NONE
+  };
+  EGLint const surface_attributes[] = { EGL_WIDTH, EGLint(resolution.x), EGL_HEIGHT, EGLint(resolution.y), EGL_NONE };
+  // same version and profile as the window, a debug context only when errors are checked
+  EGLint const context_attributes[] = {
+    EGL_CONTEXT_MAJOR_VERSION_KHR, EGLint(ver_major), EGL_CONTEXT_MINOR_VERSION_KHR, EGLint(ver_minor),
+    EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, ver_major > 2 ? EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR : EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT_KHR,
+    EGL_CONTEXT_FLAGS_KHR, level != validation_level::none ? EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR : 0, EGL_NONE
+  };
+  EGLConfig config = nullptr;
+  EGLint config_count = 0;
+  bool is_created = eglChooseConfig(headless->display, config_attributes, &config, 1, &config_count) && config_count > 0
+                    && eglBindAPI(EGL_OPENGL_API);
+  if (is_created) {
+    headless->surface = eglCreatePbufferSurface(headless->display, config, surface_attributes);
+    headless->context = eglCreateContext(headless->display, config, EGL_NO_CONTEXT, context_attributes);
+    is_created = headless->surface != EGL_NO_SURFACE && headless->context != EGL_NO_CONTEXT
+                 && eglMakeCurrent(headless->display, headless->surface, headless->surface, headless->context);
+  }
+  if (!is_created) {
+    std::cerr << "Could not create an OpenGL " << ver_major << "." << ver_minor << " context on an EGL pbuffer, error 0x"
+              << std::hex << eglGetError() << std::dec << std::endl;
+    close_headless(headless);
+    return nullptr;
+  }
+  // glbinding finds the current context through glx, which does not know EGL contexts
+  glbinding::Binding::initialize(reinterpret_cast<glbinding::ContextHandle>(headless->context));
+
+  std::cout << "Created headless OpenGL context with version " << glGetString(GL_VERSION) << " on EGL " << egl_major << "." << egl_minor << std::endl;
+  set_validation_level(level);
+  std::cout << "GL validation: " << to_string(level) << std::endl;
+  return headless;
+#else
+  (void)resolution; (void)ver_major; (void)ver_minor;
+  std::cerr << "Headless mode needs EGL, the framework was built without it" << std::endl;
+  return nullptr;
+#endif
+}
+
+void close_headless(headless_context* headless) {
+#ifdef WITH_EGL
+  if (headless->context != EGL_NO_CONTEXT) {
+    glbinding::Binding::releaseContext(reinterpret_cast<glbinding::ContextHandle>(headless->context));
+  }
+  eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (headless->context != EGL_NO_CONTEXT) {
+    eglDestroyContext(headless->display, headless->context);
+  }
+  if (headless->surface != EGL_NO_SURFACE) {
+    eglDestroySurface(headless->display, headless->surface);
+  }
+  eglTerminate(headless->display);
+#endif
+  delete headless;
+}
+
 void close_and_quit(GLFWwindow* window, int status) {
   // free glfw resources
   glfwDestroyWindow(window);
@@ -225,6 +377,7 @@ static void watch_gl_errors(bool activate) {
     );
   }
   else {
+    // calls go straight to the driver, without collecting parameters or checking glGetError
     glbinding::setCallbackMask(glbinding::CallbackMask::None);
   }
 }
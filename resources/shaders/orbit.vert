@@ -3,11 +3,19 @@
 // glVertexAttribPointer mapped positions to first
 layout(location = 0) in vec3 in_Position;
 
+// per frame data shared by all programs, bound to uniform buffer binding point 0 (FRAME_DATA_BINDING)
+layout(std140) uniform FrameData {
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    vec3 CameraPosition;
+    vec3 LightPosition;
+    vec3 LightColor;     // color * intensity
+    vec3 AmbientColor;
+};
+
 //Matrix Uniforms uploaded with glUniform*
 uniform mat4 NormalMatrix;
 uniform mat4 ModelMatrix;
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
 
 void main() {
 	gl_Position = (ProjectionMatrix  * ViewMatrix * ModelMatrix) * vec4(in_Position, 1.0);
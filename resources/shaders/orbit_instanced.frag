@@ -0,0 +1,7 @@
+#version 150
+
+out vec4 out_Color;
+
+void main() {
+  out_Color = vec4(0.0f, 0.88f, 1.0f, 1.0f);
+}
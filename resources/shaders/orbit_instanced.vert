@@ -0,0 +1,21 @@
+#version 150
+#extension GL_ARB_explicit_attrib_location : require
+// vertex attributes of the geometry arena's VAO
+layout(location = 0) in vec3 in_Position;
+// per draw attribute from the instance buffer, each draw of a multi draw call reads its own record
+layout(location = 3) in mat4 in_ModelMatrix; // locations 3-6
+
+// per frame data shared by all programs, bound to uniform buffer binding point 0 (FRAME_DATA_BINDING)
+layout(std140) uniform FrameData {
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    vec3 CameraPosition;
+    vec3 LightPosition;
+    vec3 LightColor;     // color * intensity
+    vec3 AmbientColor;
+};
+
+// Same as orbit.vert, but the model matrix comes from the instance buffer
+void main() {
+	gl_Position = (ProjectionMatrix  * ViewMatrix * in_ModelMatrix) * vec4(in_Position, 1.0);
+}
@@ -3,7 +3,7 @@
 
 // Not going to include fancy matrix transformations since we'll be supplying the vertex coordinates as normalized device coordinates
 layout(location = 0) in vec2 in_position;
-layout(location = 1) in vec2 in_texture_coordinate;
+layout(location = 2) in vec2 in_texture_coordinate; // location of the texture coordinates in the geometry arena
 out vec2 texture_coordinate;
 
 void main() {
@@ -5,14 +5,20 @@ const int SpecularShinessSize = 16;
 const float SpecularStrength = 0.5f;
 const vec4 OutlineColor = vec4(0.0f, 0.88f, 1.0f, 1.0f);
 
-uniform vec3 LightColor;
-uniform vec3 LightPosition;
-uniform vec3 AmbientColor;
+// per frame data shared by all programs, bound to uniform buffer binding point 0 (FRAME_DATA_BINDING)
+layout(std140) uniform FrameData {
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    vec3 CameraPosition;
+    vec3 LightPosition;
+    vec3 LightColor;     // color * intensity
+    vec3 AmbientColor;
+};
 uniform float AmbientStrength;
 //uniform vec3 GeometryColor;
-uniform vec3 CameraPosition;
 uniform bool EnableToonShading;
-uniform sampler2D Texture;
+uniform sampler2DArray Texture;
+uniform float TextureLayer; // planet textures are layers of one array texture
 
 in vec3 normal_vector;
 in vec3 fragment_position;
@@ -52,6 +58,6 @@ void main() {
     }
 
     // 5. Blend fragment color
-    vec3 result = (ambientLight + diffuseLight + specularLight) * vec3(texture(Texture, texture_coordinate));
+    vec3 result = (ambientLight + diffuseLight + specularLight) * vec3(texture(Texture, vec3(texture_coordinate, TextureLayer)));
     out_Color = vec4(result, 1.0);
 }
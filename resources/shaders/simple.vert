@@ -3,24 +3,42 @@
 
 // vertex attributes of VAO
 layout(location = 0) in vec3 in_Position;
-layout(location = 1) in vec3 in_Normal;
+layout(location = 1) in vec2 in_Normal;  // octahedral encoding, 2 x snorm16
 layout(location = 2) in vec2 in_TextureCoordinate;
 
+// per frame data shared by all programs, bound to uniform buffer binding point 0 (FRAME_DATA_BINDING)
+layout(std140) uniform FrameData {
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    vec3 CameraPosition;
+    vec3 LightPosition;
+    vec3 LightColor;     // color * intensity
+    vec3 AmbientColor;
+};
+
 //Matrix Uniforms as specified with glUniformMatrix4fv
 uniform mat4 ModelMatrix;
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
 uniform mat4 NormalMatrix;
 
 out vec3 normal_vector;
 out vec3 fragment_position;
 out vec2 texture_coordinate;
 
+// unit normal of its octahedral encoding, the lower half of the octahedron is folded over the upper one
+vec3 octahedralNormal(vec2 encoded)
+{
+	vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	if (normal.z < 0.0) {
+		normal.xy = (1.0 - abs(encoded.yx)) * vec2(encoded.x < 0.0 ? -1.0 : 1.0, encoded.y < 0.0 ? -1.0 : 1.0);
+	}
+	return normalize(normal);
+}
+
 // https://learnopengl.com/Lighting/Basic-Lighting
 void main(void)
 {
 	gl_Position = (ProjectionMatrix  * ViewMatrix * ModelMatrix) * vec4(in_Position, 1.0);
 	fragment_position = vec3(ModelMatrix * vec4(in_Position, 1.0)); 					// Generate actual fragment position in to world space
-	normal_vector = vec3(inverse(transpose(ModelMatrix)) * vec4(in_Normal, 1.0)); 			// Generate the normal vector by using the inverse and transpos
+	normal_vector = vec3(inverse(transpose(ModelMatrix)) * vec4(octahedralNormal(in_Normal), 1.0)); 			// Generate the normal vector by using the inverse and transpos
 	texture_coordinate = in_TextureCoordinate;
 }
@@ -0,0 +1,49 @@
+#version 150
+#extension GL_ARB_explicit_attrib_location : require
+
+// vertex attributes of VAO
+layout(location = 0) in vec3 in_Position;
+layout(location = 1) in vec2 in_Normal;  // octahedral encoding, 2 x snorm16
+layout(location = 2) in vec2 in_TextureCoordinate;
+// per instance attributes, they advance once per instance
+layout(location = 3) in mat4 in_ModelMatrix;   // locations 3-6
+layout(location = 7) in mat3 in_NormalMatrix;  // locations 7-9, inverse transpose of the model matrix
+layout(location = 10) in vec2 in_Material;     // x: texture layer, y: ambient strength
+
+// per frame data shared by all programs, bound to uniform buffer binding point 0 (FRAME_DATA_BINDING)
+layout(std140) uniform FrameData {
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    vec3 CameraPosition;
+    vec3 LightPosition;
+    vec3 LightColor;     // color * intensity
+    vec3 AmbientColor;
+};
+
+out vec3 normal_vector;
+out vec3 fragment_position;
+out vec2 texture_coordinate;
+flat out float texture_layer;
+flat out float ambient_strength;
+
+// unit normal of its octahedral encoding, the lower half of the octahedron is folded over the upper one
+vec3 octahedralNormal(vec2 encoded)
+{
+	vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	if (normal.z < 0.0) {
+		normal.xy = (1.0 - abs(encoded.yx)) * vec2(encoded.x < 0.0 ? -1.0 : 1.0, encoded.y < 0.0 ? -1.0 : 1.0);
+	}
+	return normalize(normal);
+}
+
+// Same as simple.vert, but model and normal matrix come from the instance buffer
+void main(void)
+{
+	vec4 worldPosition = in_ModelMatrix * vec4(in_Position, 1.0);
+	gl_Position = (ProjectionMatrix * ViewMatrix) * worldPosition;
+	fragment_position = vec3(worldPosition); 					// Generate actual fragment position in to world space
+	normal_vector = in_NormalMatrix * octahedralNormal(in_Normal); 					// Normal matrix is computed on the cpu once per instance instead of per vertex
+	texture_coordinate = in_TextureCoordinate;
+	texture_layer = in_Material.x;
+	ambient_strength = in_Material.y;
+}
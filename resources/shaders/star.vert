@@ -0,0 +1,28 @@
+#version 150
+#extension GL_ARB_explicit_attrib_location : require
+// vertex attributes of the geometry arena's vertex array
+layout(location = 0) in vec3 in_Position;
+// color of the star in place of normal and texture coordinates, see application_solar
+layout(location = 1) in vec2 in_Color;             // red and green
+layout(location = 2) in vec2 in_TextureCoordinate; // blue in s
+
+// per frame data shared by all programs, bound to uniform buffer binding point 0 (FRAME_DATA_BINDING)
+layout(std140) uniform FrameData {
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    vec3 CameraPosition;
+    vec3 LightPosition;
+    vec3 LightColor;     // color * intensity
+    vec3 AmbientColor;
+};
+
+//Matrix Uniforms uploaded with glUniform*
+uniform mat4 NormalMatrix;
+uniform mat4 ModelMatrix;
+
+out vec3 pass_Color;
+
+void main() {
+	gl_Position = (ProjectionMatrix  * ViewMatrix * ModelMatrix) * vec4(in_Position, 1.0);
+	pass_Color = vec3(in_Color, in_TextureCoordinate.s);
+}